@@ -9,8 +9,9 @@
  * 
  * FUNCTION NAME(S)
  * ----------------
- * writeArchive - create ring buffers and write new sample
- * readArchive  - print sample for a given time to screen
+ * writeArchive - add the current M2 position to the position history
+ * readArchive  - latest history entry at or before a given time
+ * archiveInterpolate - history interpolated to a given time
  * CADlog   - read logging parameters from the engineering screens
  * cadDirLog    - log the time of all CAD directives
  * 
@@ -37,6 +38,9 @@
  * 07-May-1999: Added RCS id
  * 06-OCT-2017: Started conversion to EPICS OSI (mdw)
  * 05-Dec-2017: Removed the error logging support functions (mdw)
+ * 17-Oct-2026: Position history rebuilt as a lock-free power of two ring
+ *              fed by scsReceive, searched by bisection, with
+ *              archiveInterpolate
  */
 
 /* ===================================================================== */
@@ -46,6 +50,8 @@
 #include <string.h>
 #include <stdlib.h>     /* For atoi */
 
+#include <epicsAtomic.h> /* For epicsAtomicGetIntT */
+
 #include <cad.h>
 #include <car.h>
 #include <timeLib.h>
@@ -55,8 +61,12 @@
 #include "control.h"    /* For simLevel, scsBase, m2Ptr, m2MemFree */
 #include "utilities.h"  /* For debugLevel */
 
-#define BUFFERSIZE   400  /* Number of samples of m2 position to log.
-                             Assuming 200Hz update gives 1 second of capture */
+#define BUFFERSIZE   1024 /* Number of samples of m2 position to log, a
+                             power of two. At the 200Hz status frame rate
+                             this is 5 seconds of history */
+#define BUFFERMASK   (BUFFERSIZE - 1)
+#define BUFFERGUARD  16   /* entries next to the writer not trusted by
+                             readers */
 #define MAX_LOG_FREQ 200
 #define MIN_LOG_FREQ   1
 #define MAX_LOG_DUR   60  /* Duration of max logging in seconds */
@@ -75,10 +85,14 @@ enum                      /* index to define desired log elements */
 
 /* Define global variables */
 
-static double newestTime, oldestTime = 1.2345;
-static m2History *topPtr = NULL, *endPtr = NULL, *inPtr = NULL;
-// static m2History archive[BUFFERSIZE];
-static epicsMutexId archiveFree = NULL;
+/* Position history. Only scsReceive writes it: the entry is filled, then
+ * archiveCount is advanced. Readers take archiveCount, search the entries
+ * below it and check afterwards that the writer has not come round to
+ * what they read, so nobody waits on a lock. Times never decrease. */
+
+static m2History archive[BUFFERSIZE];
+static int archiveCount = 0;      /* entries ever written */
+static double newestTime = 0.0;
 /* Indicates that logging has been turned on */
 static int loggingArmed = OFF;
 
@@ -92,25 +106,27 @@ int logThreshold = 20;
 epicsMutexId refMemFree = NULL;
 DBADDR logCAddr;
 
-#if 0          // This isn;t being used by anybody
 /* ===================================================================== */
 /*
  * Function name:
- * writeArchive - create ring buffers and write new sample
+ * writeArchive - add the current M2 position to the position history
  * 
  * Purpose:
- * The function checks whether the necessary buffers have been
- * created. If not they are put in place. The current time is
- * read and added to the structure of logged data. The newest
- * and oldest times in the archive are then updated.
+ * Add a sample stamped with the current time to the ring, overwriting the
+ * oldest. Called by scsReceive for every status frame accepted. A time
+ * earlier than the last one written is raised to it, so the history stays
+ * in time order for the bisection in archiveFind.
  * 
  * Invocation:
- * status = writeArchive (double xTilt, double yTilt, double zFocus);
+ * status = writeArchive (xTilt, yTilt, zFocus, setX, setY, setZ);
  * 
  * Parameters in:
  *  > xTilt     double  current x tilt position
  *  > yTilt     double  current y tilt position
  *  > zFocus    double  current z focus position
+ *  > setX      double  TCS x tilt demand of the current beam
+ *  > setY      double  TCS y tilt demand of the current beam
+ *  > setZ      double  TCS focus demand
  * 
  * Parameters out:
  *  None
@@ -126,128 +142,134 @@ DBADDR logCAddr;
  *  None
  * 
  * Requirements:
- * None
+ * Only one task may call writeArchive
  * 
  * Author:
  * Sean Prior  (srp@roe.ac.uk)
  * 
  * History:
  * 30-Jun-1997: Original(srp)
+ * 17-Oct-2026: Lock-free ring in time order, always built
  * 
  */
 
-
 /* ===================================================================== */
 
-
-static int writeArchive (double xTilt, double yTilt, double zFocus, double setX, double setY, double setZ)
+int writeArchive (double xTilt, double yTilt, double zFocus, double setX, double setY, double setZ)
 {
     double timeStamp;
-    m2History *lookAheadPtr = NULL;
-
-    /*
-     * if not already present, create mutex semaphore to protect access to
-     * the archive
-     */
-
-    if (archiveFree == NULL)
-    {
-       archiveFree = epicsMutexMustCreate();
-    }
-
-    epicsMutexMustLock(archiveFree);
+    m2History *entry;
+    int count;
 
     /* capture current timestamp */
     if (timeNow (&timeStamp) != OK)
     {
        errorLog ("writeArchive - error reading timeStamp", 1, ON);
-       epicsMutexUnlock(archiveFree);
        return (ERROR);
     }
 
-    /* if first invocation, set pointers to start and end of buffer area */
+    count = archiveCount;
 
-    if (topPtr == NULL)
-    {
-    topPtr = (m2History *) archive;
-    endPtr = (m2History *) (archive + BUFFERSIZE - 1);
-    inPtr = topPtr;
+    if (count > 0 && timeStamp < newestTime)
+        timeStamp = newestTime;
 
-    if (timeNow (&oldestTime) != OK)
-    {
-        errorLog ("writeArchive - error reading oldestTime", 1, ON);
-        epicsMutexUnlock(archiveFree);
-        return (ERROR);
-    }
+    /* copy new sample into the archive */
 
-    printf ("archive buffer, topPtr = %lx, endPtr = %lx, time = %f\n", (long) topPtr, (long) endPtr, oldestTime);
-    }
+    entry = &archive[count & BUFFERMASK];
 
-    /*
-     * if the next entry will overwrite the oldest entry, update oldestTime.
-     * Beware testing these floats for equality
-     */
+    entry->time = timeStamp;
+    entry->xTilt = xTilt;
+    entry->yTilt = yTilt;
+    entry->zFocus = zFocus;
+    entry->setX = setX;
+    entry->setY = setY;
+    entry->setZ = setZ;
 
-    if (inPtr->time == oldestTime)
-    {
-    lookAheadPtr = inPtr + 1;   /* the oldest time will be the next
-                     * entry */
+    newestTime = timeStamp;
 
-    if (lookAheadPtr >= endPtr) /* check for wrapped condition */
-        lookAheadPtr = topPtr;
+    /* the entry must be complete before readers can see it */
 
-    oldestTime = lookAheadPtr->time;    /* update oldest time */
-    }
+    epicsAtomicWriteMemoryBarrier ();
+    epicsAtomicSetIntT (&archiveCount, count + 1);
 
-    /* copy new sample into the archive */
+    return (OK);
+}
 
-    inPtr->time = timeStamp;
-    inPtr->xTilt = xTilt;
-    inPtr->yTilt = yTilt;
-    inPtr->zFocus = zFocus;
-    inPtr->setX = setX;
-    inPtr->setY = setY;
-    inPtr->setZ = setZ;
+/* ===================================================================== */
+/*
+ * Function name:
+ * archiveFind
+ * 
+ * Purpose:
+ * Bisection of the history for the newest entry at or before a time.
+ * Copies that entry and the one after it (the same entry if it is the
+ * newest) and checks the writer has not overwritten them meanwhile.
+ *
+ * Return value:
+ *  < status    int OK, or ERROR if the history is empty, the time is
+ *              older than the history or the entries were overwritten
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
 
-    /* point to next free location */
+/* ===================================================================== */
 
-    inPtr++;
+static int archiveFind (double targetTime, m2History *before, m2History *after)
+{
+    unsigned count, oldest, low, high, mid, used;
 
-    /* update top and bottom limits */
+    count = (unsigned) epicsAtomicGetIntT (&archiveCount);
+    epicsAtomicReadMemoryBarrier ();
 
-    newestTime = timeStamp;
+    if (count == 0)
+        return (ERROR);
 
-    if (timeStamp < oldestTime)
-    oldestTime = timeStamp;
+    used = (count > BUFFERSIZE - BUFFERGUARD) ? BUFFERSIZE - BUFFERGUARD : count;
+    oldest = count - used;
 
-    /*
-     * increment pointer to next free location, wrap back to start if full
-     */
+    /* check that requested time is within archive range */
 
-    if (inPtr > endPtr)
-    inPtr = topPtr;
+    if (targetTime < archive[oldest & BUFFERMASK].time)
+        return (ERROR);
 
-    epicsMutexUnlock(archiveFree);
+    /* newest entry with time <= targetTime lies in [low, high] */
 
-    /* add scope for testing */
+    low = oldest;
+    high = count - 1;
 
-    if (inPtr < topPtr || inPtr > endPtr)
+    while (low < high)
     {
-       errlogPrintf ("writeArchive(): inPtr = %p", inPtr);
+        mid = low + (high - low + 1) / 2;
+
+        if (archive[mid & BUFFERMASK].time <= targetTime)
+            low = mid;
+        else
+            high = mid - 1;
     }
+
+    *before = archive[low & BUFFERMASK];
+    *after = archive[((low + 1 < count) ? low + 1 : low) & BUFFERMASK];
+
+    /* make sure the writer has not reached the entries while they were
+     * read, the guard leaves room for it to move a little */
+
+    epicsAtomicReadMemoryBarrier ();
+    if ((unsigned) epicsAtomicGetIntT (&archiveCount) - oldest >= BUFFERSIZE)
+        return (ERROR);
+
     return (OK);
 }
 
-#endif
-
 /* ===================================================================== */
 /*
  * Function name:
- * readArchive  - print sample for a given time to screen 
+ * readArchive  - latest history entry at or before a given time
  * 
  * Purpose:
- * For test purposes this function writes a sample from the log file to
- * screen.
+ * Fetch the M2 position and TCS demands recorded at or just before a
+ * time. A time beyond the newest entry gives the newest entry.
  *
  * Invocation:
  * status  = readArchive (m2History *archiveEntry, double targetTime)
@@ -276,6 +298,7 @@ static int writeArchive (double xTilt, double yTilt, double zFocus, double setX,
  * 
  * History:
  * 30-Jun-1997: Original(srp)
+ * 17-Oct-2026: Bisection of the lock-free ring replaces the linear scan
  * 
  */
 
@@ -283,62 +306,65 @@ static int writeArchive (double xTilt, double yTilt, double zFocus, double setX,
 
 int readArchive (m2History * archivePtr, double targetTime)
 {
-    m2History *searchPtr = NULL;
-
-    /* check that an archive exists, if not return NULL pointer */
-
-    if (topPtr == NULL)
-    {
-    errorLog ("readArchive - archive not present", 1, ON);
-    return (ERROR);
-    }
-
-    /* check that requested time is within archive range */
+    m2History before, after;
 
-    epicsMutexMustLock(archiveFree);
-    
-    if (targetTime < oldestTime)
-    {
-        epicsMutexUnlock(archiveFree);
+    if (archiveFind (targetTime, &before, &after) != OK)
         return (ERROR);
-    }
-
-    if (targetTime > newestTime)
-        targetTime = newestTime;
 
+    *archivePtr = before;
+    return (OK);
+}
 
-    /* search archive for time matching the search time */
+/* ===================================================================== */
+/*
+ * Function name:
+ * archiveInterpolate - history interpolated to a given time
+ * 
+ * Purpose:
+ * As readArchive, but the positions and demands are interpolated linearly
+ * between the entries either side of the time. A time beyond the newest
+ * entry gives the newest entry.
+ *
+ * Invocation:
+ * status  = archiveInterpolate (m2History *archiveEntry, double targetTime)
+ *
+ * Return value:
+ *  < status    int OK or ERROR
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
 
-    /* start search pointer at last entry, allow for wrapping */
+/* ===================================================================== */
 
-    searchPtr = inPtr - 1;
+int archiveInterpolate (m2History * archivePtr, double targetTime)
+{
+    m2History before, after;
+    double f;
 
-    if (searchPtr < topPtr)
-        searchPtr = endPtr;
+    if (archiveFind (targetTime, &before, &after) != OK)
+        return (ERROR);
 
-    while (searchPtr->time > targetTime)
+    if (after.time <= before.time || targetTime <= before.time)
     {
-        searchPtr--;
-
-        if (searchPtr < topPtr)
-            searchPtr = endPtr;
-
-	/* as a caution, ensure that this could never be an endless loop */
-	if (searchPtr == (inPtr - 1))
-	    break;
+        *archivePtr = before;
+        return (OK);
     }
 
-    epicsMutexUnlock(archiveFree);
+    f = (targetTime - before.time) / (after.time - before.time);
+    if (f > 1.0)
+        f = 1.0;
 
-    if (searchPtr != NULL)
-    {
-        *(m2History *) archivePtr = *(m2History *) searchPtr;
-        return (OK);
-    }
-    else
-    {
-        return (ERROR);
-    }
+    archivePtr->time = targetTime;
+    archivePtr->xTilt = before.xTilt + f * (after.xTilt - before.xTilt);
+    archivePtr->yTilt = before.yTilt + f * (after.yTilt - before.yTilt);
+    archivePtr->zFocus = before.zFocus + f * (after.zFocus - before.zFocus);
+    archivePtr->setX = before.setX + f * (after.setX - before.setX);
+    archivePtr->setY = before.setY + f * (after.setY - before.setY);
+    archivePtr->setZ = before.setZ + f * (after.setZ - before.setZ);
+
+    return (OK);
 }
 
 /* ===================================================================== */
@@ -564,7 +590,7 @@ void showArchive (void)
        errlogMessage("showArchive - error reading seekTime\n");
     }
 
-    epicsPrintf ("topPtr = %lx, endPtr = %lx, oldestTime = %f, newestTime = %f\n", (long) topPtr, (long) endPtr, oldestTime, newestTime);
+    epicsPrintf ("entries = %d, size = %d, newestTime = %f\n", epicsAtomicGetIntT (&archiveCount), BUFFERSIZE, newestTime);
 
     if (readArchive (&archiveEntry, seekTime) == OK)
     {
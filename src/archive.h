@@ -26,6 +26,7 @@
  * -------
  * 17-Nov-1999: Created new header files.
  * 16-Dec-1999: Added global variables.
+ * 17-Oct-2026: Added writeArchive and archiveInterpolate
  *
  */
 /* ===================================================================== */
@@ -46,8 +47,12 @@
 
 /* Public functions */
 
+int writeArchive (double xTilt, double yTilt, double zFocus, double setX, double setY, double setZ);
+
 int readArchive (m2History * archivePtr, double targetTime);
 
+int archiveInterpolate (m2History * archivePtr, double targetTime);
+
 /* Returns true if logging is armed, otherwise false. */
 int isLoggingArmed(void);
 
@@ -0,0 +1,1132 @@
+/* ===================================================================== */
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * biquad.c
+ *
+ * PURPOSE
+ * -------
+ * Second order section (biquad cascade) filter engine. Direct form B/A
+ * coefficients, as stored in the filter coefficient files, are factored
+ * into a cascade of second order sections when they are loaded, and the
+ * cascade is run in transposed direct form II. This needs fewer multiplies
+ * than the direct form from order 4 upwards and keeps narrow bandstop and
+ * bandpass filters stable at the guide rate.
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ * tf2sos          - factor a B/A transfer function into biquad sections
+ * sos2tf          - multiply biquad sections out into B/A form
+ * sosResponse     - magnitude response of a cascade
+ * sosDesign       - design Butterworth, Chebyshev I or notch filters
+ * sosClear        - zero the state of a cascade
+ * biquadFilter    - run one sample through one section
+ * sosFilter       - run one sample through a cascade
+ * showSos         - display the sections of a cascade
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ * Transfer functions of up to order 10 (11 coefficients) are supported.
+ * If the factored cascade does not reproduce the original coefficients
+ * tf2sos fails and the caller should keep using the direct form.
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ *
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Add the bilinear transform filter designer
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "biquad.h"
+#include "utilities.h"      /* For errorLog, debugLevel, OK, ERROR */
+
+#define SOS_MAX_ORDER      (2 * SOS_MAX_SECTIONS)
+#define ROOT_ITERATIONS    500      /* Durand-Kerner iteration limit      */
+#define ROOT_TOLERANCE     1.0e-14  /* Durand-Kerner convergence          */
+#define UNIT_TOLERANCE     1.0e-12  /* residual accepted for z = +1, -1   */
+#define CLUSTER_TOLERANCE  2.0e-3   /* roots this close are one repeated
+                                       root found with reduced accuracy   */
+#define REAL_TOLERANCE     1.0e-7   /* imaginary part treated as zero     */
+#define CHECK_TOLERANCE    1.0e-6   /* allowed error of rebuilt polynomial */
+
+typedef struct
+{
+   double re;
+   double im;
+} complexNum;
+
+typedef struct
+{
+   complexNum r1;
+   complexNum r2;
+   int        single;       /* TRUE if only r1 is a root (first order) */
+   double     radius;       /* largest root magnitude of the pair      */
+} rootPair;
+
+/* ===================================================================== */
+/*
+ * Complex arithmetic helpers
+ */
+/* ===================================================================== */
+
+static complexNum cMake (double re, double im)
+{
+   complexNum c;
+
+   c.re = re;
+   c.im = im;
+   return (c);
+}
+
+static complexNum cSub (complexNum x, complexNum y)
+{
+   return (cMake (x.re - y.re, x.im - y.im));
+}
+
+static complexNum cMul (complexNum x, complexNum y)
+{
+   return (cMake (x.re * y.re - x.im * y.im, x.re * y.im + x.im * y.re));
+}
+
+static complexNum cDiv (complexNum x, complexNum y)
+{
+   double d = y.re * y.re + y.im * y.im;
+
+   return (cMake ((x.re * y.re + x.im * y.im) / d,
+            (x.im * y.re - x.re * y.im) / d));
+}
+
+static double cAbs (complexNum x)
+{
+   return (sqrt (x.re * x.re + x.im * x.im));
+}
+
+static complexNum cSqrt (complexNum x)
+{
+   double r = cAbs (x);
+   double re = sqrt ((r + x.re) / 2.0);
+   double im = sqrt ((r - x.re) / 2.0);
+
+   return (cMake (re, (x.im < 0.0) ? -im : im));
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * deflateUnitRoot
+ *
+ * Purpose:
+ * Divide the monic polynomial c[0..n] (descending powers of z) by
+ * (z - root) if root is a root of it. Used to take out the repeated
+ * zeros at z = +1 and z = -1 of lowpass, highpass and bandpass designs
+ * exactly, since an iterative root finder only locates repeated roots to
+ * a fraction of the machine precision.
+ *
+ * Return value:
+ *      < n     int     degree of the polynomial after division
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int deflateUnitRoot (double *c, int n, const double root)
+{
+   double q[SOS_MAX_ORDER + 1];
+   double scale = 0.0;
+   int i;
+
+   if (n < 1)
+      return (n);
+
+   q[0] = c[0];
+   scale = fabs (c[0]);
+   for (i = 1; i <= n; i++)
+   {
+      q[i] = c[i] + root * q[i - 1];
+      scale += fabs (c[i]);
+   }
+
+   /* q[n] is the remainder */
+   if (fabs (q[n]) > UNIT_TOLERANCE * scale)
+      return (n);
+
+   for (i = 0; i < n; i++)
+      c[i] = q[i];
+   c[n] = 0.0;
+
+   return (n - 1);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * polishRoot
+ *
+ * Purpose:
+ * Refine a root of multiplicity m of the polynomial c[0..n] (descending
+ * powers of z). The (m-1)th derivative of the polynomial has a simple root
+ * at the same place, so Newton iteration on it converges quickly to full
+ * precision where iteration on the polynomial itself cannot.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static complexNum polishRoot (const double *c, int n, const int m, complexNum z)
+{
+   double d[SOS_MAX_ORDER + 1];
+   complexNum f, df, delta;
+   int i, k, iter;
+
+   for (i = 0; i <= n; i++)
+      d[i] = c[i];
+
+   for (k = 1; k < m && n > 0; k++)
+   {
+      for (i = 0; i < n; i++)
+         d[i] = d[i] * (n - i);
+      n--;
+   }
+
+   if (n < 1)
+      return (z);
+
+   for (iter = 0; iter < ROOT_ITERATIONS; iter++)
+   {
+      f = cMake (d[0], 0.0);
+      df = cMake (0.0, 0.0);
+      for (i = 1; i <= n; i++)
+      {
+         df = cMul (df, z);
+         df.re += f.re;
+         df.im += f.im;
+         f = cMul (f, z);
+         f.re += d[i];
+      }
+
+      if (cAbs (df) == 0.0)
+         break;
+
+      delta = cDiv (f, df);
+      z = cSub (z, delta);
+
+      if (cAbs (delta) < ROOT_TOLERANCE * (1.0 + cAbs (z)))
+         break;
+   }
+
+   return (z);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * findRoots
+ *
+ * Purpose:
+ * Find the n roots of the monic polynomial c[0..n] (descending powers of
+ * z). Roots at the origin are taken out directly, as are roots at z = +1,
+ * -1 if unitRoots is set (only for numerators: the poles of a stable
+ * filter cluster near, but never on, the unit circle and would be taken
+ * out wrongly). The rest are found by Durand-Kerner iteration. Repeated roots that the
+ * iteration can only locate approximately are replaced by the centre of
+ * their cluster, refined by polishRoot.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void findRoots (const double *coeffs, int n, const int unitRoots,
+      complexNum *root)
+{
+   double c[SOS_MAX_ORDER + 1];
+   complexNum seed, p, den, delta, sum;
+   double maxDelta;
+   int found = 0;
+   int i, j, k, iter, m, last;
+   int cluster[SOS_MAX_ORDER];
+
+   for (i = 0; i <= n; i++)
+      c[i] = coeffs[i];
+
+   /* roots at the origin */
+   while (n > 0 && c[n] == 0.0)
+   {
+      root[found++] = cMake (0.0, 0.0);
+      n--;
+   }
+
+   /* repeated roots on the real axis at the unit circle */
+   for (last = -1; unitRoots && last != n; )
+   {
+      last = n;
+      if ((n = deflateUnitRoot (c, n, -1.0)) < last)
+         root[found++] = cMake (-1.0, 0.0);
+      else if ((n = deflateUnitRoot (c, n, 1.0)) < last)
+         root[found++] = cMake (1.0, 0.0);
+   }
+
+   if (n == 0)
+      return;
+
+   if (n == 1)
+   {
+      root[found] = cMake (-c[1] / c[0], 0.0);
+      return;
+   }
+
+   /* Durand-Kerner on what is left */
+   seed = cMake (0.4, 0.9);
+   root[found] = cMake (1.0, 0.0);
+   for (k = 1; k < n; k++)
+      root[found + k] = cMul (root[found + k - 1], seed);
+
+   for (iter = 0; iter < ROOT_ITERATIONS; iter++)
+   {
+      maxDelta = 0.0;
+
+      for (k = 0; k < n; k++)
+      {
+         p = cMake (c[0], 0.0);
+         for (i = 1; i <= n; i++)
+            p = cMake (p.re * root[found + k].re - p.im * root[found + k].im + c[i],
+                  p.re * root[found + k].im + p.im * root[found + k].re);
+
+         den = cMake (c[0], 0.0);
+         for (j = 0; j < n; j++)
+         {
+            if (j != k)
+               den = cMul (den, cSub (root[found + k], root[found + j]));
+         }
+
+         if (cAbs (den) == 0.0)
+            den = cMake (ROOT_TOLERANCE, 0.0);
+
+         delta = cDiv (p, den);
+         root[found + k] = cSub (root[found + k], delta);
+
+         if (cAbs (delta) > maxDelta)
+            maxDelta = cAbs (delta);
+      }
+
+      if (maxDelta < ROOT_TOLERANCE)
+         break;
+   }
+
+   /* replace each cluster of roots by its centre */
+   for (k = 0; k < n; k++)
+      cluster[k] = FALSE;
+
+   for (k = 0; k < n; k++)
+   {
+      if (cluster[k])
+         continue;
+
+      sum = root[found + k];
+      m = 1;
+      for (j = k + 1; j < n; j++)
+      {
+         if (!cluster[j] &&
+               cAbs (cSub (root[found + j], root[found + k])) < CLUSTER_TOLERANCE)
+         {
+            sum.re += root[found + j].re;
+            sum.im += root[found + j].im;
+            m++;
+         }
+      }
+
+      if (m == 1)
+         continue;
+
+      sum = polishRoot (c, n, m, cMake (sum.re / m, sum.im / m));
+      for (j = n - 1; j >= k; j--)
+      {
+         if (!cluster[j] &&
+               cAbs (cSub (root[found + j], root[found + k])) < CLUSTER_TOLERANCE)
+         {
+            root[found + j] = sum;
+            cluster[j] = TRUE;
+         }
+      }
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * pairRoots
+ *
+ * Purpose:
+ * Group the n real coefficient roots into conjugate pairs and pairs of
+ * real roots (the real roots are paired in order of magnitude, leaving at
+ * most one single real root) so that each group gives a second order
+ * polynomial with real coefficients.
+ *
+ * Return value:
+ *      < pairs int     number of groups, ERROR if a complex root has no
+ *                      conjugate
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int pairRoots (complexNum *root, const int n, rootPair *pair)
+{
+   int used[SOS_MAX_ORDER];
+   int real[SOS_MAX_ORDER];
+   int i, j, best, nreal = 0, npair = 0;
+   double dist, bestDist;
+
+   for (i = 0; i < n; i++)
+   {
+      used[i] = FALSE;
+      if (fabs (root[i].im) < REAL_TOLERANCE * (1.0 + fabs (root[i].re)))
+         root[i].im = 0.0;
+   }
+
+   /* conjugate pairs */
+   for (i = 0; i < n; i++)
+   {
+      if (used[i] || root[i].im <= 0.0)
+         continue;
+
+      best = -1;
+      bestDist = 0.0;
+      for (j = 0; j < n; j++)
+      {
+         if (used[j] || root[j].im >= 0.0)
+            continue;
+
+         dist = cAbs (cSub (root[j], cMake (root[i].re, -root[i].im)));
+         if (best < 0 || dist < bestDist)
+         {
+            best = j;
+            bestDist = dist;
+         }
+      }
+
+      if (best < 0)
+         return (ERROR);
+
+      /* use the mean of the root and its conjugate partner */
+      used[i] = used[best] = TRUE;
+      pair[npair].r1 = cMake ((root[i].re + root[best].re) / 2.0,
+            (root[i].im - root[best].im) / 2.0);
+      pair[npair].r2 = cMake (pair[npair].r1.re, -pair[npair].r1.im);
+      pair[npair].single = FALSE;
+      pair[npair].radius = cAbs (pair[npair].r1);
+      npair++;
+   }
+
+   /* remaining roots must be real, sort by decreasing magnitude */
+   for (i = 0; i < n; i++)
+   {
+      if (used[i])
+         continue;
+
+      if (root[i].im != 0.0)
+         return (ERROR);
+
+      for (j = nreal; j > 0 && fabs (root[real[j - 1]].re) < fabs (root[i].re); j--)
+         real[j] = real[j - 1];
+      real[j] = i;
+      nreal++;
+   }
+
+   for (i = 0; i < nreal; i += 2)
+   {
+      pair[npair].r1 = root[real[i]];
+      pair[npair].radius = fabs (root[real[i]].re);
+
+      if (i + 1 < nreal)
+      {
+         pair[npair].r2 = root[real[i + 1]];
+         pair[npair].single = FALSE;
+      }
+      else
+      {
+         pair[npair].r2 = cMake (0.0, 0.0);
+         pair[npair].single = TRUE;
+      }
+      npair++;
+   }
+
+   return (npair);
+}
+
+static void pairToSection (const rootPair *pair, double *c1, double *c2)
+{
+   if (pair->single)
+   {
+      *c1 = -pair->r1.re;
+      *c2 = 0.0;
+   }
+   else
+   {
+      *c1 = -(pair->r1.re + pair->r2.re);
+      *c2 = cMul (pair->r1, pair->r2).re;
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * zp2sos
+ *
+ * Purpose:
+ * Build a cascade of second order sections from n zeros and n poles.
+ * Pole pairs are ordered so that those nearest the unit circle come last,
+ * and each is matched with the nearest remaining zero pair. The gain of
+ * the cascade is set to one.
+ *
+ * Return value:
+ *      < status        int     OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original, split out of tf2sos
+ *
+ */
+/* ===================================================================== */
+
+static int zp2sos (complexNum *zero, complexNum *pole, const int n, SOS *sos)
+{
+   double c1, c2;
+   rootPair zeroPair[SOS_MAX_SECTIONS], polePair[SOS_MAX_SECTIONS], swap;
+   int used[SOS_MAX_SECTIONS];
+   int nz, np, i, j, best;
+   double dist, bestDist;
+
+   sos->nsections = 0;
+   sos->gain = 1.0;
+
+   if (n < 1 || n > SOS_MAX_ORDER)
+      return (ERROR);
+
+   nz = pairRoots (zero, n, zeroPair);
+   np = pairRoots (pole, n, polePair);
+
+   if (nz == ERROR || np == ERROR || nz != np || np > SOS_MAX_SECTIONS)
+   {
+      errorLog ("zp2sos - unable to pair roots", 2, ON);
+      return (ERROR);
+   }
+
+   /* sort pole pairs by increasing radius */
+   for (i = 1; i < np; i++)
+   {
+      swap = polePair[i];
+      for (j = i; j > 0 && polePair[j - 1].radius > swap.radius; j--)
+         polePair[j] = polePair[j - 1];
+      polePair[j] = swap;
+   }
+
+   /* match zeros to poles starting with the poles nearest the unit circle */
+   for (i = 0; i < nz; i++)
+      used[i] = FALSE;
+
+   for (i = np - 1; i >= 0; i--)
+   {
+      best = -1;
+      bestDist = 0.0;
+      for (j = 0; j < nz; j++)
+      {
+         if (used[j])
+            continue;
+
+         dist = cAbs (cSub (zeroPair[j].r1, polePair[i].r1));
+         if (best < 0 || dist < bestDist)
+         {
+            best = j;
+            bestDist = dist;
+         }
+      }
+      used[best] = TRUE;
+
+      pairToSection (&zeroPair[best], &c1, &c2);
+      sos->section[i].b0 = 1.0;
+      sos->section[i].b1 = c1;
+      sos->section[i].b2 = c2;
+
+      pairToSection (&polePair[i], &c1, &c2);
+      sos->section[i].a1 = c1;
+      sos->section[i].a2 = c2;
+
+      sos->section[i].s1 = 0.0;
+      sos->section[i].s2 = 0.0;
+   }
+
+   sos->nsections = np;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * tf2sos
+ *
+ * Purpose:
+ * Factor the transfer function B(z)/A(z), given as direct form
+ * coefficients b0..b(nb-1), a0..a(na-1), into a cascade of second order
+ * sections. The cascade is multiplied back out and compared with the
+ * original coefficients before it is accepted.
+ *
+ * Invocation:
+ * status = tf2sos(b, nb, a, na, &sos)
+ *
+ * Parameters in:
+ *              > b     double* numerator coefficients
+ *              > nb    int     number of numerator coefficients
+ *              > a     double* denominator coefficients
+ *              > na    int     number of denominator coefficients
+ *
+ * Parameters out:
+ *              < sos   SOS*    cascade, nsections is zero on failure or
+ *                              for a pure gain
+ *
+ * Return value:
+ *              < status        int     OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int tf2sos (const double *b, int nb, const double *a, int na, SOS *sos)
+{
+   double num[SOS_MAX_ORDER + 2], den[SOS_MAX_ORDER + 2];
+   double rebuiltNum[SOS_MAX_ORDER + 2], rebuiltDen[SOS_MAX_ORDER + 2];
+   double scale, error;
+   complexNum zero[SOS_MAX_ORDER], pole[SOS_MAX_ORDER];
+   int order, i, n;
+
+   sos->nsections = 0;
+   sos->gain = 1.0;
+
+   if (nb < 1 || na < 1)
+      return (ERROR);
+
+   order = ((nb > na) ? nb : na) - 1;
+
+   if (order > SOS_MAX_ORDER || a[0] == 0.0 || b[0] == 0.0)
+      return (ERROR);
+
+   if (order == 0)
+   {
+      sos->gain = b[0] / a[0];
+      return (OK);
+   }
+
+   for (i = 0; i < SOS_MAX_ORDER + 2; i++)
+   {
+      num[i] = (i < nb && i <= order) ? b[i] / b[0] : 0.0;
+      den[i] = (i < na && i <= order) ? a[i] / a[0] : 0.0;
+   }
+
+   findRoots (num, order, TRUE, zero);
+   findRoots (den, order, FALSE, pole);
+
+   if (zp2sos (zero, pole, order, sos) != OK)
+      return (ERROR);
+
+   /* multiply the sections back out and compare */
+   n = sos2tf (sos, rebuiltNum, rebuiltDen);
+
+   scale = 1.0;
+   error = 0.0;
+   for (i = 0; i < n; i++)
+   {
+      if (fabs (num[i]) > scale) scale = fabs (num[i]);
+      if (fabs (den[i]) > scale) scale = fabs (den[i]);
+      if (fabs (rebuiltNum[i] - num[i]) > error) error = fabs (rebuiltNum[i] - num[i]);
+      if (fabs (rebuiltDen[i] - den[i]) > error) error = fabs (rebuiltDen[i] - den[i]);
+   }
+
+   if (error > CHECK_TOLERANCE * scale)
+   {
+      if (debugLevel > DEBUG_NONE)
+         printf ("tf2sos - cascade error %g, using direct form\n", error);
+      sos->nsections = 0;
+      return (ERROR);
+   }
+
+   sos->gain = b[0] / a[0];
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sos2tf
+ *
+ * Purpose:
+ * Multiply a cascade out into direct form coefficients. The gain of the
+ * cascade is not applied and a[0] is 1.
+ *
+ * Invocation:
+ * n = sos2tf(&sos, b, a)
+ *
+ * Parameters in:
+ *              > sos   SOS*    cascade
+ *
+ * Parameters out:
+ *              < b     double* numerator, room for 2 * SOS_MAX_SECTIONS + 1
+ *              < a     double* denominator, same size
+ *
+ * Return value:
+ *              < n     int     number of coefficients in b and a
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int sos2tf (const SOS *sos, double *b, double *a)
+{
+   int i, k, n;
+
+   n = 2 * sos->nsections + 1;
+
+   for (i = 0; i < n; i++)
+   {
+      b[i] = (i == 0) ? 1.0 : 0.0;
+      a[i] = (i == 0) ? 1.0 : 0.0;
+   }
+
+   for (k = 0; k < sos->nsections; k++)
+   {
+      for (i = 2 * (k + 1); i > 0; i--)
+      {
+         b[i] = sos->section[k].b0 * b[i] + sos->section[k].b1 * b[i - 1] +
+            ((i > 1) ? sos->section[k].b2 * b[i - 2] : 0.0);
+         a[i] += sos->section[k].a1 * a[i - 1] +
+            ((i > 1) ? sos->section[k].a2 * a[i - 2] : 0.0);
+      }
+      b[0] *= sos->section[k].b0;
+   }
+
+   return (n);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sosResponse
+ *
+ * Purpose:
+ * Return the magnitude of the response of a cascade at normalised
+ * frequency f (cycles per sample)
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+double sosResponse (const SOS *sos, const double f)
+{
+   complexNum z1, z2, num, den, h;
+   int k;
+
+   /* z^-1 and z^-2 on the unit circle */
+   z1 = cMake (cos (2.0 * M_PI * f), -sin (2.0 * M_PI * f));
+   z2 = cMul (z1, z1);
+
+   h = cMake (sos->gain, 0.0);
+
+   for (k = 0; k < sos->nsections; k++)
+   {
+      num = cMake (sos->section[k].b0 + sos->section[k].b1 * z1.re +
+            sos->section[k].b2 * z2.re,
+            sos->section[k].b1 * z1.im + sos->section[k].b2 * z2.im);
+      den = cMake (1.0 + sos->section[k].a1 * z1.re + sos->section[k].a2 * z2.re,
+            sos->section[k].a1 * z1.im + sos->section[k].a2 * z2.im);
+      h = cMul (h, cDiv (num, den));
+   }
+
+   return (cAbs (h));
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sosDesign
+ *
+ * Purpose:
+ * Design a Butterworth or Chebyshev type I lowpass, highpass, bandpass or
+ * bandstop filter, or a second order notch, directly as a cascade of
+ * second order sections. The analogue prototype poles are transformed to
+ * the requested band and mapped to the z plane with the bilinear
+ * transform, with the band edges prewarped, so the edges are exact at any
+ * sample rate rather than the nearest 0.01 step of the coefficient files.
+ *
+ * The gain is set for unity response at DC (lowpass, bandstop), at the
+ * Nyquist frequency (highpass) or at the band centre (bandpass). Even
+ * order Chebyshev filters are set to the bottom of the ripple there.
+ *
+ * A notch has its centre at (f1 + f2) / 2 and -3dB width f2 - f1, or
+ * centre / SOS_NOTCH_Q if f2 is not above f1; order is ignored.
+ *
+ * Invocation:
+ * status = sosDesign(band, method, order, ripple, f1, f2, &sos)
+ *
+ * Parameters in:
+ *              > band    int    SOS_LOWPASS, SOS_HIGHPASS, SOS_BANDPASS,
+ *                               SOS_BANDSTOP or SOS_NOTCH
+ *              > method  int    SOS_BUTTERWORTH or SOS_CHEBYSHEV
+ *              > order   int    prototype order, 1 to 10 for lowpass and
+ *                               highpass, 1 to 5 for bandpass, bandstop
+ *              > ripple  double Chebyshev passband ripple (dB)
+ *              > f1      double lower edge, cycles per sample
+ *              > f2      double upper edge, cycles per sample
+ *
+ * Parameters out:
+ *              < sos     SOS*   designed cascade
+ *
+ * Return value:
+ *              < status        int     OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int sosDesign (int band, int method, int order, double ripple,
+      double f1, double f2, SOS *sos)
+{
+   complexNum proto[SOS_MAX_ORDER];
+   complexNum zero[SOS_MAX_ORDER], pole[SOS_MAX_ORDER];
+   complexNum s, half, root;
+   double w1, w2, w0, bw, epsilon, mu, theta, f0, target, response;
+   double alpha, w;
+   int k, n = 0;
+
+   sos->nsections = 0;
+   sos->gain = 1.0;
+
+   if (f1 <= 0.0 || f1 >= 0.5 || (band != SOS_LOWPASS && band != SOS_HIGHPASS
+            && band != SOS_NOTCH && (f2 <= f1 || f2 >= 0.5)))
+   {
+      errorLog ("sosDesign - band edges out of range", 2, ON);
+      return (ERROR);
+   }
+
+   /* second order notch, bilinear transform of
+    * (s^2 + w0^2) / (s^2 + s w0 / Q + w0^2) with Q = f0 / bw */
+   if (band == SOS_NOTCH)
+   {
+      if (f2 > f1)
+      {
+         f0 = (f1 + f2) / 2.0;
+         bw = f2 - f1;
+      }
+      else
+      {
+         f0 = f1;
+         bw = f1 / SOS_NOTCH_Q;
+      }
+
+      if (f0 >= 0.5)
+      {
+         errorLog ("sosDesign - notch above Nyquist", 2, ON);
+         return (ERROR);
+      }
+
+      w = 2.0 * M_PI * f0;
+      alpha = sin (w) * bw / (2.0 * f0);
+
+      sos->section[0].b0 = 1.0;
+      sos->section[0].b1 = -2.0 * cos (w);
+      sos->section[0].b2 = 1.0;
+      sos->section[0].a1 = -2.0 * cos (w) / (1.0 + alpha);
+      sos->section[0].a2 = (1.0 - alpha) / (1.0 + alpha);
+      sos->section[0].s1 = 0.0;
+      sos->section[0].s2 = 0.0;
+      sos->gain = 1.0 / (1.0 + alpha);
+      sos->nsections = 1;
+
+      return (OK);
+   }
+
+   if (order < 1 || ((band == SOS_BANDPASS || band == SOS_BANDSTOP) ?
+            2 * order : order) > SOS_MAX_ORDER)
+   {
+      errorLog ("sosDesign - filter order out of range", 2, ON);
+      return (ERROR);
+   }
+
+   /* analogue lowpass prototype with unit cutoff */
+   epsilon = sqrt (pow (10.0, ripple / 10.0) - 1.0);
+   mu = (epsilon > 0.0) ? log ((1.0 + sqrt (1.0 + epsilon * epsilon)) / epsilon) / order : 0.0;
+
+   for (k = 0; k < order; k++)
+   {
+      theta = M_PI * (2 * k + 1) / (2.0 * order);
+
+      if (method == SOS_CHEBYSHEV)
+         proto[k] = cMake (-sinh (mu) * sin (theta), cosh (mu) * cos (theta));
+      else
+         proto[k] = cMake (-sin (theta), cos (theta));
+   }
+
+   /* prewarped band edges */
+   w1 = tan (M_PI * f1);
+   w2 = tan (M_PI * ((band == SOS_LOWPASS || band == SOS_HIGHPASS) ? f1 : f2));
+   w0 = sqrt (w1 * w2);
+   bw = w2 - w1;
+
+   /* transform prototype to the band, then bilinear z = (1 + s) / (1 - s) */
+   for (k = 0; k < order; k++)
+   {
+      switch (band)
+      {
+      case SOS_LOWPASS:
+         s = cMake (w1 * proto[k].re, w1 * proto[k].im);
+         pole[n] = cDiv (cMake (1.0 + s.re, s.im), cMake (1.0 - s.re, -s.im));
+         zero[n++] = cMake (-1.0, 0.0);
+         break;
+
+      case SOS_HIGHPASS:
+         s = cDiv (cMake (w1, 0.0), proto[k]);
+         pole[n] = cDiv (cMake (1.0 + s.re, s.im), cMake (1.0 - s.re, -s.im));
+         zero[n++] = cMake (1.0, 0.0);
+         break;
+
+      case SOS_BANDPASS:
+      case SOS_BANDSTOP:
+         if (band == SOS_BANDPASS)
+            half = cMake (proto[k].re * bw / 2.0, proto[k].im * bw / 2.0);
+         else
+            half = cDiv (cMake (bw / 2.0, 0.0), proto[k]);
+
+         root = cSqrt (cSub (cMul (half, half), cMake (w0 * w0, 0.0)));
+
+         s = cMake (half.re + root.re, half.im + root.im);
+         pole[n] = cDiv (cMake (1.0 + s.re, s.im), cMake (1.0 - s.re, -s.im));
+         s = cSub (half, root);
+         pole[n + 1] = cDiv (cMake (1.0 + s.re, s.im), cMake (1.0 - s.re, -s.im));
+
+         if (band == SOS_BANDPASS)
+         {
+            zero[n] = cMake (1.0, 0.0);
+            zero[n + 1] = cMake (-1.0, 0.0);
+         }
+         else
+         {
+            zero[n] = cDiv (cMake (1.0, w0), cMake (1.0, -w0));
+            zero[n + 1] = cDiv (cMake (1.0, -w0), cMake (1.0, w0));
+         }
+         n += 2;
+         break;
+
+      default:
+         errorLog ("sosDesign - filter band not recognised", 2, ON);
+         return (ERROR);
+      }
+   }
+
+   if (zp2sos (zero, pole, n, sos) != OK)
+      return (ERROR);
+
+   /* normalise the gain at the reference frequency */
+   switch (band)
+   {
+   case SOS_HIGHPASS:
+      f0 = 0.5;
+      break;
+
+   case SOS_BANDPASS:
+      f0 = atan (w0) / M_PI;
+      break;
+
+   default:
+      f0 = 0.0;
+   }
+
+   target = (method == SOS_CHEBYSHEV && (order % 2) == 0) ?
+      1.0 / sqrt (1.0 + epsilon * epsilon) : 1.0;
+
+   response = sosResponse (sos, f0);
+   if (response == 0.0)
+   {
+      sos->nsections = 0;
+      return (ERROR);
+   }
+   sos->gain = target / response;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sosClear
+ *
+ * Purpose:
+ * Zero the state of every section of a cascade
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void sosClear (SOS *sos)
+{
+   int i;
+
+   for (i = 0; i < SOS_MAX_SECTIONS; i++)
+   {
+      sos->section[i].s1 = 0.0;
+      sos->section[i].s2 = 0.0;
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * biquadFilter
+ *
+ * Purpose:
+ * Run one sample through one second order section (transposed direct
+ * form II)
+ *
+ * Invocation:
+ * filtered output = biquadFilter(input, *s)
+ *
+ * Parameters in:
+ *              > input double  sample value to be filtered
+ *              > s     *BIQUAD section coefficients and state
+ *
+ * Return value:
+ *              < result        double  filtered output sample
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+double biquadFilter (const double input, BIQUAD *s)
+{
+   double output;
+
+   output = s->b0 * input + s->s1;
+   s->s1 = s->b1 * input - s->a1 * output + s->s2;
+   s->s2 = s->b2 * input - s->a2 * output;
+
+   return (output);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sosFilter
+ *
+ * Purpose:
+ * Run one sample through a cascade of second order sections
+ *
+ * Invocation:
+ * filtered output = sosFilter(input, *sos)
+ *
+ * Parameters in:
+ *              > input double  sample value to be filtered
+ *              > sos   *SOS    cascade
+ *
+ * Return value:
+ *              < result        double  filtered output sample
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+double sosFilter (const double input, SOS *sos)
+{
+   double output = input * sos->gain;
+   int i;
+
+   for (i = 0; i < sos->nsections; i++)
+      output = biquadFilter (output, &sos->section[i]);
+
+   return (output);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * showSos
+ *
+ * Purpose:
+ * Display the sections of a cascade, for use from the shell
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void showSos (const SOS *sos)
+{
+   int i;
+
+   if (sos == NULL)
+      return;
+
+   printf ("gain = %g, %d sections\n", sos->gain, sos->nsections);
+
+   for (i = 0; i < sos->nsections; i++)
+   {
+      printf ("section %d: b = %+.12f %+.12f %+.12f  a = 1 %+.12f %+.12f\n",
+            i, sos->section[i].b0, sos->section[i].b1, sos->section[i].b2,
+            sos->section[i].a1, sos->section[i].a2);
+   }
+}
@@ -0,0 +1,101 @@
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * biquad.h
+ *
+ * PURPOSE
+ * -------
+ * Header file defines the public interface for biquad.c
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Add sosDesign, sos2tf and sosResponse
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+#ifndef _INCLUDED_BIQUAD_H
+#define _INCLUDED_BIQUAD_H
+
+#define SOS_MAX_SECTIONS 5      /* 11 coefficients = order 10 = 5 sections */
+
+/* One second order section, run in transposed direct form II:
+ *
+ *   y  = b0 * x + s1
+ *   s1 = b1 * x - a1 * y + s2
+ *   s2 = b2 * x - a2 * y
+ */
+
+typedef struct
+{
+        double  b0;
+        double  b1;
+        double  b2;
+        double  a1;
+        double  a2;
+        double  s1;             /* state                                */
+        double  s2;
+} BIQUAD;
+
+/* Cascade of second order sections. nsections of zero means that no
+ * cascade is loaded and the direct form coefficients must be used. */
+
+typedef struct
+{
+        int     nsections;
+        double  gain;           /* applied to the input of section 0    */
+        BIQUAD  section[SOS_MAX_SECTIONS];
+} SOS;
+
+/* filter bands and methods for sosDesign */
+
+enum
+{
+        SOS_LOWPASS = 0,
+        SOS_HIGHPASS,
+        SOS_BANDPASS,
+        SOS_BANDSTOP,
+        SOS_NOTCH
+};
+
+enum
+{
+        SOS_BUTTERWORTH = 0,
+        SOS_CHEBYSHEV
+};
+
+#define SOS_NOTCH_Q     10.0    /* notch Q if no width is given         */
+
+int tf2sos (const double *b, int nb, const double *a, int na, SOS *sos);
+
+int sos2tf (const SOS *sos, double *b, double *a);
+
+double sosResponse (const SOS *sos, const double f);
+
+int sosDesign (int band, int method, int order, double ripple,
+               double f1, double f2, SOS *sos);
+
+void sosClear (SOS *sos);
+
+double biquadFilter (const double input, BIQUAD *s);
+
+double sosFilter (const double input, SOS *sos);
+
+void showSos (const SOS *sos);
+
+#endif
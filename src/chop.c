@@ -37,6 +37,8 @@
  *      where possible
  * 12-Jun-2000: Move chopIsOn here from chopControl.c
  * 24-Oct-2017: Begin conversion to EPICS OSI (mdw)
+ * 17-Oct-2026: Chop statistics read M2 status with readStatus
+ * 17-Oct-2026: chopConfigC follows the acknowledgement of the commands
  *
  */
 /* ===================================================================== */
@@ -87,6 +89,7 @@ int m2ChopResponseOK = 0;
 int chopIsPending = 0;
 int decsIsPending = 0;
 int jogBeam = BEAMA;
+commandCar chopConfigCar;     /* chopConfigC, found by setup.c */
 
 instStructure instruments[MAX_CHOP_CONTROLLERS] = {
    {"scs        ", 0, "no", 0, "STROBE"},
@@ -163,6 +166,8 @@ double getChopFreq(void)
  *      also ensure inputs interpreted as strings
  * 15-Jun-1997: look up instrument details for event system interface.
  * 24-Feb-1998: defer looking up port from syncSource until menuDirectiveSTART
+ * 17-Oct-2026: chopConfigC is put to IDLE when M2 has acknowledged the
+ *      sync source and CHOP_CHANGE commands, to ERR if it has not
  * 
  */
 
@@ -275,14 +280,18 @@ long CADchopConfig (struct cadRecord * pcad)
            *(double *) pcad->vald = dutyCycle;
            *(long *) pcad->vale = instruments[syncSource].port;
 
+       /* the database sets chopConfigC BUSY, the commands put it back
+        * to IDLE or ERR once they are acknowledged or have failed */
+       commandCarStart(&chopConfigCar);
+
       if (syncSource == 0)
        {
-           writeCommand(SYNC_SOURCE_M2);
+           writeCommandCar(SYNC_SOURCE_M2, &chopConfigCar);
       errlogMessage("CADchopConfig - telling M2 sync source is M2\n");
        }
        else
        {
-           writeCommand(SYNC_SOURCE_SCS);
+           writeCommandCar(SYNC_SOURCE_SCS, &chopConfigCar);
            errlogMessage("CADchopConfig - telling M2 sync source is external to M2\n");
        }
 
@@ -294,10 +303,11 @@ long CADchopConfig (struct cadRecord * pcad)
        epicsMutexUnlock(refMemFree);
 
        /* flag that chop configuration has been changed */
-       writeCommand(CHOP_CHANGE);
+       writeCommandCar(CHOP_CHANGE, &chopConfigCar);
        printf
       ("CADchopConfig - telling M2 chop config has changed to freq=%f, dutyCycle=%f\n", 
        frequency, dutyCycle);
+       commandCarRelease(&chopConfigCar);
 /*       taskDelay(5);
        writeCommand(CHOP_CHANGE);
        printf
@@ -745,6 +755,7 @@ double  percentCalc (struct subRecord * psub)
    static  int coincidence = 0;
    static  double percentage = 0;
    int inPos, beamNow;
+   statusBlock status;
 
    /* if not chopping, set to 100% and exit */
    if(chopIsOn != 1)
@@ -753,15 +764,13 @@ double  percentCalc (struct subRecord * psub)
       return(OK);
    }   
   
-   epicsMutexLock(refMemFree);
+   readStatus (&status);
 
    /* grab in position and beam position */
-   beamNow = scsPtr->page1.beamPosition;
+   beamNow = status.beamPosition;
    /*NEW (srp) invert sense of inPosition */
-   /*inPos = scsPtr->page1.inPosition;*/
-   inPos = !scsPtr->page1.inPosition;
-
-   epicsMutexUnlock(refMemFree);
+   /*inPos = status.inPosition;*/
+   inPos = !status.inPosition;
 
    /* check if beam has chopped */
    if (beamNow != oldBeam)
@@ -29,6 +29,7 @@
  * 17-Nov-1999: Created new header files.
  * 16-Dec-1999: Added global variables.
  * 12-Jun-2000: Move chopIsOn here from chopControl.h
+ * 17-Oct-2026: Added chopConfigCar
  *
  */
 /* INDENT ON */
@@ -52,6 +53,7 @@
 #endif
 
 #include "chopControl.h"
+#include "command.h"            /* For commandCar */
 
 #define MAX_CHOP_CONTROLLERS    6    /* five instruments plus the SCS itself */
 
@@ -93,6 +95,7 @@ extern int chopIsPending;
 extern int decsIsPending;
 extern int jogBeam;
 extern instStructure instruments[MAX_CHOP_CONTROLLERS];
+extern commandCar chopConfigCar;
 
 #endif
 
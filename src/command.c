@@ -0,0 +1,1258 @@
+/* ===================================================================== */
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * command.c
+ *
+ * PURPOSE
+ * -------
+ * Pipeline for the commands sent to M2 on the command page. Callers
+ * submit a command and return at once with a sequence number; the guide
+ * loop (processGuides) takes at most one command at a time into the
+ * frame it is building, and the next command is not sent until M2 has
+ * acknowledged that frame by returning its NS as NR on the status page,
+ * or until commandAckTimeout has passed. The pacing of commands is
+ * therefore set by M2 rather than by a fixed delay in the caller.
+ *
+ * Commands waiting to be sent are held in a pending list owned by
+ * processGuides and sent by priority: safety and stop commands first,
+ * then configuration commands, then the periodic POSITION and
+ * SCS_TIME_UPDATE, first come first served within a priority. A command
+ * which only tells M2 to re-read data on the command page is coalesced
+ * with the same command already pending, and a stop command supersedes
+ * the matching start command still pending (CHOP_OFF removes CHOP_ON).
+ *
+ * A command submitted after its caller has changed data on the command
+ * page (scsPtr->page0) must not reach M2 before slowTransmit has copied
+ * that data into the image of page 0 which processGuides commits, or M2
+ * would read the old values. slowTransmit numbers each copy it takes of
+ * scsPtr->page0 with commandPageSnapshot and reports with
+ * commandPageRefreshed when the copy is in the image. Each command is
+ * stamped with the first copy taken after it was submitted, and all but
+ * urgent commands, which carry no page data, are held until the image
+ * has been refreshed from that copy.
+ *
+ * When a command is acknowledged, times out, is superseded or is flushed
+ * by the interlocks its completion callback, if any, is called. The
+ * callbacks are called by the tCommandDone task, not by processGuides,
+ * so that a callback putting to a CAR cannot delay the guide loop;
+ * commandCarDone is the callback driving a CAR for a group of commands.
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ * commandInit        - create the command queue
+ * commandSubmit      - queue a command for M2
+ * commandNext        - command for the frame being built by processGuides
+ * commandAcknowledge - complete the command in flight when NR confirms it
+ * commandFlush       - discard the queued commands
+ * commandPageSnapshot  - number a copy of the command page, slowTransmit
+ * commandPageRefreshed - image of page 0 refreshed from a copy
+ * commandCarInit     - find the IVAL and IMSS fields of a CAR
+ * commandCarStart    - start a group of commands reported to a CAR
+ * commandCarRelease  - all the commands of the group are submitted
+ * commandCarDone     - completion callback driving the CAR
+ * commandShow        - print the state of the pipeline
+ * commandReport      - genSub routine, queue depth and wait times
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ * Only one command is in flight at a time, as M2 only reads one command
+ * code per frame, so an urgent command waits for the acknowledgement of
+ * the command in flight (normally the next frame) but for nothing else.
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ *
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Priority and coalescing of pending commands
+ * 17-Oct-2026: Hold commands until the image of page 0 has been refreshed
+ *              from the command page, drop the unused completion callbacks
+ * 17-Oct-2026: Counters shared between tasks are atomic, statistics are
+ *              cleared by processGuides
+ * 17-Oct-2026: Completion callbacks restored, called by tCommandDone;
+ *              commandCar drives a CAR from them
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+#include <stdio.h>
+#include <string.h>         /* For memset */
+#include <epicsAtomic.h>    /* For epicsAtomicIncrIntT */
+#include <car.h>            /* For CAR_IDLE, CAR_ERROR */
+
+#include "command.h"
+#include "control.h"        /* For FAST_ONLY */
+#include "utilities.h"      /* For errorLog, monotonicNow, debugLevel */
+
+#define COMMAND_QUEUE_SIZE  100
+#define COMMAND_DONE_SIZE   (2 * COMMAND_QUEUE_SIZE)
+
+/* Command as held on the queue */
+
+typedef struct
+{
+   long           command;        /* M2 command code                   */
+   long           sequence;       /* from commandSubmit                */
+   int            generation;     /* page copy the frame must include  */
+   double         submitted;      /* monotonic time of commandSubmit   */
+   commandDoneFn  done;           /* completion callback, or NULL      */
+   void          *arg;            /* passed to done                    */
+} m2Command;
+
+/* Completion passed to tCommandDone */
+
+typedef struct
+{
+   long           command;
+   long           sequence;
+   int            status;         /* COMMAND_ACKNOWLEDGED ..           */
+   commandDoneFn  done;
+   void          *arg;
+} commandDone;
+
+/* How each command is scheduled. Commands not in the table are
+ * COMMAND_NORMAL, are not coalesced and supersede nothing. */
+
+typedef struct
+{
+   long           command;
+   int            priority;       /* COMMAND_URGENT .. COMMAND_PERIODIC */
+   int            coalesce;       /* TRUE if one pending copy is enough */
+   long           supersedes;     /* pending command removed, or -1     */
+} commandClass;
+
+static const commandClass commandClasses[] =
+{
+   {CMD_RESET,          COMMAND_URGENT,   FALSE, -1},
+   {ACT_PWR_OFF,        COMMAND_URGENT,   FALSE, ACT_PWR_ON},
+   {CHOP_OFF,           COMMAND_URGENT,   FALSE, CHOP_ON},
+   {DECS_FREEZE,        COMMAND_URGENT,   FALSE, DECS_UNFREEZE},
+   {DECS_PAUSE,         COMMAND_URGENT,   FALSE, DECS_CONTINUE},
+   {DECS_OFF,           COMMAND_URGENT,   FALSE, DECS_ON},
+   {VDECS_OFF,          COMMAND_URGENT,   FALSE, VDECS_ON},
+   {MEND,               COMMAND_URGENT,   FALSE, MSTART},
+   {VEND,               COMMAND_URGENT,   FALSE, VIBSTART},
+   {VSTOPDRVFOL,        COMMAND_URGENT,   FALSE, VSTARTDRVFOL},
+   {MSTOPDRVOFL,        COMMAND_URGENT,   FALSE, MSTARTDRVOFL},
+   {BAFFLE_CHANGE,      COMMAND_NORMAL,   TRUE,  -1},
+   {DECS_CHANGE,        COMMAND_NORMAL,   TRUE,  -1},
+   {BANDWIDTH_CHANGE,   COMMAND_NORMAL,   TRUE,  -1},
+   {TOLERANCE_CHANGE,   COMMAND_NORMAL,   TRUE,  -1},
+   {UPDATE_XY_RANGE,    COMMAND_NORMAL,   TRUE,  -1},
+   {UPDATE_XPYP_RANGE,  COMMAND_NORMAL,   TRUE,  -1},
+   {XY_DEADBAND_CHANGE, COMMAND_NORMAL,   TRUE,  -1},
+   {POSITION,           COMMAND_PERIODIC, TRUE,  -1},
+   {SCS_TIME_UPDATE,    COMMAND_PERIODIC, TRUE,  -1}
+};
+
+#define COMMAND_CLASSES (sizeof (commandClasses) / sizeof (commandClass))
+#define COMMAND_CODES   (SCS_TIME_UPDATE + 1)
+
+static const commandClass normalClass = {FAST_ONLY, COMMAND_NORMAL, FALSE, -1};
+
+/* Commands received from commandQId and not yet sent, in order of
+ * arrival. Only processGuides (commandNext) changes the list. */
+
+static m2Command pending[COMMAND_QUEUE_SIZE];
+static int pendingCount = 0;
+static volatile int flushRequest = FALSE;
+static volatile int clearRequest = FALSE;
+
+/* Time from commandSubmit to the frame which carried the command */
+
+typedef struct
+{
+   unsigned long  count;
+   double         total;          /* s */
+   double         max;            /* s */
+} commandWait;
+
+static commandWait waitByCode[COMMAND_CODES];
+static commandWait waitByPriority[COMMAND_PRIORITIES];
+
+static const char *priorityName[COMMAND_PRIORITIES] =
+{
+   "urgent",
+   "normal",
+   "periodic"
+};
+
+/* The command in flight */
+
+enum
+{
+   COMMAND_IDLE = 0,
+   COMMAND_SENT
+};
+
+static struct
+{
+   int            state;
+   m2Command      cmd;
+   long           ns;             /* NS of the frame carrying it       */
+   double         sent;           /* monotonic time it was sent        */
+} inFlight = { COMMAND_IDLE };
+
+epicsMessageQueueId commandQId = NULL;
+static epicsMessageQueueId commandDoneQId = NULL;
+double commandAckTimeout = 0.5;   /* s to wait for NR before moving on */
+double commandSpacing = 0.0;      /* minimum s between commands        */
+
+static epicsMutexId commandFree = NULL;
+static int commandSequence = 0;
+
+/* copies of the command page taken by slowTransmit, and the last copy
+ * in the image of page 0 */
+static int pageSnapshot = 0;
+static int pageRefreshed = 0;
+static double lastSent = 0.0;
+
+/* counters updated by more than one task are atomic; the others are only
+ * written by processGuides, or under commandFree */
+static int submitted = 0;
+static int rejected = 0;
+static int flushed = 0;
+static int doneLost = 0;
+static unsigned long sent = 0;
+static unsigned long acknowledged = 0;
+static unsigned long timeouts = 0;
+static unsigned long coalesced = 0;
+static unsigned long superseded = 0;
+static int depthMax = 0;
+static double ackLast = 0.0;
+static double ackMax = 0.0;
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * classOf
+ *
+ * Purpose:
+ * Scheduling class of a command code
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static const commandClass *classOf (long command)
+{
+   unsigned int i;
+
+   for (i = 0; i < COMMAND_CLASSES; i++)
+   {
+      if (commandClasses[i].command == command)
+         return &commandClasses[i];
+   }
+
+   return &normalClass;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandNotify
+ *
+ * Purpose:
+ * Pass the outcome of a command with a completion callback to the
+ * tCommandDone task. Never waits, so that processGuides may call it.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void commandNotify (const m2Command *cmd, int status)
+{
+   commandDone done;
+
+   if (cmd->done == NULL)
+      return;
+
+   done.command = cmd->command;
+   done.sequence = cmd->sequence;
+   done.status = status;
+   done.done = cmd->done;
+   done.arg = cmd->arg;
+
+   if (epicsMessageQueueTrySend (commandDoneQId, (void *) &done,
+            sizeof (commandDone)) != 0)
+   {
+      epicsAtomicIncrIntT (&doneLost);
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandDoneTask
+ *
+ * Purpose:
+ * Call the completion callbacks passed by commandNotify
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void commandDoneTask (void *arg)
+{
+   commandDone done;
+
+   for (;;)
+   {
+      if (epicsMessageQueueReceive (commandDoneQId, (void *) &done,
+               sizeof (commandDone)) != sizeof (commandDone))
+         continue;
+
+      done.done (done.command, done.sequence, done.status, done.arg);
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * pendingRemove
+ *
+ * Purpose:
+ * Remove entry i from the pending list, keeping the order of the rest
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static m2Command pendingRemove (int i)
+{
+   m2Command cmd = pending[i];
+
+   for (; i < pendingCount - 1; i++)
+      pending[i] = pending[i + 1];
+
+   pendingCount--;
+
+   return cmd;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * pendingAdd
+ *
+ * Purpose:
+ * Add a command received from commandQId to the pending list. A stop
+ * command first removes the start command it supersedes. A coalescing
+ * command already pending is not added again; the pending copy waits for
+ * the page copy of the new one instead, and takes over its callback if
+ * it has none of its own.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Completion callbacks restored
+ *
+ */
+/* ===================================================================== */
+
+static void pendingAdd (const m2Command *cmd)
+{
+   const commandClass *kind = classOf (cmd->command);
+   m2Command removed;
+   int i;
+
+   if (kind->supersedes >= 0)
+   {
+      for (i = pendingCount - 1; i >= 0; i--)
+      {
+         if (pending[i].command == kind->supersedes)
+         {
+            removed = pendingRemove (i);
+            superseded++;
+            commandNotify (&removed, COMMAND_SUPERSEDED);
+         }
+      }
+   }
+
+   if (kind->coalesce)
+   {
+      for (i = 0; i < pendingCount; i++)
+      {
+         if (pending[i].command != cmd->command)
+            continue;
+
+         /* two callbacks are not merged, the new copy is added */
+         if (cmd->done != NULL && pending[i].done != NULL)
+            break;
+
+         pending[i].sequence = cmd->sequence;
+         pending[i].generation = cmd->generation;
+         if (cmd->done != NULL)
+         {
+            pending[i].done = cmd->done;
+            pending[i].arg = cmd->arg;
+         }
+         coalesced++;
+         return;
+      }
+   }
+
+   pending[pendingCount++] = *cmd;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * pendingPick
+ *
+ * Purpose:
+ * Index of the oldest pending command of the highest priority, or -1
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int pendingPick (void)
+{
+   int i, best = -1, bestPriority = COMMAND_PRIORITIES;
+   int priority;
+
+   for (i = 0; i < pendingCount; i++)
+   {
+      priority = classOf (pending[i].command)->priority;
+      if (priority < bestPriority)
+      {
+         best = i;
+         bestPriority = priority;
+         if (priority == COMMAND_URGENT)
+            break;
+      }
+   }
+
+   return best;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * waitAdd
+ *
+ * Purpose:
+ * Add the time a command waited before it was sent to its statistics
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void waitAdd (commandWait *w, double wait)
+{
+   w->count++;
+   w->total += wait;
+   if (wait > w->max)
+      w->max = wait;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandComplete
+ *
+ * Purpose:
+ * Retire the command in flight and pass its outcome to its completion
+ * callback. Called with commandFree held.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Completion callbacks restored
+ *
+ */
+/* ===================================================================== */
+
+static void commandComplete (int acknowledge, double now)
+{
+   double elapsed = now - inFlight.sent;
+
+   if (acknowledge)
+   {
+      acknowledged++;
+      ackLast = elapsed;
+      if (elapsed > ackMax)
+         ackMax = elapsed;
+   }
+   else
+   {
+      timeouts++;
+      if (debugLevel > DEBUG_NONE)
+      {
+         errlogPrintf ("command %ld (seq %ld) not acknowledged after %.3fs\n",
+               inFlight.cmd.command, inFlight.cmd.sequence, elapsed);
+      }
+   }
+
+   commandNotify (&inFlight.cmd,
+         acknowledge ? COMMAND_ACKNOWLEDGED : COMMAND_TIMEOUT);
+   inFlight.state = COMMAND_IDLE;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandInit
+ *
+ * Purpose:
+ * Create the command queue, the lock on the command in flight and the
+ * task calling the completion callbacks
+ *
+ * Invocation:
+ * status = commandInit()
+ *
+ * Return value:
+ *              < status  int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original, queue was created by initRefMem
+ * 17-Oct-2026: Create tCommandDone
+ *
+ */
+/* ===================================================================== */
+
+int commandInit (void)
+{
+   if ((commandFree = epicsMutexCreate ()) == NULL)
+   {
+      errorLog ("commandInit(): error creating commandFree mutex", 1, ON);
+      return (ERROR);
+   }
+
+   if ((commandQId = epicsMessageQueueCreate (COMMAND_QUEUE_SIZE,
+               sizeof (m2Command))) == NULL)
+   {
+      errorLog ("commandInit(): error in creation of commandQId message queue",
+            1, ON);
+      return (ERROR);
+   }
+
+   if ((commandDoneQId = epicsMessageQueueCreate (COMMAND_DONE_SIZE,
+               sizeof (commandDone))) == NULL)
+   {
+      errorLog ("commandInit(): error in creation of commandDoneQId message queue",
+            1, ON);
+      return (ERROR);
+   }
+
+   if (epicsThreadCreate ("tCommandDone", epicsThreadPriorityMedium,
+            epicsThreadGetStackSize (epicsThreadStackMedium),
+            (EPICSTHREADFUNC) commandDoneTask, NULL) == NULL)
+   {
+      errorLog ("commandInit(): error creating tCommandDone", 1, ON);
+      return (ERROR);
+   }
+
+   printf ("commandInit(): commandQId message queue created successfully\n");
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandSubmit
+ *
+ * Purpose:
+ * Queue a command for M2 without waiting for it to be sent
+ *
+ * Invocation:
+ * sequence = commandSubmit(command, done, arg)
+ *
+ * Parameters in:
+ *              > command  long           M2 command code
+ *              > done     commandDoneFn  called on completion, or NULL
+ *              > arg      void*          passed to done
+ *
+ * Return value:
+ *              < sequence long   sequence number (> 0), or ERROR if the
+ *                                queue is full
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      > commandQId
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Stamp with the next copy of the command page, no callback
+ * 17-Oct-2026: Completion callback restored
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+long commandSubmit (long command, commandDoneFn done, void *arg)
+{
+   m2Command cmd;
+
+   cmd.command = command;
+   cmd.done = done;
+   cmd.arg = arg;
+   cmd.sequence = (long) epicsAtomicIncrIntT (&commandSequence);
+   cmd.generation = epicsAtomicGetIntT (&pageSnapshot) + 1;
+   cmd.submitted = monotonicNow ();
+
+   if (epicsMessageQueueTrySend (commandQId, (void *) &cmd,
+            sizeof (m2Command)) != 0)
+   {
+      epicsAtomicIncrIntT (&rejected);
+      return (ERROR);
+   }
+
+   epicsAtomicIncrIntT (&submitted);
+
+   return (cmd.sequence);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandNext
+ *
+ * Purpose:
+ * Called by processGuides for every frame it builds. Moves the commands
+ * submitted since the last frame to the pending list and, if none is in
+ * flight, returns the pending command of the highest priority and marks
+ * it as sent in the frame with sequence number ns, otherwise FAST_ONLY.
+ * A command in flight for longer than commandAckTimeout is timed out
+ * first. Urgent commands are not held by commandSpacing; the others are
+ * held until the image of page 0 includes the copy of the command page
+ * they were stamped with.
+ *
+ * Invocation:
+ * command = commandNext(ns)
+ *
+ * Parameters in:
+ *              > ns       long   NS of the frame being built
+ *
+ * Return value:
+ *              < command  long   command code for the frame
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      > commandAckTimeout, commandSpacing
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Send the pending command of the highest priority
+ * 17-Oct-2026: Hold commands until the image of page 0 is refreshed
+ * 17-Oct-2026: Clear the statistics when commandReport asks
+ * 17-Oct-2026: Report the flushed commands to their callbacks
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+long commandNext (long ns)
+{
+   m2Command cmd;
+   long command = FAST_ONLY;
+   double now = monotonicNow ();
+   int i, priority, depth, ready;
+
+   /* carry out a flush requested by commandFlush */
+   if (flushRequest)
+   {
+      flushRequest = FALSE;
+      epicsAtomicAddIntT (&flushed, pendingCount);
+      for (i = 0; i < pendingCount; i++)
+         commandNotify (&pending[i], COMMAND_FLUSHED);
+      pendingCount = 0;
+   }
+
+   /* carry out a clear of the statistics requested by commandReport */
+   if (clearRequest)
+   {
+      clearRequest = FALSE;
+      memset (waitByCode, 0, sizeof (waitByCode));
+      memset (waitByPriority, 0, sizeof (waitByPriority));
+      depthMax = 0;
+      coalesced = 0;
+      superseded = 0;
+   }
+
+   /* commands left on commandQId when the list is full wait there */
+   while (pendingCount < COMMAND_QUEUE_SIZE &&
+         epicsMessageQueueTryReceive (commandQId, (void *) &cmd,
+            sizeof (m2Command)) == sizeof (m2Command))
+   {
+      pendingAdd (&cmd);
+   }
+
+   depth = pendingCount + epicsMessageQueuePending (commandQId);
+   if (depth > depthMax)
+      depthMax = depth;
+
+   epicsMutexLock (commandFree);
+
+   if (inFlight.state == COMMAND_SENT &&
+         now - inFlight.sent > commandAckTimeout)
+   {
+      commandComplete (FALSE, now);
+   }
+
+   if (inFlight.state == COMMAND_IDLE && (i = pendingPick ()) >= 0)
+   {
+      priority = classOf (pending[i].command)->priority;
+
+      /* difference taken unsigned so that the generation may wrap */
+      ready = priority == COMMAND_URGENT ||
+         (now - lastSent >= commandSpacing &&
+          (int) ((unsigned int) epicsAtomicGetIntT (&pageRefreshed) -
+             (unsigned int) pending[i].generation) >= 0);
+
+      if (ready)
+      {
+         cmd = pendingRemove (i);
+
+         inFlight.cmd = cmd;
+         inFlight.ns = ns;
+         inFlight.sent = now;
+         inFlight.state = COMMAND_SENT;
+         lastSent = now;
+         sent++;
+         command = cmd.command;
+
+         waitAdd (&waitByPriority[priority], now - cmd.submitted);
+         if (command >= 0 && command < COMMAND_CODES)
+            waitAdd (&waitByCode[command], now - cmd.submitted);
+      }
+   }
+
+   epicsMutexUnlock (commandFree);
+
+   return (command);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandAcknowledge
+ *
+ * Purpose:
+ * Called by scsReceive with the NR of each good status frame. Completes
+ * the command in flight once NR has reached the NS of the frame which
+ * carried it.
+ *
+ * Invocation:
+ * commandAcknowledge(nr)
+ *
+ * Parameters in:
+ *              > nr       long   NR from the status page
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+void commandAcknowledge (long nr)
+{
+   double now = monotonicNow ();
+
+   epicsMutexLock (commandFree);
+
+   /* difference taken unsigned so that NS may wrap */
+   if (inFlight.state == COMMAND_SENT)
+   {
+      if ((long) ((unsigned long) nr - (unsigned long) inFlight.ns) >= 0)
+      {
+         commandComplete (TRUE, now);
+      }
+      else if (now - inFlight.sent > commandAckTimeout)
+      {
+         commandComplete (FALSE, now);
+      }
+   }
+
+   epicsMutexUnlock (commandFree);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandFlush
+ *
+ * Purpose:
+ * Discard the queued commands. Commands still on commandQId are discarded
+ * at once and the pending list is emptied by processGuides at its next
+ * frame. A command already in flight has been sent and is left to
+ * complete.
+ *
+ * Invocation:
+ * commandFlush()
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Request processGuides to empty the pending list
+ * 17-Oct-2026: No completion callbacks to call
+ * 17-Oct-2026: Report the discarded commands to their callbacks
+ *
+ */
+/* ===================================================================== */
+
+void commandFlush (void)
+{
+   m2Command cmd;
+
+   flushRequest = TRUE;
+
+   while (epicsMessageQueueTryReceive (commandQId, (void *) &cmd,
+            sizeof (m2Command)) != MSG_Q_EMPTY)
+   {
+      epicsAtomicIncrIntT (&flushed);
+      commandNotify (&cmd, COMMAND_FLUSHED);
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandPageSnapshot
+ *
+ * Purpose:
+ * Number the copy of the command page slowTransmit is taking. Called with
+ * refMemFree held, so that a caller which changed the page under
+ * refMemFree before commandSubmit is in this copy or a later one.
+ *
+ * Invocation:
+ * generation = commandPageSnapshot()
+ *
+ * Return value:
+ *              < generation  long   number of the copy, passed to
+ *                                   commandPageRefreshed
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+long commandPageSnapshot (void)
+{
+   return (long) epicsAtomicIncrIntT (&pageSnapshot);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandPageRefreshed
+ *
+ * Purpose:
+ * Record that the image of page 0 now holds a copy of the command page.
+ * Called by slowTransmit with the lock on the image held, so that the
+ * commands released by it go out in a frame built from the new image.
+ *
+ * Invocation:
+ * commandPageRefreshed(generation)
+ *
+ * Parameters in:
+ *              > generation  long   from commandPageSnapshot
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void commandPageRefreshed (long generation)
+{
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicSetIntT (&pageRefreshed, (int) generation);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandCarFinish
+ *
+ * Purpose:
+ * Put the CAR of a completed group of commands to IDLE, or to ERR with
+ * the outcome of the command which failed
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void commandCarFinish (commandCar *car)
+{
+   char message[MAX_STRING_SIZE];
+   long state = CAR_IDLE;
+   int failed = epicsAtomicGetIntT (&car->failed);
+
+   if (!car->valid)
+      return;
+
+   if (failed != 0)
+   {
+      switch (failed)
+      {
+         case COMMAND_TIMEOUT:
+            strncpy (message, "M2 did not acknowledge command", MAX_STRING_SIZE);
+            break;
+         case COMMAND_SUPERSEDED:
+            strncpy (message, "M2 command superseded", MAX_STRING_SIZE);
+            break;
+         default:
+            strncpy (message, "M2 command not sent", MAX_STRING_SIZE);
+            break;
+      }
+      message[MAX_STRING_SIZE - 1] = '\0';
+      dbPutField (&car->message, DBR_STRING, message, 1);
+      state = CAR_ERROR;
+   }
+
+   dbPutField (&car->state, DBR_LONG, &state, 1);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandCarInit
+ *
+ * Purpose:
+ * Find the IVAL and IMSS fields of the CAR to be driven by commandCarDone
+ *
+ * Invocation:
+ * status = commandCarInit(car, name)
+ *
+ * Parameters in:
+ *              > name    const char*  CAR record name, e.g. "m2:chopConfigC"
+ *
+ * Parameters out:
+ *              < car     commandCar*  CAR to drive
+ *
+ * Return value:
+ *              < status  int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+int commandCarInit (commandCar *car, const char *name)
+{
+   char pRecordName[MAX_STRING_SIZE];
+
+   memset (car, 0, sizeof (commandCar));
+
+   sprintf (pRecordName, "%.*s.IVAL", MAX_STRING_SIZE - 6, name);
+   if (dbNameToAddr (pRecordName, &car->state) != 0)
+   {
+      errlogPrintf ("commandCarInit(): %s not found\n", pRecordName);
+      return (ERROR);
+   }
+
+   sprintf (pRecordName, "%.*s.IMSS", MAX_STRING_SIZE - 6, name);
+   if (dbNameToAddr (pRecordName, &car->message) != 0)
+   {
+      errlogPrintf ("commandCarInit(): %s not found\n", pRecordName);
+      return (ERROR);
+   }
+
+   car->valid = TRUE;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandCarStart
+ *
+ * Purpose:
+ * Start a group of commands reported to a CAR. The group is held open,
+ * so that the CAR is not finished by a command completing before the
+ * rest are submitted, until commandCarRelease. A group started while the
+ * previous one is still outstanding is merged with it.
+ *
+ * Invocation:
+ * commandCarStart(car)
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void commandCarStart (commandCar *car)
+{
+   if (epicsAtomicIncrIntT (&car->outstanding) == 1)
+      epicsAtomicSetIntT (&car->failed, 0);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandCarRelease
+ *
+ * Purpose:
+ * All the commands of the group started by commandCarStart have been
+ * submitted; the CAR is finished when the last of them completes.
+ *
+ * Invocation:
+ * commandCarRelease(car)
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void commandCarRelease (commandCar *car)
+{
+   if (epicsAtomicDecrIntT (&car->outstanding) == 0)
+      commandCarFinish (car);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandCarDone
+ *
+ * Purpose:
+ * Completion callback for a command of a group reported to a CAR. The
+ * caller adds to car->outstanding before commandSubmit.
+ *
+ * Invocation:
+ * commandSubmit(command, commandCarDone, car)
+ *
+ * Parameters in:
+ *              > command   long         M2 command code
+ *              > sequence  long         from commandSubmit
+ *              > status    int          COMMAND_ACKNOWLEDGED ..
+ *              > arg       commandCar*  CAR of the group
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+void commandCarDone (long command, long sequence, int status, void *arg)
+{
+   commandCar *car = (commandCar *) arg;
+
+   if (status != COMMAND_ACKNOWLEDGED)
+   {
+      epicsAtomicSetIntT (&car->failed, status);
+      if (debugLevel > DEBUG_NONE)
+      {
+         errlogPrintf ("command %ld (seq %ld) failed, status %d\n",
+               command, sequence, status);
+      }
+   }
+
+   if (epicsAtomicDecrIntT (&car->outstanding) == 0)
+      commandCarFinish (car);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandShow
+ *
+ * Purpose:
+ * Print the command in flight, the command counters and the time
+ * commands waited to be sent by priority and by command code
+ *
+ * Invocation:
+ * status = commandShow()
+ *
+ * Return value:
+ *              < status  int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int commandShow (void)
+{
+   commandWait *w;
+   double now = monotonicNow ();
+   int i;
+
+   epicsMutexLock (commandFree);
+
+   if (inFlight.state == COMMAND_SENT)
+   {
+      printf ("in flight:     command %ld seq %ld in NS %ld for %.3fs\n",
+            inFlight.cmd.command, inFlight.cmd.sequence, inFlight.ns,
+            now - inFlight.sent);
+   }
+   else
+   {
+      printf ("in flight:     none\n");
+   }
+
+   epicsMutexUnlock (commandFree);
+
+   printf ("queued:        %d pending, %d on commandQId, max %d\n",
+         pendingCount, epicsMessageQueuePending (commandQId), depthMax);
+   printf ("submitted:     %u (%u rejected, queue full)\n",
+         (unsigned) epicsAtomicGetIntT (&submitted),
+         (unsigned) epicsAtomicGetIntT (&rejected));
+   printf ("coalesced:     %lu\n", coalesced);
+   printf ("superseded:    %lu\n", superseded);
+   printf ("sent:          %lu\n", sent);
+   printf ("acknowledged:  %lu, last %.3fs, max %.3fs\n", acknowledged,
+         ackLast, ackMax);
+   printf ("timed out:     %lu (after %.3fs)\n", timeouts, commandAckTimeout);
+   printf ("flushed:       %u\n", (unsigned) epicsAtomicGetIntT (&flushed));
+   printf ("callbacks:     %d waiting, %u lost (queue full)\n",
+         epicsMessageQueuePending (commandDoneQId),
+         (unsigned) epicsAtomicGetIntT (&doneLost));
+   printf ("page copies:   %d taken, %d in the image\n",
+         epicsAtomicGetIntT (&pageSnapshot), epicsAtomicGetIntT (&pageRefreshed));
+
+   printf ("\npriority   sent      mean wait (ms)  max wait (ms)\n");
+   for (i = 0; i < COMMAND_PRIORITIES; i++)
+   {
+      w = &waitByPriority[i];
+      printf ("%-8s %8lu  %14.1f  %13.1f\n", priorityName[i], w->count,
+            w->count ? 1000.0 * w->total / w->count : 0.0, 1000.0 * w->max);
+   }
+
+   printf ("\ncommand    sent      mean wait (ms)  max wait (ms)\n");
+   for (i = 0; i < COMMAND_CODES; i++)
+   {
+      w = &waitByCode[i];
+      if (w->count == 0)
+         continue;
+      printf ("%8d %8lu  %14.1f  %13.1f\n", i, w->count,
+            1000.0 * w->total / w->count, 1000.0 * w->max);
+   }
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * commandReport
+ *
+ * Purpose:
+ * genSub routine publishing the depth of the command queue and the time
+ * commands wait to be sent, by priority (urgent, normal, periodic)
+ *
+ * Invocation:
+ * status = commandReport(pgsub)
+ *
+ * Parameters in:
+ *              > pgsub->a    long   non zero to clear the statistics
+ *
+ * Parameters out:
+ *              < pgsub->vala long        commands waiting to be sent
+ *              < pgsub->valb long        largest number waiting
+ *              < pgsub->valc long        commands coalesced
+ *              < pgsub->vald double[3]   mean wait (ms)
+ *              < pgsub->vale double[3]   maximum wait (ms)
+ *
+ * Return value:
+ *              < status      long        OK
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Clear requested from processGuides
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+long commandReport (struct genSubRecord *pgsub)
+{
+   commandWait *w;
+   int i;
+
+   *(long *) pgsub->vala = pendingCount + epicsMessageQueuePending (commandQId);
+   *(long *) pgsub->valb = depthMax;
+   *(long *) pgsub->valc = (long) coalesced;
+
+   for (i = 0; i < COMMAND_PRIORITIES; i++)
+   {
+      w = &waitByPriority[i];
+      ((double *) pgsub->vald)[i] =
+         w->count ? 1000.0 * w->total / w->count : 0.0;
+      ((double *) pgsub->vale)[i] = 1000.0 * w->max;
+   }
+
+   /* statistics are written by processGuides, which clears them at its
+    * next frame */
+   if (*(long *) pgsub->a != 0)
+   {
+      clearRequest = TRUE;
+      *(long *) pgsub->a = 0;
+   }
+
+   return (OK);
+}
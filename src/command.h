@@ -0,0 +1,124 @@
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * command.h
+ *
+ * PURPOSE
+ * -------
+ * Header file defines the public interface for command.c
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Added command priorities and commandReport
+ * 17-Oct-2026: Dropped the completion callbacks, no caller used them.
+ *              Added commandPageSnapshot and commandPageRefreshed
+ * 17-Oct-2026: Completion callbacks restored, called from a task of their
+ *              own; added commandCar to drive a CAR from them
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+#ifndef _INCLUDED_COMMAND_H
+#define _INCLUDED_COMMAND_H
+
+#ifndef _INCLUDED_GENSUBRECORD_H
+#define _INCLUDED_GENSUBRECORD_H
+#include <genSubRecord.h>
+#endif
+
+#ifndef _INCLUDED_DBACCESS_H
+#define _INCLUDED_DBACCESS_H
+#include <dbAccess.h>           /* For DBADDR */
+#endif
+
+#include "utilities.h"          /* For epicsMessageQueueId */
+
+/* Outcome of a command, passed to its completion callback */
+
+enum
+{
+        COMMAND_ACKNOWLEDGED = 0,       /* NR has reached the frame's NS */
+        COMMAND_TIMEOUT,                /* no acknowledgement in time    */
+        COMMAND_FLUSHED,                /* discarded, interlocks active  */
+        COMMAND_SUPERSEDED              /* replaced by a stop command    */
+};
+
+/* Order in which pending commands are sent */
+
+enum
+{
+        COMMAND_URGENT = 0,             /* safety and stop commands      */
+        COMMAND_NORMAL,                 /* configuration and start       */
+        COMMAND_PERIODIC,               /* POSITION, SCS_TIME_UPDATE     */
+        COMMAND_PRIORITIES
+};
+
+/* Completion callback. Called from the tCommandDone task, never from
+ * processGuides, so it may take locks and put to records. */
+
+typedef void (*commandDoneFn) (long command, long sequence, int status,
+                               void *arg);
+
+/* A CAR driven by the completion of a group of commands: BUSY is set by
+ * the database, IDLE once every command of the group is acknowledged,
+ * ERR with a message if any of them is not. */
+
+typedef struct
+{
+        DBADDR  state;                  /* IVAL of the CAR               */
+        DBADDR  message;                /* IMSS of the CAR               */
+        int     valid;                  /* addresses found               */
+        int     outstanding;            /* commands not complete, atomic */
+        int     failed;                 /* a command failed, atomic      */
+} commandCar;
+
+/* Public functions */
+
+int commandInit (void);
+
+long commandSubmit (long command, commandDoneFn done, void *arg);
+
+long commandNext (long ns);
+
+void commandAcknowledge (long nr);
+
+void commandFlush (void);
+
+long commandPageSnapshot (void);
+
+void commandPageRefreshed (long generation);
+
+int commandCarInit (commandCar *car, const char *name);
+
+void commandCarStart (commandCar *car);
+
+void commandCarRelease (commandCar *car);
+
+void commandCarDone (long command, long sequence, int status, void *arg);
+
+int commandShow (void);
+
+long commandReport (struct genSubRecord *pgsub);
+
+/* Global variables */
+
+extern epicsMessageQueueId commandQId;
+extern double commandAckTimeout;
+extern double commandSpacing;
+
+#endif
@@ -17,7 +17,21 @@
  * blendSources    - combine guide sources
  * fireLoops       - handle watchdog timer at each timeout
  * processGuides   - assemble the M2 commands in page0 and raise the interrupt
+ * guideSample     - convert, filter and store one guide source sample
+ * sourceVariance  - variances of a guide source for the current beam
+ * fuseGuides      - minimum variance combination of the guide sources
+ * rmSettle        - wait for the guide page after ISR3 (rmSettleMode)
+ * rmSettleShow    - report the reflective memory settle times
+ * guideDeadline   - processGuides wait for ISR3 from the guide rate
+ * guideLoopReport - genSub, processGuides CPU use and wakeups
+ * guideDelayCompensate - remove the mirror motion since the WFS exposure
+ * guideDelayShow  - report the guide delay compensation of each source
+ * guideTransformFor - WFS to M2 transform of a source, recompiled when
+ *                   the conversion frames change
  * iir_filter      - perform filter operation
+ * iir_filter3     - perform filter operation on x, y and z together
+ * cbInit          - allocate the guide ring buffer (cbRecordNb records)
+ * cbColumn        - one field of the guide ring buffer, oldest first
  * updateEventPage - updates eventData (formerly a page in RM, now a global
  *                   structure) and global var "currentBeam"
  *
@@ -70,12 +84,56 @@
  *              since only used by control.c
  * 27-Sep-2002: Freeze last guide values when stopping guide loop
  * 19-Oct-2017: Begin conversion to EPIS OSI (mdw)
+ * 17-Oct-2026: Replace the per source blocks in processGuides with a table
+ *              of guide source descriptors and a common guideSample kernel
+ * 17-Oct-2026: Filter guide samples with the fused three axis iir_filter3
+ * 17-Oct-2026: iir_filter, iir_filter3 and newDfilter use biquad sections
+ * 17-Oct-2026: Retune designed guide filters at the sensed guide rate (MK)
+ * 17-Oct-2026: frameConvert no longer takes the frame mutex
+ * 17-Oct-2026: frameConvert, focus scaling and gyro2m2 folded into one
+ *              precompiled affine transform per guide source
+ * 17-Oct-2026: Combine the guide sources in the fast loop (guideFusion)
+ * 17-Oct-2026: Mark the stages of processGuides for the latency recorder
+ * 17-Oct-2026: Configurable RM settle replaces the 1ms sleep after ISR3
+ * 17-Oct-2026: processGuides waits on ISR3 with a guide rate deadline
+ * 17-Oct-2026: Commands sent through command.c, paced by the M2 NR
+ * 17-Oct-2026: Frame checksums use checkSumFast
+ * 17-Oct-2026: Page 0 composed locally and committed in one copy
+ * 17-Oct-2026: Status frames published as snapshots read by readStatus
+ * 17-Oct-2026: Each pass of processGuides fed to the telemetry recorder
+ * 17-Oct-2026: Guide ring buffers merged into one ring of records sized
+ *              at boot (cbInit, cbColumn)
+ * 17-Oct-2026: scsReceive feeds the position history (archiveStatus),
+ *              projectSource interpolates it
+ * 17-Oct-2026: Per source WFS delay compensation in the fast loop
+ * 17-Oct-2026: slowTransmit interpolates all axes with getInterpolationAll
+ * 17-Oct-2026: TCS demands evaluated at the commit time of the frame that
+ *              carries them, apply errors kept by schedule.c
+ * 17-Oct-2026: Commands held until slowTransmit has copied the command
+ *              page into the image of page 0
+ * 17-Oct-2026: commandPageClear clears page 0 for the state machine
+ * 17-Oct-2026: processGuides asks the retune task for new filters and
+ *              swaps them in at the start of a pass
+ * 17-Oct-2026: RM settle poll spins for a multiple of the measured
+ *              arrival time, then sleeps
+ * 17-Oct-2026: slowTransmit keeps the set point while there is no
+ *              trajectory to interpolate
+ * 17-Oct-2026: processGuides runs every guideIdlePeriod with no guide
+ *              source, guideDeadlineMax lowered to 50ms
+ * 17-Oct-2026: writeCommandCar reports the completion of a command to a
+ *              CAR
+ * 17-Oct-2026: newDfilter keeps a direct form I section, its coefficients
+ *              change while it runs
  *
  */
 /* ===================================================================== */
 #include <string.h>     /* For strncpy */
 #include <math.h>       /* For abs */
 #include <stdio.h>      /* for sprintf() */
+#include <stdlib.h>     /* For calloc, labs */
+#include <stddef.h>     /* For offsetof */
+#include <time.h>       /* For clock_gettime */
+#include <epicsAtomic.h> /* For epicsAtomicGetIntT */
 
 #include <timeLib.h>    /* For timeNow */
 #include <vmi5588.h>    /* For rmIntSend */
@@ -90,6 +148,10 @@
 #include "interlock.h"  /* For lockPosition, scsState */
 #include "interp.h"     /* For AX, AY, ..., Z axis identifiers */
 #include "eventBus.h"   /* fo XYCARDNUM */
+#include "latency.h"    /* For latencyMark, latencyCommit */
+#include "command.h"    /* For commandNext, commandAcknowledge, commandSubmit */
+#include "telemetry.h"  /* For telemetryOn, telemetryPush */
+#include "schedule.h"   /* For scheduleDue, scheduleCommitted */
 
  /* Define limits for incremental steps */
 #define TILT_GUIDE_STEP_LIMIT   32.0   /* arcsec  */
@@ -319,9 +381,43 @@ static int positionUpdate = FALSE;
 int scstimeUpdate = 0; 
 long servoOnStatus;
 
+/* reflective memory settle after ISR3, see rmSettle */
+int rmSettleMode = RM_SETTLE_POLL;
+double rmSettleTimeout = 0.001;         /* longest settle (s)               */
+double rmSettleLast = 0.0;              /* last settle time (s)             */
+double rmSettleMax = 0.0;               /* longest settle seen (s)          */
+long rmSettleTimeouts = 0;              /* polls which timed out            */
+double rmSettleArrival = 0.0;           /* smoothed page arrival time (s)   */
+double rmSettleSpinFactor = 4.0;        /* spin for this many arrival times */
+double rmSettleSpinMin = 20.0e-6;       /* shortest spin (s)                */
+long rmSettleSleeps = 0;                /* polls which fell back to a sleep */
+
+/* processGuides wakeup deadline and load, see guideDeadline */
+double guideDeadlineFactor = 2.5;       /* guide periods before a miss      */
+double guideDeadlineMin = 0.005;        /* shortest deadline (s)            */
+double guideDeadlineMax = 0.05;         /* longest deadline (s)             */
+double guideIdlePeriod = 0.025;         /* pass period with no guide (s),
+                                           INT2 at 20Hz with sep = 0        */
+double guideWakeRate = 0.0;             /* smoothed ISR3 rate (Hz)          */
+double guideBusyTime = 0.0;             /* time spent processing (s)        */
+long guideWakeups = 0;                  /* passes woken by ISR3             */
+long guideDeadlineMisses = 0;           /* passes run on the deadline       */
+
+/* guide source fusion, see fuseGuides */
+int guideFusion = TRUE;                 /* combine sources in the fast loop */
+double guideFusionMaxAge = 0.1;         /* oldest sample combined (s)       */
+int guideFusionSources = 0;             /* sources in the last estimate     */
+double guideFusionVariance[MAX_AXES];   /* variance of the last estimate    */
+
+/* guide delay compensation, see guideDelayCompensate */
+int guideDelayComp[MAX_SOURCES];        /* TRUE to compensate the source    */
+double guideDelayMax = 0.05;            /* longest delay compensated (s)    */
+static double guideDelayLast[MAX_SOURCES];       /* last delay (s)          */
+static unsigned long guideDelayDone[MAX_SOURCES];
+static unsigned long guideDelayMissed[MAX_SOURCES];
+
 /* function prototypes */
-static int  frameConvert (converted *result, frameChange *f, const double x, 
-      const double y, const double z);
+static int fuseGuides (double now, double maxAge);
 
 
 #ifdef MK 
@@ -358,13 +454,54 @@ int flip = 0;      /* indicates whether or not beams s/b flipped
                            eg. 1 for sig gen; 0 for OSCIR. set to 1 at
                            crate console */
 
-double sampleData[5][3];
+/* newDfilter state per zernike, direct form I so that coeffData may
+ * change between samples */
+static struct
+{
+   double x1, x2;                    /* last two inputs                  */
+   double y1, y2;                    /* last two outputs                 */
+} newDfilterState[3];
 double coeffData[5][3];
 int nodeISR2 = 0;
 int nodeISR3 = 0;
 int guideType = AUTOGUIDE;
-epicsMessageQueueId commandQId = NULL;
 epicsMessageQueueId receiveQId = NULL;
+
+/* Local image of the M2 command page. processGuides and slowTransmit
+ * compose page 0 here under page0Free and processGuides commits it to
+ * reflective memory with one copy per frame, so M2 never sees a frame
+ * half written by the two tasks. The copy runs from the checksum to the
+ * end of the display fields; the pad is never written. */
+
+#ifdef __GNUC__
+#define CACHE_ALIGNED __attribute__ ((aligned (32)))
+#else
+#define CACHE_ALIGNED
+#endif
+
+#define PAGE0_COMMIT_SIZE offsetof(commandBlock, pad)
+
+static commandBlock page0Image CACHE_ALIGNED;
+epicsMutexId page0Free = NULL;
+
+/* Snapshots of the status page published by scsReceive. readStatus
+ * copies the latest without taking refMemFree; the sequence of a slot is
+ * odd while scsReceive is writing it. Only the words in use are copied,
+ * the pad is never touched. */
+
+#define STATUS_RING_SIZE 4
+#define STATUS_SNAPSHOT_SIZE offsetof(statusBlock, pad)
+
+typedef struct
+{
+   int         sequence;
+   int         generation;
+   statusBlock status;
+} statusSlot;
+
+static statusSlot statusRing[STATUS_RING_SIZE];
+static int statusLatest = 0;
+static int statusGeneration = 0;
 double tiptiltGuideLimitFactor = 1.0;
 double focusGuideLimitFactor = 1.0;
 
@@ -413,65 +550,17 @@ long vibrationYTrackOn = OFF;
 
 static int cbCounter=0;
 
-static float cbXRawGuide[CB_RECORD_NB];
-static float cbYRawGuide[CB_RECORD_NB];
-static float cbZRawGuide[CB_RECORD_NB];
-
-static double cbXGuideBeforePID[CB_RECORD_NB];
-static double cbYGuideBeforePID[CB_RECORD_NB];
-static double cbZGuideBeforePID[CB_RECORD_NB];
-
-static double cbXGuideAfterPID[CB_RECORD_NB];
-static double cbYGuideAfterPID[CB_RECORD_NB];
-static double cbZGuideAfterPID[CB_RECORD_NB];
-
-static double cbXGuideDemand[CB_RECORD_NB];
-static double cbYGuideDemand[CB_RECORD_NB];
-static double cbZGuideDemand[CB_RECORD_NB];
+/* One telemetrySample per pass of processGuides, written in one place so
+ * that a pass touches a few adjacent cache lines rather than one line in
+ * each of 35 separate arrays. The ring is allocated by cbInit with
+ * cbRecordNb records, which may be set in the startup script before
+ * initRefMem; cbColumn gives one field of it as a column. */
 
-static int cbCurBeam[CB_RECORD_NB];
-static int cbInPos[CB_RECORD_NB];
-static int cbApplyGuide[CB_RECORD_NB];
-static int cbGuideOnA[CB_RECORD_NB];
+int cbRecordNb = CB_RECORD_NB;
 
-static double cbTime[CB_RECORD_NB];
-static double cbP2Time[CB_RECORD_NB];
-static float cbP2Interval[CB_RECORD_NB];
-//static unsigned long cbTick[CB_RECORD_NB];
-
-static float cbAXDemand[CB_RECORD_NB];
-static float cbAYDemand[CB_RECORD_NB];
-static float cbBXDemand[CB_RECORD_NB];
-static float cbBYDemand[CB_RECORD_NB];
-
-#ifdef MK
-static double cbVTKXIntegrator0[CB_RECORD_NB];
-static double cbVTKXIntegrator1[CB_RECORD_NB];
-
-static double cbVTKYIntegrator0[CB_RECORD_NB];
-static double cbVTKYIntegrator1[CB_RECORD_NB];
-
-static double cbVTKXCommand[CB_RECORD_NB];
-static double cbVTKYCommand[CB_RECORD_NB];
-
-static double cbVTKXPhaseOld[CB_RECORD_NB];
-static double cbVTKXPhaseNew[CB_RECORD_NB];
-
-static double cbVTKYPhaseOld[CB_RECORD_NB];
-static double cbVTKYPhaseNew[CB_RECORD_NB];
-
-static double cbVTKXFrequency[CB_RECORD_NB];
-static double cbVTKYFrequency[CB_RECORD_NB];
-
-static double     cbVTKXFreqError[CB_RECORD_NB];
-static double    cbVTKYFreqError[CB_RECORD_NB];
-
-static double     cbVTKXdeltaPhase[CB_RECORD_NB];
-static double     cbVTKYdeltaPhase[CB_RECORD_NB];
-
-static double     cbXGuidePhasor[CB_RECORD_NB];
-static double     cbYGuidePhasor[CB_RECORD_NB];
-#endif
+static telemetrySample *cbRing = NULL;
+static int cbSize = 0;               /* records in cbRing                */
+static int cbCount = 0;              /* records written, up to cbSize    */
 
 
 void setNS(int value)
@@ -506,7 +595,7 @@ void setNS(int value)
  *
  * Globals:
  *    External functions:
- *    readArchive
+ *    archiveInterpolate
  *
  *    External variables:
  *    None
@@ -519,6 +608,7 @@ void setNS(int value)
  *
  * History:
  * 15-Oct-1997: Original(srp)
+ * 17-Oct-2026: Positions interpolated from the live position history
  *
  */
 
@@ -530,6 +620,7 @@ void projectSource (void)
    double xNow, yNow, zNow;
    double timeStamp;
    int source = PWFS1;
+   statusBlock status;
 
    m2History archiveEntry;
 
@@ -540,7 +631,7 @@ void projectSource (void)
 
    /* fetch the current TCS open loop demand value */
 
-   if (readArchive (&archiveEntry, timeStamp) == OK)
+   if (archiveInterpolate (&archiveEntry, timeStamp) == OK)
    {
       xNow = archiveEntry.setX;
       yNow = archiveEntry.setY;
@@ -571,7 +662,7 @@ void projectSource (void)
           */
 
          epicsMutexLock(wfsFree[source]);
-         if (readArchive (&archiveEntry, filtered[source].time) == OK)
+         if (archiveInterpolate (&archiveEntry, filtered[source].time) == OK)
          {
             deltaX = xNow - archiveEntry.setX;
             deltaY = yNow - archiveEntry.setY;
@@ -594,9 +685,10 @@ void projectSource (void)
             errorLog ("projectSource - can't retrieve archive position",
                      1, ON);
 
-            filtered[source].z1 = scsPtr->page1.xTilt + filtered[source].z1 + deltaX;
-            filtered[source].z2 = scsPtr->page1.yTilt + filtered[source].z2 + deltaY;
-            filtered[source].z3 = scsPtr->page1.zFocus + filtered[source].z3 + deltaZ;
+            readStatus (&status);
+            filtered[source].z1 = status.xTilt + filtered[source].z1 + deltaX;
+            filtered[source].z2 = status.yTilt + filtered[source].z2 + deltaY;
+            filtered[source].z3 = status.zFocus + filtered[source].z3 + deltaZ;
          }
          epicsMutexUnlock(wfsFree[source]);
       }
@@ -646,100 +738,16 @@ void projectSource (void)
  *              weight[][]
  * 06-Jan-1998: Allow selection of AUTOGUIDE to use filtered only or not 
  *              AUTOGUIDE to use projected guide values
+ * 17-Oct-2026: Use fuseGuides, the blended value was computed but the
+ *              last source was returned
  */
 
 /* ===================================================================== */
 
 void blendSources (void)
 {
-   int source;
-   double Kx, Ky, Kz;
-   double varianceX = DEFAULT_VARIANCE;
-   double varianceY = DEFAULT_VARIANCE;
-   double varianceZ = DEFAULT_VARIANCE;
-   double netVarX = DEFAULT_VARIANCE;
-   double netVarY = DEFAULT_VARIANCE; 
-   double netVarZ = DEFAULT_VARIANCE;
-   int first = TRUE;
-
-   for (source = PWFS1; source <= GYRO; source++)
-   {
-      if (weight[source][currentBeam] < -1)
-      {
-         /* guide source not used */
-         continue;
-      }
-      else if (weight[source][currentBeam] >= 0)
-      {
-
-         /* calculate variance from user entry of standard error */
-
-         varianceX = weight[source][currentBeam] * 
-            weight[source][currentBeam];
-         varianceY = varianceX;
-         varianceZ = varianceX;
-      }
-      else if (weight[source][currentBeam] >= -1)
-      {
-         /*
-          * calculate variance from value supplied by guide source
-          */
-
-         if (filtered[source].err1 >= 0)
-            varianceX = filtered[source].err1 * filtered[source].err1;
-         else
-            varianceX = DEFAULT_VARIANCE;
-
-         if (filtered[source].err1 >= 0)
-            varianceY = filtered[source].err2 * filtered[source].err2;
-         else
-            varianceY = DEFAULT_VARIANCE;
-
-         if (filtered[source].err3 >= 0)
-            varianceZ = filtered[source].err3 * filtered[source].err3;
-         else
-            varianceZ = DEFAULT_VARIANCE;
-      }
-      else
-      {
-         /* this guide source is not used for this beam */
-
-         continue;
-      }
-
-      /* range check the variances */
-
-      varianceX = confine (varianceX, COVAR_MAX, COVAR_MIN);
-      varianceY = confine (varianceY, COVAR_MAX, COVAR_MIN);
-      varianceZ = confine (varianceZ, COVAR_MAX, COVAR_MIN);
-
-      if (first == TRUE)
-      {
-         /* the first guide source to report does not need combining */
-
-         netVarX = varianceX;
-         netVarY = varianceY;
-         netVarZ = varianceZ;
-
-         Kx = 1; Ky = 1; Kz = 1;
-         first = FALSE;
-      }
-      else
-      {
-         Kx = netVarX / (netVarX + varianceX);
-         netVarX = (1 - Kx) * netVarX;
-
-         Ky = netVarY / (netVarY + varianceY);
-         netVarY = (1 - Ky) * netVarY;
-
-         Kz = netVarZ / (netVarZ + varianceZ);
-         netVarZ = (1 - Kz) * netVarZ;
-      }
-
-      xNetGuide = (double) filtered[source].z1;
-      yNetGuide = (double) filtered[source].z2;
-      zNetGuide = (double) filtered[source].z3;
-   }
+   /* every source used for this beam, whatever the age of its sample */
+   fuseGuides (0.0, 0.0);
 
 #if 0
    if (debugLevel == DEBUG_RESERVED2)
@@ -814,78 +822,1156 @@ static void reportTimes() {
       result.tv_nsec = timeEnd.tv_nsec - timeStart.tv_nsec;
    }
 
-   errlogPrintf("Elapsed time: %ld:%ld\n",result.tv_sec, result.tv_nsec);
+   errlogPrintf("Elapsed time: %ld:%ld\n",result.tv_sec, result.tv_nsec);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * fireLoops
+ *
+ * Purpose:
+ * Watchdog timer to fire to provide a semaphore at the loop sample rate
+ *
+ * Invocation:
+ * fireLoops
+ *
+ * Parameters in:
+ * None
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ * < status        int     OK or ERROR
+ *
+ * Globals:
+ *    External functions:
+ *    None
+ *
+ *    External variables:
+ *    None
+ *
+ * Requirements:
+ *
+ * Author:
+ * Sean Prior  (srp@roe.ac.uk)
+ *
+ * History:
+ * 15-Oct-1997: Original(srp)
+ * 06-Dec-2017: Converted to a thread that runs periodically (mdw)
+ *
+ */
+
+/* ===================================================================== */
+void fireLoops (void *param)
+{
+
+   while (1){
+      /* translation demands update to m2 system at 1Hz */
+      /* set flag to indicate position update */
+      positionUpdate = TRUE;
+      epicsThreadSleep(1.0);
+   }
+}
+
+
+/* Later: add header */
+void rmISR2 (int node)
+{
+   nodeISR2 = node;
+   epicsEventSignal(scsReceiveNow);
+
+   /* why is this commented out? This is the only place the 
+    * event is signalled. 20171030 (mdw) */ 
+   /*
+   semGive (cemTimerEndSem);
+   */
+}
+
+/* Later: add header */
+void rmISR3 (int node)
+{
+   nodeISR3 = node;
+   latencyMark(LATENCY_ISR);
+   epicsEventSignal(guideUpdateNow);
+}
+
+/* ===================================================================== */
+/*
+ * Guide source descriptors
+ *
+ * Each entry ties the reflective memory node that raises ISR3 to the
+ * wfsBlock page, update bookkeeping, frame change and filter bank of one
+ * guide source. Entries are kept in source enum order so that
+ * guideSources[source] describes that source; processGuides finds the
+ * entry for the interrupting node and runs the common guideSample kernel.
+ */
+/* ===================================================================== */
+
+#define GUIDE_NO_NODE           -1
+#define GUIDE_MAX_NODES         16      /* RM node ids are 0..15 */
+
+typedef struct guideSource guideSource;
+
+/* WFS to M2 coordinate conversion of a source folded into one affine
+ * transform, recompiled only when the frames it was built from change */
+
+typedef struct
+{
+   double         matrix[MAX_AXES][MAX_AXES];
+   double         offset[MAX_AXES];
+   int            valid;         /* compiled at least once               */
+   int            frameSequence; /* ag2m2 update count compiled from,
+                                    -1 if there was no ag2m2 frame       */
+   int            frameRevision; /* frameOfReference revision compiled   */
+} guideTransform;
+
+typedef void (*guideCompileFn) (const guideSource *src, guideTransform *t);
+
+struct guideSource
+{
+   char           *name;
+   int            source;        /* index into filtered, filter, ag2m2   */
+   int            weightSource;  /* weight[] row gating this source      */
+   int            node;          /* RM node raising ISR3                 */
+   int            altNode;       /* second RM node sharing the page      */
+   size_t         page;          /* offset of the wfsBlock in memMap     */
+   float          *lastInterval; /* last interval processed, NULL if the
+                                    source is polled on time instead     */
+   double         lastTime;      /* time stamp of last sample processed  */
+   double         received;      /* local time latest sample arrived     */
+   guideCompileFn compile;       /* builds the WFS to M2 transform       */
+   guideTransform transform;     /* current WFS to M2 transform          */
+};
+
+static void wfsCompile (const guideSource *src, guideTransform *t);
+static void oiwfsCompile (const guideSource *src, guideTransform *t);
+static void gyroCompile (const guideSource *src, guideTransform *t);
+
+static guideSource guideSources[MAX_SOURCES] =
+{
+   {"PWFS1", PWFS1, PWFS1, AGP1_NODE, GUIDE_NO_NODE,
+      offsetof(memMap, pwfs1), &updateInterval.pwfs1, 0.0, 0.0, wfsCompile},
+   {"PWFS2", PWFS2, PWFS2, AGP2_NODE, GUIDE_NO_NODE,
+      offsetof(memMap, pwfs2), &updateInterval.pwfs2, 0.0, 0.0, wfsCompile},
+#ifdef MK
+   {"OIWFS", OIWFS, OIWFS, AGOI_NODE, GUIDE_NO_NODE,
+      offsetof(memMap, oiwfs), &updateInterval.oiwfs, 0.0, 0.0, oiwfsCompile},
+#else
+   {"OIWFS", OIWFS, OIWFS, AGOI_NODE, F2OI_NODE,
+      offsetof(memMap, oiwfs), &updateInterval.oiwfs, 0.0, 0.0, oiwfsCompile},
+#endif
+   {"GAOS",  GAOS,  GAOS,  GAOS_NODE, GUIDE_NO_NODE,
+      offsetof(memMap, gaos),  &updateInterval.gaos,  0.0, 0.0, wfsCompile},
+#ifndef MK
+   /* GPI has always been gated by the OIWFS weights */
+   {"GPI",   GPI,   OIWFS, GPI_NODE,  GUIDE_NO_NODE,
+      offsetof(memMap, gpi),   &updateInterval.gpi,   0.0, 0.0, wfsCompile},
+#endif
+   {"GYRO",  GYRO,  GYRO,  GUIDE_NO_NODE, GUIDE_NO_NODE,
+      offsetof(memMap, gyro),  NULL,                  0.0, 0.0, gyroCompile}
+};
+
+static guideSource *guideSourceByNode[GUIDE_MAX_NODES];
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * initGuideSources
+ *
+ * Purpose:
+ * Check the guide source table and build the node to source lookup
+ *
+ * Invocation:
+ * status = initGuideSources()
+ *
+ * Return value:
+ *      < status    int      OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int initGuideSources (void)
+{
+   int i;
+   int status = OK;
+
+   for (i = 0; i < GUIDE_MAX_NODES; i++)
+      guideSourceByNode[i] = NULL;
+
+   for (i = 0; i < MAX_SOURCES; i++)
+   {
+      if (guideSources[i].source != i)
+      {
+         sprintf (errBuff, "initGuideSources - %s out of order\n",
+               guideSources[i].name);
+         errorLog (errBuff, 1, ON);
+         status = ERROR;
+         continue;
+      }
+
+      if (guideSources[i].node >= 0 && guideSources[i].node < GUIDE_MAX_NODES)
+         guideSourceByNode[guideSources[i].node] = &guideSources[i];
+
+      if (guideSources[i].altNode >= 0 && 
+            guideSources[i].altNode < GUIDE_MAX_NODES)
+         guideSourceByNode[guideSources[i].altNode] = &guideSources[i];
+   }
+
+   return status;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * lookupGuideSource
+ *
+ * Purpose:
+ * Return the guide source descriptor for the node which raised ISR3, or
+ * NULL if the node is not a guide source (nodeISR3 is set to -99 by
+ * updateEventPage)
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static guideSource *lookupGuideSource (const int node)
+{
+   if (node < 0 || node >= GUIDE_MAX_NODES)
+      return NULL;
+
+   return guideSourceByNode[node];
+}
+
+static wfsBlock *guidePage (const guideSource *src)
+{
+   return (wfsBlock *) ((char *) scsBase + src->page);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * wfsCompile, oiwfsCompile, gyroCompile
+ *
+ * Purpose:
+ * Build the transform taking the z1, z2, z3 of a guide page into M2
+ * coordinates. WFS sources use their ag2m2 frame (rotate, scale, offset),
+ * the OIWFS focus term is additionally scaled by frame.focusScaling and
+ * the gyro uses the gyro frame of reference as gyro2m2 does.
+ *
+ * History:
+ * 17-Oct-2026: Original, replace wfsConvert, oiwfsConvert and gyroConvert
+ *
+ */
+/* ===================================================================== */
+
+static void wfsCompile (const guideSource *src, guideTransform *t)
+{
+   frameChange *f = ag2m2[src->source];
+   frameData grab;
+
+   memset (t->matrix, 0, sizeof (t->matrix));
+   memset (t->offset, 0, sizeof (t->offset));
+
+   if (f == NULL)
+   {
+      errlogMessage("frame conversion pointers not initialised\n");
+      return;
+   }
+
+   readFrame (f, &grab);
+
+   t->matrix[0][0] = grab.scaleX * grab.cosTheta;
+   t->matrix[0][1] = -grab.scaleX * grab.sinTheta;
+   t->matrix[1][0] = grab.scaleY * grab.sinTheta;
+   t->matrix[1][1] = grab.scaleY * grab.cosTheta;
+   t->matrix[2][2] = grab.scaleZ;
+   t->offset[0] = grab.offsetX;
+   t->offset[1] = grab.offsetY;
+}
+
+static void oiwfsCompile (const guideSource *src, guideTransform *t)
+{
+   wfsCompile (src, t);
+
+   /* do focus scaling conversion */
+   t->matrix[2][2] *= frame.focusScaling;
+}
+
+static void gyroCompile (const guideSource *src, guideTransform *t)
+{
+   memset (t->matrix, 0, sizeof (t->matrix));
+   memset (t->offset, 0, sizeof (t->offset));
+
+   t->matrix[0][0] = frame.gyroCosTheta;
+   t->matrix[0][1] = -frame.gyroSinTheta;
+   t->matrix[1][0] = frame.gyroSinTheta;
+   t->matrix[1][1] = frame.gyroCosTheta;
+   t->matrix[2][2] = frame.focusScaling;
+   t->offset[0] = frame.gyroOffsetX;
+   t->offset[1] = frame.gyroOffsetY;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * guideTransformFor
+ *
+ * Purpose:
+ * Return the WFS to M2 transform of a source, compiling it again first
+ * if modifyFrame has changed the source frame or frameOfReferenceChanged
+ * has been called since it was last compiled. A source without an ag2m2
+ * frame (the gyro, or a WFS before its frame is created) is compiled once
+ * and kept until the frame appears, so a missing frame is logged once.
+ *
+ * Invocation:
+ * t = guideTransformFor(src)
+ *
+ * Parameters in:
+ *      > src       guideSource*      descriptor of the source
+ *
+ * Return value:
+ *      < t         guideTransform*   transform of the source
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Keep the transform compiled without an ag2m2 frame
+ *
+ */
+/* ===================================================================== */
+
+static const guideTransform *guideTransformFor (guideSource *src)
+{
+   guideTransform *t = &src->transform;
+   int sequence = -1;
+   int revision;
+
+   /* note the versions before reading the frames so that an update
+    * made while compiling is picked up next time */
+   if (ag2m2[src->source] != NULL)
+      sequence = epicsAtomicGetIntT (&ag2m2[src->source]->sequence);
+
+   revision = epicsAtomicGetIntT (&frameRevision);
+
+   if (!t->valid || t->frameSequence != sequence ||
+         t->frameRevision != revision)
+   {
+      src->compile (src, t);
+
+      /* -1 stands for no frame, compiled again when the frame appears */
+      t->frameSequence = sequence;
+      t->frameRevision = revision;
+      t->valid = TRUE;
+   }
+
+   return t;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * sourceVariance
+ *
+ * Purpose:
+ * Variances of the latest sample of a guide source for the current beam,
+ * from the standard error entered as its weight or, for a weight of -1,
+ * from the errors reported by the source itself
+ *
+ * Invocation:
+ * used = sourceVariance(src, variance)
+ *
+ * Parameters in:
+ *      > src       guideSource*  descriptor of the source
+ *
+ * Parameters out:
+ *      < variance  double[3]     x, y and z variances
+ *
+ * Return value:
+ *      < used      int           FALSE if the source is not used for the
+ *                                current beam
+ *
+ * History:
+ * 17-Oct-2026: Original, split out of blendSources
+ *
+ */
+/* ===================================================================== */
+
+static int sourceVariance (const guideSource *src, double variance[MAX_AXES])
+{
+   const double w = weight[src->weightSource][currentBeam];
+   const wfs *sample = &filtered[src->source];
+
+   if (w < -1)
+   {
+      /* guide source not used */
+      return FALSE;
+   }
+   else if (w >= 0)
+   {
+      /* calculate variance from user entry of standard error */
+      variance[XTILT] = w * w;
+      variance[YTILT] = variance[XTILT];
+      variance[ZFOCUS] = variance[XTILT];
+   }
+   else
+   {
+      /* calculate variance from value supplied by guide source */
+      variance[XTILT] = (sample->err1 >= 0) ? 
+         sample->err1 * sample->err1 : DEFAULT_VARIANCE;
+      variance[YTILT] = (sample->err2 >= 0) ? 
+         sample->err2 * sample->err2 : DEFAULT_VARIANCE;
+      variance[ZFOCUS] = (sample->err3 >= 0) ? 
+         sample->err3 * sample->err3 : DEFAULT_VARIANCE;
+   }
+
+   /* range check the variances */
+   variance[XTILT] = confine (variance[XTILT], COVAR_MAX, COVAR_MIN);
+   variance[YTILT] = confine (variance[YTILT], COVAR_MAX, COVAR_MIN);
+   variance[ZFOCUS] = confine (variance[ZFOCUS], COVAR_MAX, COVAR_MIN);
+
+   return TRUE;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * fuseGuides
+ *
+ * Purpose:
+ * Combine the latest samples of the guide sources used for the current
+ * beam into xNetGuide, yNetGuide and zNetGuide. Each source is folded in
+ * with the gain K = P / (P + R), P being the variance of the estimate so
+ * far and R that of the source, so the result is the minimum variance
+ * combination of the sources. Sources whose latest sample was received
+ * more than maxAge seconds before now are left out; a maxAge of zero or
+ * less uses every source.
+ *
+ * Invocation:
+ * used = fuseGuides(now, maxAge)
+ *
+ * Parameters in:
+ *      > now       double   current time (s)
+ *      > maxAge    double   oldest sample to use (s)
+ *
+ * Return value:
+ *      < used      int      number of sources combined, the net guides
+ *                           are unchanged if this is zero
+ *
+ * Globals:
+ *    External variables:
+ *    filtered, weight, currentBeam, guideFusionVariance,
+ *    xNetGuide, yNetGuide, zNetGuide
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int fuseGuides (double now, double maxAge)
+{
+   const guideSource *src;
+   double variance[MAX_AXES];
+   double net[MAX_AXES];
+   double netVar[MAX_AXES];
+   double z[MAX_AXES];
+   double K;
+   int source, axis;
+   int used = 0;
+
+   for (source = PWFS1; source <= GYRO; source++)
+   {
+      src = &guideSources[source];
+
+      if (maxAge > 0.0 && (src->received <= 0.0 || 
+               now - src->received > maxAge))
+         continue;
+
+      if (!sourceVariance (src, variance))
+         continue;
+
+      z[XTILT] = (double) filtered[source].z1;
+      z[YTILT] = (double) filtered[source].z2;
+      z[ZFOCUS] = (double) filtered[source].z3;
+
+      for (axis = 0; axis < MAX_AXES; axis++)
+      {
+         if (used == 0)
+         {
+            /* the first guide source does not need combining */
+            net[axis] = z[axis];
+            netVar[axis] = variance[axis];
+         }
+         else
+         {
+            K = netVar[axis] / (netVar[axis] + variance[axis]);
+            net[axis] += K * (z[axis] - net[axis]);
+            netVar[axis] = (1 - K) * netVar[axis];
+         }
+      }
+
+      used++;
+   }
+
+   if (used > 0)
+   {
+      xNetGuide = net[XTILT];
+      yNetGuide = net[YTILT];
+      zNetGuide = net[ZFOCUS];
+
+      guideFusionVariance[XTILT] = netVar[XTILT];
+      guideFusionVariance[YTILT] = netVar[YTILT];
+      guideFusionVariance[ZFOCUS] = netVar[ZFOCUS];
+   }
+
+   guideFusionSources = used;
+
+   return used;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * guideDelayCompensate
+ *
+ * Purpose:
+ * Remove from a guide sample, already in M2 coordinates, the mirror motion
+ * which the WFS has not yet seen: the change of the M2 position between
+ * the WFS exposure time and now, less the change of the TCS demands over
+ * the same time. Both ends are interpolated from the position history fed
+ * by scsReceive. Samples older than guideDelayMax, or outside the history,
+ * are left alone and counted as missed.
+ *
+ * Invocation:
+ * done = guideDelayCompensate(source, exposure, xyz)
+ *
+ * Parameters in:
+ *      > source    int      guide source index
+ *      > exposure  double   WFS time stamp of the sample
+ *
+ * Parameters in/out:
+ *      ! xyz       double[MAX_AXES]   guide sample, compensated
+ *
+ * Return value:
+ *      < done      int      TRUE if the sample was compensated
+ *
+ * Globals:
+ *    External functions:
+ *    archiveInterpolate
+ *
+ *    External variables:
+ *    guideDelayComp, guideDelayMax
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int guideDelayCompensate (int source, double exposure,
+      double xyz[MAX_AXES])
+{
+   m2History then, latest;
+   double now, delay;
+
+   if (!guideDelayComp[source])
+      return FALSE;
+
+   if (timeNow (&now) != OK)
+   {
+      guideDelayMissed[source]++;
+      return FALSE;
+   }
+
+   delay = now - exposure;
+
+   if (delay < 0.0 || delay > guideDelayMax ||
+         archiveInterpolate (&then, exposure) != OK ||
+         archiveInterpolate (&latest, now) != OK)
+   {
+      guideDelayMissed[source]++;
+      return FALSE;
+   }
+
+   xyz[XTILT] -= (latest.xTilt - then.xTilt) - (latest.setX - then.setX);
+   xyz[YTILT] -= (latest.yTilt - then.yTilt) - (latest.setY - then.setY);
+   xyz[ZFOCUS] -= (latest.zFocus - then.zFocus) - (latest.setZ - then.setZ);
+
+   guideDelayLast[source] = delay;
+   guideDelayDone[source]++;
+
+   return TRUE;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * guideDelayShow
+ *
+ * Purpose:
+ * Report the guide delay compensation of each source
+ *
+ * Invocation:
+ * status = guideDelayShow()
+ *
+ * Return value:
+ *      < status    int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int guideDelayShow (void)
+{
+   int i, source;
+
+   printf ("guide delay compensation, max delay %.3f s\n", guideDelayMax);
+   printf ("source  on   last delay (ms)  compensated      missed\n");
+
+   for (i = 0; i < MAX_SOURCES; i++)
+   {
+      source = guideSources[i].source;
+      printf ("%-6s  %-3s  %15.2f  %11lu  %10lu\n", guideSources[i].name,
+            guideDelayComp[source] ? "yes" : "no",
+            guideDelayLast[source] * 1000.0,
+            guideDelayDone[source], guideDelayMissed[source]);
+   }
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * guideSample
+ *
+ * Purpose:
+ * Common guide kernel: convert one guide page into M2 coordinates, store
+ * it in filtered[], run it through the source filter bank and make it the
+ * current net guide, combined with the other sources guiding if
+ * guideFusion is on
+ *
+ * Invocation:
+ * guideSample(src, page)
+ *
+ * Parameters in:
+ *      > src       guideSource*  descriptor of the source
+ *      > page      wfsBlock*     reflective memory page of the source
+ *
+ * Globals:
+ *    External variables:
+ *    filtered, xNetGuide, yNetGuide, zNetGuide,
+ *    guideFusion, guideFusionMaxAge
+ *
+ * History:
+ * 17-Oct-2026: Original, replaces the per source blocks in processGuides
+ * 17-Oct-2026: Combine the sources with fuseGuides
+ * 17-Oct-2026: Compensate the WFS delay with guideDelayCompensate
+ * 17-Oct-2026: Run the active fused filter from guideFilter
+ *
+ */
+/* ===================================================================== */
+
+static void guideSample (guideSource *src, const wfsBlock *page)
+{
+   wfs *sample = &filtered[src->source];
+   const guideTransform *t;
+   FUSED_IIR *fused;
+   double in[MAX_AXES];
+   double xyz[MAX_AXES];
+
+   /* convert the data from reflective memory page to M2 coordinates */
+   t = guideTransformFor (src);
+
+   in[XTILT] = (double) page->z1;
+   in[YTILT] = (double) page->z2;
+   in[ZFOCUS] = (double) page->z3;
+
+   xyz[XTILT] = t->matrix[0][0] * in[0] + t->matrix[0][1] * in[1] +
+      t->matrix[0][2] * in[2] + t->offset[0];
+   xyz[YTILT] = t->matrix[1][0] * in[0] + t->matrix[1][1] * in[1] +
+      t->matrix[1][2] * in[2] + t->offset[1];
+   xyz[ZFOCUS] = t->matrix[2][0] * in[0] + t->matrix[2][1] * in[1] +
+      t->matrix[2][2] * in[2] + t->offset[2];
+
+   /* take out the mirror motion since the WFS exposure */
+   guideDelayCompensate (src->source, (double) page->time, xyz);
+
+   sample->z1 = xyz[XTILT];
+   sample->z2 = xyz[YTILT];
+   sample->z3 = xyz[ZFOCUS];
+   latencyMark (LATENCY_CONVERTED);
+
+   sample->err1 = page->err1;
+   sample->err2 = page->err2;
+   sample->err3 = page->err3;
+   sample->time = page->time;
+
+   /* filter the transformed demands */
+   fused = guideFilter (src->source);
+   switch (fused->type)
+   {
+      case RAW:
+      case NOTUSED:
+         break;
+
+      default:
+         xyz[XTILT] = (double) sample->z1;
+         xyz[YTILT] = (double) sample->z2;
+         xyz[ZFOCUS] = (double) sample->z3;
+
+         iir_filter3 (xyz, fused);
+
+         sample->z1 = xyz[XTILT];
+         sample->z2 = xyz[YTILT];
+         sample->z3 = xyz[ZFOCUS];
+   }
+
+   latencyMark (LATENCY_FILTERED);
+
+   if (timeNow (&src->received) != OK)
+      src->received = 0.0;
+
+   /* combine with the latest samples of the other sources */
+   if (guideFusion && src->received > 0.0 &&
+         fuseGuides (src->received, guideFusionMaxAge) > 0)
+      return;
+
+   /* or just take this source */
+   xNetGuide = (double) sample->z1;
+   yNetGuide = (double) sample->z2;
+   zNetGuide = (double) sample->z3;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * rmSettle
+ *
+ * Purpose:
+ * Give the reflective memory page of the source which raised ISR3 time
+ * to arrive before it is read. rmSettleMode selects
+ *
+ *   RM_SETTLE_NONE   read the page straight away
+ *   RM_SETTLE_POLL   spin until the interval field of the page changes,
+ *                    for at most rmSettleSpinFactor times the measured
+ *                    arrival time (rmSettleArrival), then sleep for the
+ *                    rest of rmSettleTimeout rather than spin at the
+ *                    priority of processGuides. A sleep costs at least a
+ *                    clock tick, so if less than a tick is left the spin
+ *                    carries on up to rmSettleTimeout instead
+ *   RM_SETTLE_SLEEP  epicsThreadSleep(rmSettleTimeout), the old
+ *                    behaviour which costs at least one clock tick
+ *
+ * The time spent is kept in rmSettleLast and rmSettleMax (s), polls which
+ * fall back to a sleep are counted in rmSettleSleeps and those which
+ * time out in rmSettleTimeouts; see rmSettleShow. rmSettleArrival only
+ * averages pages which had not arrived when the poll started, and a page
+ * which only arrives after the sleep doubles the next spin, so the spin
+ * follows a slower reflective memory.
+ *
+ * Invocation:
+ * rmSettle(src)
+ *
+ * Parameters in:
+ *      > src       guideSource*  source which raised ISR3, or NULL
+ *
+ * History:
+ * 17-Oct-2026: Original, replaces the 1ms sleep in processGuides
+ * 17-Oct-2026: Spin bounded by the measured arrival time, then sleep
+ * 17-Oct-2026: Average only the pages waited for, never sleep for less
+ *              than a clock tick
+ *
+ */
+/* ===================================================================== */
+
+static void rmSettle (const guideSource *src)
+{
+   volatile float *interval;
+   double start, elapsed, spin;
+   int late;
+
+   if (rmSettleMode == RM_SETTLE_NONE)
+      return;
+
+   start = monotonicNow ();
+
+   if (rmSettleMode == RM_SETTLE_SLEEP)
+   {
+      epicsThreadSleep (rmSettleTimeout);
+   }
+   else if (src != NULL && src->lastInterval != NULL)
+   {
+      /* the page is complete when its interval has moved on */
+      interval = &guidePage (src)->interval;
+
+      /* a page already there says nothing about the arrival time */
+      if (*interval <= *src->lastInterval)
+      {
+         /* spin only for as long as a page usually takes to arrive */
+         spin = (rmSettleArrival > 0.0) ?
+            rmSettleSpinFactor * rmSettleArrival : rmSettleTimeout;
+         if (spin < rmSettleSpinMin)
+            spin = rmSettleSpinMin;
+         if (spin > rmSettleTimeout)
+            spin = rmSettleTimeout;
+
+         while (*interval <= *src->lastInterval &&
+               monotonicNow () - start <= spin)
+            ;
+
+         elapsed = monotonicNow () - start;
+         late = FALSE;
+
+         if (*interval <= *src->lastInterval)
+         {
+            if (rmSettleTimeout - elapsed >= epicsThreadSleepQuantum ())
+            {
+               /* give the CPU away for the rest of the timeout */
+               rmSettleSleeps++;
+               epicsThreadSleep (rmSettleTimeout - elapsed);
+               late = TRUE;
+            }
+            else
+            {
+               /* less than a tick left, a sleep would cost more */
+               while (*interval <= *src->lastInterval &&
+                     monotonicNow () - start <= rmSettleTimeout)
+                  ;
+               elapsed = monotonicNow () - start;
+            }
+         }
+
+         if (*interval <= *src->lastInterval)
+         {
+            rmSettleTimeouts++;
+         }
+         else if (late)
+         {
+            /* arrival time unknown, double the spin next time */
+            rmSettleArrival = 2.0 * spin / rmSettleSpinFactor;
+            if (rmSettleArrival * rmSettleSpinFactor > rmSettleTimeout)
+               rmSettleArrival = rmSettleTimeout / rmSettleSpinFactor;
+         }
+         else
+         {
+            rmSettleArrival = (rmSettleArrival > 0.0) ?
+               0.9 * rmSettleArrival + 0.1 * elapsed : elapsed;
+         }
+      }
+   }
+
+   elapsed = monotonicNow () - start;
+
+   rmSettleLast = elapsed;
+   if (elapsed > rmSettleMax)
+      rmSettleMax = elapsed;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * rmSettleShow
+ *
+ * Purpose:
+ * Print the reflective memory settle mode and the settle times measured,
+ * and clear the maximum
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int rmSettleShow (void)
+{
+   static const char *modeName[] = {"none", "poll", "sleep"};
+
+   printf ("RM settle mode %s, timeout %.0f us\n",
+         (rmSettleMode >= RM_SETTLE_NONE && rmSettleMode <= RM_SETTLE_SLEEP) ?
+         modeName[rmSettleMode] : "unknown", rmSettleTimeout * 1.0e6);
+   printf ("last %.1f us, max %.1f us, %ld poll timeouts\n",
+         rmSettleLast * 1.0e6, rmSettleMax * 1.0e6, rmSettleTimeouts);
+   printf ("arrival %.1f us, spin up to %.0f x arrival, %ld sleeps\n",
+         rmSettleArrival * 1.0e6, rmSettleSpinFactor, rmSettleSleeps);
+
+   rmSettleMax = 0.0;
+
+   return OK;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandPageInit
+ *
+ * Purpose:
+ * Create page0Free and load the local image of page 0 from reflective
+ * memory, so that fields no task writes keep their values. Must be called
+ * once scsBase is set and before processGuides and slowTransmit start.
+ *
+ * Invocation:
+ * status = commandPageInit()
+ *
+ * Return value:
+ *      < status    int      OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int commandPageInit (void)
+{
+   if ((page0Free = epicsMutexCreate ()) == NULL)
+   {
+      errorLog ("commandPageInit - error creating page0Free mutex", 1, ON);
+      return ERROR;
+   }
+
+   memcpy ((void *) &page0Image, (void *) &scsBase->page0, PAGE0_COMMIT_SIZE);
+
+   return OK;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * pageClear
+ *
+ * Purpose:
+ * Clear the demands and parameters of a command page. With xyOnly set
+ * only the XY positioner fields are cleared.
+ *
+ * History:
+ * 17-Oct-2026: Original, from the state machine startInit and startInitXY
+ *
+ */
+/* ===================================================================== */
+
+static void pageClear (commandBlock *page, int xyOnly, double xDemand, 
+      double yDemand, double deadband)
+{
+   page->xDemand = xDemand;
+   page->yDemand = yDemand;
+   page->xPositionTolerance = 0.0;
+   page->yPositionTolerance = 0.0;
+   page->xTcsMinRange = 0.0;
+   page->yTcsMinRange = 0.0;
+   page->xTcsMaxRange = 0.0;
+   page->yTcsMaxRange = 0.0; 
+   page->xPMinRange = 0.0;
+   page->yPMinRange = 0.0;
+   page->xPMaxRange = 0.0;
+   page->yPMaxRange = 0.0; 
+   page->xy_motor = 0;
+   page->xydir = 0;
+   page->xysteps = 0;
+   page->xyPositionDeadband = deadband;
+
+   if (xyOnly)
+      return;
+
+   page->AxTilt = 0.0;
+   page->BxTilt = 0.0;
+   page->CxTilt = 0.0;
+   page->AyTilt = 0.0;
+   page->ByTilt = 0.0;
+   page->CyTilt = 0.0;
+   page->xTiltGuide = 0.0;
+   page->yTiltGuide = 0.0;
+   page->zFocusGuide = 0.0; 
+   page->centralBaffle = 0; 
+   page->deployBaffle = 0;
+   page->chopProfile = 0;
+   page->chopFrequency = 0.0;
+   page->chopDutyCycle = 0.0;
+   page->xTiltTolerance = 0.0;
+   page->yTiltTolerance = 0.0;
+   page->zFocusTolerance = 0.0;
+   page->bandwidth = 0.0;
+   page->xTiltGain = 0.0;
+   page->yTiltGain = 0.0;
+   page->zFocusGain = 0.0;
+   page->xTiltShift = 0.0;
+   page->yTiltShift = 0.0;
+   page->zFocusShift = 0.0;
+   page->xTiltSmooth = 0.0;
+   page->yTiltSmooth = 0.0;
+   page->zFocusSmooth = 0.0;
+   page->follower = 0;
+   page->foldir = 0;
+   page->followersteps = 0;
+   page->offloader = 0;
+   page->ofldir = 0;
+   page->offloadersteps = 0;
+   page->cbafdir = 0;
+   page->cbsteps = 0;
+   page->deployable_baffle = 0;
+   page->dbafdir = 0;
+   page->dbsteps = 0;
+   page->zFocus = 0.0; 
+   page->zGuide = 0.0; 
+   page->rawXGuide = 0.0;
+   page->rawYGuide = 0.0;
+   page->rawZGuide = 0.0;
+   page->xGrossTiltDmd = 0.0;
+   page->yGrossTiltDmd = 0.0;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * commandPageClear
+ *
+ * Purpose:
+ * Clear the demands and parameters sent to M2, for the initialisation
+ * states of the state machine. The command page (scsPtr) is cleared so
+ * that slowTransmit keeps the parameters cleared, and the image of page 0
+ * so that the next frame committed by processGuides carries them.
+ *
+ * Invocation:
+ * status = commandPageClear(xyOnly, xDemand, yDemand, deadband)
+ *
+ * Parameters in:
+ *      > xyOnly    int      TRUE to clear only the XY positioner fields
+ *      > xDemand   double   XY positioner demand
+ *      > yDemand   double
+ *      > deadband  double   XY position deadband
+ *
+ * Return value:
+ *      < status    int      OK
+ *
+ * History:
+ * 17-Oct-2026: Original, the state machine wrote scsBase->page0 directly
+ *
+ */
+/* ===================================================================== */
+
+int commandPageClear (int xyOnly, double xDemand, double yDemand, 
+      double deadband)
+{
+   epicsMutexLock(refMemFree);
+   pageClear (&scsPtr->page0, xyOnly, xDemand, yDemand, deadband);
+   epicsMutexUnlock(refMemFree);
+
+   epicsMutexLock(page0Free);
+   pageClear (&page0Image, xyOnly, xDemand, yDemand, deadband);
+   epicsMutexUnlock(page0Free);
+
+   return OK;
 }
 
 /* ===================================================================== */
 /*
  * Function name:
- * fireLoops
+ * guideDeadline
  *
  * Purpose:
- * Watchdog timer to fire to provide a semaphore at the loop sample rate
+ * How long processGuides waits for ISR3 before running a pass without a
+ * guide update: guideDeadlineFactor guide periods at the sensed guide
+ * rate, no shorter than guideDeadlineMin. When that would be longer than
+ * guideDeadlineMax, or no guide source is running, passes are run every
+ * guideIdlePeriod instead, so that page 0, the TCS demands and the
+ * commands still reach M2 at the TCS demand rate.
  *
  * Invocation:
- * fireLoops
+ * deadline = guideDeadline()
  *
- * Parameters in:
- * None
+ * Return value:
+ *      < deadline  double   seconds
  *
- * Parameters out:
- * None
+ * History:
+ * 17-Oct-2026: Original, replaces waittime
+ * 17-Oct-2026: Fixed guideIdlePeriod when no guide source is running
  *
- * Return value:
- * < status        int     OK or ERROR
+ */
+/* ===================================================================== */
+
+static double guideDeadline (void)
+{
+   double rate = guideWakeRate;
+   double deadline;
+
+#ifdef MK
+   if (guideInfo.sensedRate > 0.0)
+      rate = guideInfo.sensedRate;
+#endif
+
+   /* no guide source, or one too slow to pace the frames */
+   if (rate <= 0.0 || guideDeadlineFactor / rate > guideDeadlineMax)
+      return guideIdlePeriod;
+
+   deadline = guideDeadlineFactor / rate;
+
+   if (deadline < guideDeadlineMin)
+      deadline = guideDeadlineMin;
+
+   return deadline;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * guideLoopReport
  *
- * Globals:
- *    External functions:
- *    None
+ * Purpose:
+ * genSub routine publishing the load of the processGuides thread: the
+ * fraction of the time since the last call spent processing rather than
+ * waiting for ISR3, and the wakeups and deadline misses
  *
- *    External variables:
- *    None
+ * Invocation:
+ * status = guideLoopReport(pgsub)
  *
- * Requirements:
+ * Parameters out:
+ *      < pgsub->vala  double  CPU used by processGuides (%)
+ *      < pgsub->valb  long    ISR3 wakeups
+ *      < pgsub->valc  long    deadline misses (passes without ISR3)
+ *      < pgsub->vald  double  ISR3 wakeups per second
+ *      < pgsub->vale  double  current deadline (ms)
  *
- * Author:
- * Sean Prior  (srp@roe.ac.uk)
+ * Return value:
+ *      < status       long    OK
  *
  * History:
- * 15-Oct-1997: Original(srp)
- * 06-Dec-2017: Converted to a thread that runs periodically (mdw)
+ * 17-Oct-2026: Original
  *
  */
-
 /* ===================================================================== */
-void fireLoops (void *param)
-{
 
-   while (1){
-      /* translation demands update to m2 system at 1Hz */
-      /* set flag to indicate position update */
-      positionUpdate = TRUE;
-      epicsThreadSleep(1.0);
+long guideLoopReport (struct genSubRecord *pgsub)
+{
+   static double lastTime = 0.0;
+   static double lastBusy = 0.0;
+   static long lastWakeups = 0;
+   double now = monotonicNow ();
+   double busy = guideBusyTime;
+   long wakeups = guideWakeups;
+
+   if (lastTime > 0.0 && now > lastTime)
+   {
+      *(double *) pgsub->vala = 100.0 * (busy - lastBusy) / (now - lastTime);
+      *(double *) pgsub->vald = (wakeups - lastWakeups) / (now - lastTime);
    }
-}
-
 
-/* Later: add header */
-void rmISR2 (int node)
-{
-   nodeISR2 = node;
-   epicsEventSignal(scsReceiveNow);
+   *(long *) pgsub->valb = wakeups;
+   *(long *) pgsub->valc = guideDeadlineMisses;
+   *(double *) pgsub->vale = 1000.0 * guideDeadline ();
 
-   /* why is this commented out? This is the only place the 
-    * event is signalled. 20171030 (mdw) */ 
-   /*
-   semGive (cemTimerEndSem);
-   */
-}
+   lastTime = now;
+   lastBusy = busy;
+   lastWakeups = wakeups;
 
-/* Later: add header */
-void rmISR3 (int node)
-{
-   nodeISR3 = node;
-   epicsEventSignal(guideUpdateNow);
+   return OK;
 }
 
 /* ===================================================================== */
@@ -928,6 +2014,11 @@ void rmISR3 (int node)
  * 19-Feb-1999: Bug fix - only perform PID calculation when there has been a new
  *              guide update.
  * 02-Mar-1999: Copy current guide correction to nGuideTcs _after_ the pid algorithm
+ * 17-Oct-2026: Dispatch on nodeISR3 through the guideSources table
+ * 17-Oct-2026: Replace the 1ms sleep after ISR3 with rmSettle
+ * 17-Oct-2026: Block on ISR3 until guideDeadline rather than spinning on
+ *              a zero timeout, account the time spent processing
+ * 17-Oct-2026: Report the commit time of each frame to scheduleCommitted
  *
  */
 
@@ -936,44 +2027,36 @@ void rmISR3 (int node)
 #ifdef MK
 int rxwaitticks = 0;
 int useDynamicVtk =0;
+int useDynamicFilters = 0;      /* redesign filters when the guide rate changes */
+
+#define FILTER_RETUNE_COUNT 20  /* samples at a new rate before retuning */
 #endif
 
-int    waittime = 0.08;   
 
 void processGuides (void) 
 {
    long command = FAST_ONLY;
-   location    position;
-   converted   result = {0,0,0};
+   guideSource *src = NULL;
+   wfsBlock    *page = NULL;
    int indx = 0; 
    //char message[200];
    long lastNS = 0;
 
 #ifdef MK 
    long sensedGuideRate = GUIDE_200_HZ;
+   long candidateRate = 0;
+   int candidateCount = 0;
+   static long filterGuideRate = 0;
 #endif
 
-   static struct
-   {
-      double pwfs1;
-      double pwfs2;
-      double oiwfs;
-      double gaos;
-      double gyro;
-
-#ifndef MK
-      double gpi;
-#endif
-
-#ifdef MK
-   } updateTime = { 0.0, 0.0, 0.0, 0.0, 0.0 };  
-#else
-   } updateTime = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };  
-#endif
-   
    /* Used to time stamp a set of data written to the ring buffers */
    double cbTimeStamp;
 
+   /* wakeup and load accounting */
+   epicsEventWaitStatus waitStatus;
+   double passStart = 0.0, passEnd, lastWake = 0.0;
+   double commitTime;
+
 #ifdef MK
    double tsdiff=0.0;
    static double tsold=0.0;
@@ -992,6 +2075,9 @@ void processGuides (void)
    showVtkRotation(&vtkY);
 #endif
 
+   /* Build the node to guide source lookup */
+   initGuideSources();
+
    /* Initialize eventData structure */ 
    eventData.currentBeam = 0;
    eventData.inPosition = 0;
@@ -1018,97 +2104,66 @@ void processGuides (void)
        * Change to 10 ticks (08-jun-2000, since see that crate is now at 95%
        * CPU usage. Maybe this is the reason? And really, the semaphore can be
        * as long as the rate the TCS sends at 20 Hz = 20 x per sec = 0.05 s 
+
+       * 17-Oct-2026: the integer waittime of 0.08 was 0, so this spun.
+       * Block until ISR3 or a deadline of a few guide periods instead.
        */
 
+      passEnd = monotonicNow();
+      if (passStart > 0.0)
+         guideBusyTime += passEnd - passStart;
+
+      waitStatus = epicsEventWaitWithTimeout(guideUpdateNow, guideDeadline());
 
-      if (epicsEventWaitWithTimeout(guideUpdateNow, waittime) == epicsEventWaitOK) 
+      passStart = monotonicNow();
+
+      if (waitStatus == epicsEventWaitOK) 
          /* then ISR has given sem or it has never been taken */
       {
-         epicsThreadSleep(0.001);
-         /* Find which sources have been updated since last ISR call 
-          * first, check PWFS1 */
+         latencyMark(LATENCY_WOKEN);
 
-         if (debugLevel == DEBUG_RESERVED2)
-         {
-            errlogPrintf( "***** nodeISR3 = %d intervalas %f > %f \n",
-                  nodeISR3, scsBase->pwfs1.interval,  updateInterval.pwfs1); 
-         }
+         /* pick up any filters configured or retuned since the last pass */
+         guideFilterSwap();
 
-         if ( (nodeISR3 == AGP1_NODE) && (weight[PWFS1][currentBeam] > -2) )
+         /* smoothed ISR3 rate for the deadline */
+         if (lastWake > 0.0 && passStart > lastWake)
          {
-            if (scsBase->pwfs1.interval > updateInterval.pwfs1) 
-            {
-               if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
-               {
-                  epicsPrintf("processGuides - increasing time detected for PWFS1\n");
-               }
-               updateInterval.pwfs1 = scsBase->pwfs1.interval;
-               updateTime.pwfs1 = scsBase->pwfs1.time;
-
-               if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
-               {
-                  epicsPrintf("processGuides - read RM data from PWFS1\n");
-               }
+            guideWakeRate = (guideWakeRate > 0.0) ?
+               0.9 * guideWakeRate + 0.1 / (passStart - lastWake) :
+               1.0 / (passStart - lastWake);
+         }
+         lastWake = passStart;
+         guideWakeups++;
 
-               /* copy the data from reflective memory page */
-               frameConvert(&result, ag2m2[PWFS1], 
-                     (double)scsBase->pwfs1.z1, 
-                     (double)scsBase->pwfs1.z2, 
-                     (double)scsBase->pwfs1.z3);
-
-               filtered[PWFS1].z1 = result.x;
-               filtered[PWFS1].z2 = result.y;
-               filtered[PWFS1].z3 = result.z;
-               filtered[PWFS1].err1 = scsBase->pwfs1.err1;
-               filtered[PWFS1].err2 = scsBase->pwfs1.err2;
-               filtered[PWFS1].err3 = scsBase->pwfs1.err3;
-               filtered[PWFS1].time = scsBase->pwfs1.time;
-
-               /* filter the transformed demands */
-               switch (filter[PWFS1][XTILT].type)
-               {
-                  case RAW:
-                  case NOTUSED:
-                     break;
+         /* Find which source raised the interrupt and whether it has been
+          * updated since it was last processed */
 
-                  default:
-                     filtered[PWFS1].z1 = iir_filter 
-                        ((double) filtered[PWFS1].z1, 
-                         &filter[PWFS1][XTILT]);
-                     filtered[PWFS1].z2 = iir_filter 
-                        ((double) filtered[PWFS1].z2, 
-                         &filter[PWFS1][YTILT]);
-                     filtered[PWFS1].z3 = iir_filter 
-                        ((double) filtered[PWFS1].z3, 
-                         &filter[PWFS1][ZFOCUS]);
-               }
+         src = lookupGuideSource(nodeISR3);
 
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[PWFS1].z1;
-               yNetGuide = (double) filtered[PWFS1].z2;
-               zNetGuide = (double) filtered[PWFS1].z3;
+         /* let its page arrive */
+         rmSettle(src);
 
-               guideUpdate = TRUE;
-            }
-         }
-         else if ( (nodeISR3 == AGP2_NODE) && (weight[PWFS2][currentBeam] > -2) )
+         if (debugLevel == DEBUG_RESERVED2)
          {
-            if (scsBase->pwfs2.interval > updateInterval.pwfs2) 
-            {
-               /* Then check PWFS2 */
-               if ((debugLevel > DEBUG_MIN ) & (debugLevel <= DEBUG_MED))
-               {
-                  epicsPrintf("increasing time detected for PWFS2\n"); 
-               }
+            errlogPrintf( "***** nodeISR3 = %d source %s\n", nodeISR3,
+                  (src == NULL) ? "none" : src->name); 
+         }
 
-               updateInterval.pwfs2 = scsBase->pwfs2.interval; 
-               updateTime.pwfs2 = scsBase->pwfs2.time;
+         if ( (src != NULL) && (weight[src->weightSource][currentBeam] > -2) )
+         {
+            page = guidePage(src);
 
+            if (page->interval > *src->lastInterval) 
+            {
                if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
                {
-                  epicsPrintf("processGuides - read RM data from PWFS2\n");
+                  epicsPrintf("processGuides - read RM data from %s\n", 
+                        src->name);
                }
 
+               *src->lastInterval = page->interval;
+               src->lastTime = page->time;
+
 #ifdef MK
                /* N.B. Use this if you're not guiding with P2 and want to check the
                 * functionality of VTK. Here we recycle the previous output
@@ -1119,293 +2174,32 @@ void processGuides (void)
                 * This can work when you're using Synthesized Waves (SW) to simulate a vibration Signal.
                 *
                 * */
-               if (  xvtkGuideRecycle ) {
-
-                    scsBase->pwfs2.z1 =  xRecycleGuideU * (-0.7 / DEFAULT_TILT_SCALE) ;
-               }
-
-               if (  yvtkGuideRecycle ) {
-
-                    scsBase->pwfs2.z2 = yRecycleGuideU * (-0.7/ DEFAULT_TILT_SCALE) ;
-               }
-#endif
-
-               /* copy the data from reflective memory page */
-               frameConvert(&result, ag2m2[PWFS2], 
-                     (double)scsBase->pwfs2.z1, 
-                     (double)scsBase->pwfs2.z2, 
-                     (double)scsBase->pwfs2.z3);
-
-               filtered[PWFS2].z1 = result.x;
-               filtered[PWFS2].z2 = result.y;
-               filtered[PWFS2].z3 = result.z;
-               filtered[PWFS2].err1 = scsBase->pwfs2.err1;
-               filtered[PWFS2].err2 = scsBase->pwfs2.err2;
-               filtered[PWFS2].err3 = scsBase->pwfs2.err3;
-               filtered[PWFS2].time = scsBase->pwfs2.time;
-
-               /* filter the transformed demands */
-               switch (filter[PWFS2][XTILT].type)
+               if (src->source == PWFS2)
                {
-                  case RAW:
-#ifdef MK
-                     if (debugLevel == DEBUG_RESERVED2) epicsPrintf("RAW\n");
-#endif
-                     break;
-                  case NOTUSED:
-#ifdef MK
-                     if (debugLevel == DEBUG_RESERVED2) epicsPrintf("NOTUSED\n");
-#endif
-                     break;
-
-                  default:
-#ifdef MK
-                     if (debugLevel == DEBUG_RESERVED2) epicsPrintf("DEFAULT\n");
-#endif
-                     filtered[PWFS2].z1 = iir_filter 
-                        ((double) filtered[PWFS2].z1, 
-                         &filter[PWFS2][XTILT]);
-                     filtered[PWFS2].z2 = iir_filter 
-                        ((double) filtered[PWFS2].z2, 
-                         &filter[PWFS2][YTILT]);
-                     filtered[PWFS2].z3 = iir_filter 
-                        ((double) filtered[PWFS2].z3, 
-                         &filter[PWFS2][ZFOCUS]);
-               }
-
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[PWFS2].z1;
-               yNetGuide = (double) filtered[PWFS2].z2;
-               zNetGuide = (double) filtered[PWFS2].z3;
-
-
-               guideUpdate = TRUE;
-            }
-         }
-#ifdef MK
-         else if ( (nodeISR3 == AGOI_NODE) && (weight[OIWFS][currentBeam] > -2) )
-#else
-         else if ( (nodeISR3 == AGOI_NODE || nodeISR3 == F2OI_NODE) && (weight[OIWFS][currentBeam] > -2) )
-#endif
-         {
-            if (scsBase->oiwfs.interval > updateInterval.oiwfs) 
-            {
-               updateTime.oiwfs = scsBase->oiwfs.time;
-               updateInterval.oiwfs = scsBase->oiwfs.interval; 
+                  if (  xvtkGuideRecycle ) {
 
-               if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
-               {
-                  epicsPrintf("processGuides - read RM data from OIWFS\n");
-               }
+                     page->z1 =  xRecycleGuideU * (-0.7 / DEFAULT_TILT_SCALE) ;
+                  }
 
-               /* copy the data from reflective memory page */
-               frameConvert(&result, ag2m2[OIWFS], 
-                     (double)scsBase->oiwfs.z1, 
-                     (double)scsBase->oiwfs.z2, 
-                     (double)scsBase->oiwfs.z3);
-
-               filtered[OIWFS].z1 = result.x;
-               filtered[OIWFS].z2 = result.y;
-               filtered[OIWFS].z3 = result.z;
-               filtered[OIWFS].err1 = scsBase->oiwfs.err1;
-               filtered[OIWFS].err2 = scsBase->oiwfs.err2;
-               filtered[OIWFS].err3 = scsBase->oiwfs.err3;
-               filtered[OIWFS].time = scsBase->oiwfs.time;
-
-               /* do focus scaling conversion */
-               filtered[OIWFS].z3 *= frame.focusScaling;
-
-               /* filter the transformed demands */
-               switch (filter[OIWFS][XTILT].type)
-               {
-                  case RAW:
-                  case NOTUSED:
-                     break;
+                  if (  yvtkGuideRecycle ) {
 
-                  default:
-                     filtered[OIWFS].z1 = iir_filter 
-                        ((double) filtered[OIWFS].z1, 
-                         &filter[OIWFS][XTILT]);
-                     filtered[OIWFS].z2 = iir_filter 
-                        ((double) filtered[OIWFS].z2, 
-                         &filter[OIWFS][YTILT]);
-                     filtered[OIWFS].z3 = iir_filter 
-                        ((double) filtered[OIWFS].z3, 
-                         &filter[OIWFS][ZFOCUS]);
+                     page->z2 = yRecycleGuideU * (-0.7/ DEFAULT_TILT_SCALE) ;
+                  }
                }
+#endif
 
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[OIWFS].z1;
-               yNetGuide = (double) filtered[OIWFS].z2;
-               zNetGuide = (double) filtered[OIWFS].z3;
+               guideSample(src, page);
 
                guideUpdate = TRUE;
             }
          }
-
-         else if ( (nodeISR3 == GAOS_NODE) && (weight[GAOS][currentBeam] > -2) )
-         {
-            if (scsBase->gaos.interval > updateInterval.gaos) 
-            { 
-               updateTime.gaos = scsBase->gaos.time;
-               updateInterval.gaos = scsBase->gaos.interval; 
-
-               if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
-               {
-                  epicsPrintf("processGuides - read RM data from GAOS\n");
-               }
-
-               /* copy the data from reflective memory page */
-               frameConvert(&result, ag2m2[GAOS],
-                     (double)scsBase->gaos.z1,
-                     (double)scsBase->gaos.z2,
-                     (double)scsBase->gaos.z3);
-
-               filtered[GAOS].z1 = result.x;
-               filtered[GAOS].z2 = result.y;
-               filtered[GAOS].z3 = result.z;
-               filtered[GAOS].err1 = scsBase->gaos.err1;
-               filtered[GAOS].err2 = scsBase->gaos.err2;
-               filtered[GAOS].err3 = scsBase->gaos.err3;
-               filtered[GAOS].time = scsBase->gaos.time;
-
-               /* filter the transformed demands */
-
-               switch (filter[GAOS][XTILT].type)
-               {
-                  case RAW:
-                  case NOTUSED:
-                     break;
-
-                  default:
-                     filtered[GAOS].z1 = iir_filter 
-                        ((double) filtered[GAOS].z1, 
-                         &filter[GAOS][XTILT]);
-                     filtered[GAOS].z2 = iir_filter 
-                        ((double) filtered[GAOS].z2, 
-                         &filter[GAOS][YTILT]);
-                     filtered[GAOS].z3 = iir_filter 
-                        ((double) filtered[GAOS].z3, 
-                         &filter[GAOS][ZFOCUS]);
-               }
-
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[GAOS].z1;
-               yNetGuide = (double) filtered[GAOS].z2;
-               zNetGuide = (double) filtered[GAOS].z3;
-
-               guideUpdate = TRUE;
-            } 
-         }
-
-#ifndef MK
-        else if ( (nodeISR3 == GPI_NODE) && (weight[OIWFS][currentBeam] > -2) )
-         {
-             if (scsBase->gpi.interval > updateInterval.gpi) 
-            { 
-               if (debugLevel == DEBUG_RESERVED2) 
-                   errlogMessage("processGuides - GPI NODE interrupting me\n"); 
-  
-               updateTime.gpi = scsBase->gpi.time;
-               updateInterval.gpi = scsBase->gpi.interval; 
-
-               if ((debugLevel > DEBUG_MIN) & (debugLevel <= DEBUG_MED))
-               {
-                  printf("processGuides - read RM data from GPI\n");
-               }
-
-               /* copy the data from reflective memory page */
-               frameConvert(&result, ag2m2[GPI],
-                     (double)scsBase->gpi.z1,
-                     (double)scsBase->gpi.z2,
-                     (double)scsBase->gpi.z3);
-
-               filtered[GPI].z1 = result.x;
-               filtered[GPI].z2 = result.y;
-               filtered[GPI].z3 = result.z;
-               filtered[GPI].err1 = scsBase->gpi.err1;
-               filtered[GPI].err2 = scsBase->gpi.err2;
-               filtered[GPI].err3 = scsBase->gpi.err3;
-               filtered[GPI].time = scsBase->gpi.time;
-
-               /* filter the transformed demands */
-
-               switch (filter[GPI][XTILT].type)
-               {
-                  case RAW:
-                  case NOTUSED:
-                     break;
-
-                  default:
-                     filtered[GPI].z1 = iir_filter
-                        ((double) filtered[GPI].z1,
-                         &filter[GPI][XTILT]);
-                     filtered[GPI].z2 = iir_filter
-                        ((double) filtered[GPI].z2,
-                         &filter[GPI][YTILT]);
-                     filtered[GPI].z3 = iir_filter
-                        ((double) filtered[GPI].z3,
-                         &filter[GPI][ZFOCUS]);
-               }
-
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[GPI].z1;
-               yNetGuide = (double) filtered[GPI].z2;
-               zNetGuide = (double) filtered[GPI].z3;
-
-               guideUpdate = TRUE;
-             } 
-         }
-#endif
-         else if (scsBase->gyro.time > updateTime.gyro)
+         else if (scsBase->gyro.time > guideSources[GYRO].lastTime)
          {
-            updateTime.gyro = scsBase->gyro.time;
+            guideSources[GYRO].lastTime = scsBase->gyro.time;
 
             if (weight[GYRO][currentBeam] > -2)
             {
-               /* copy the data from reflective memory page */
-               filtered[GYRO].z1 = scsBase->gyro.z1;
-               filtered[GYRO].z2 = scsBase->gyro.z2;
-               filtered[GYRO].z3 = scsBase->gyro.z3;
-               filtered[GYRO].err1 = scsBase->gyro.err1;
-               filtered[GYRO].err2 = scsBase->gyro.err2;
-               filtered[GYRO].err3 = scsBase->gyro.err3;
-               filtered[GYRO].time = scsBase->gyro.time;
-
-               /* do focus scaling conversion */
-               position.xTilt = filtered[GYRO].z1;
-               position.yTilt = filtered[GYRO].z2;
-               position.zFocus = filtered[GYRO].z3;
-
-               gyro2m2 (&position);
-
-               filtered[GYRO].z1 = position.xTiltNew;
-               filtered[GYRO].z2 = position.yTiltNew;
-               filtered[GYRO].z3 = position.zFocusNew;
-
-               /* filter the transformed demands */
-               switch (filter[GYRO][XTILT].type)
-               {
-                  case RAW:
-                  case NOTUSED:
-                     break;
-
-                  default:
-                     filtered[GYRO].z1 = iir_filter 
-                        ((double) filtered[GYRO].z1, 
-                         &filter[GYRO][XTILT]);
-                     filtered[GYRO].z2 = iir_filter 
-                        ((double) filtered[GYRO].z2, 
-                         &filter[GYRO][YTILT]);
-                     filtered[GYRO].z3 = iir_filter 
-                        ((double) filtered[GYRO].z3, 
-                         &filter[GYRO][ZFOCUS]);
-               }
-
-               /* instead of calling blend sources later on */
-               xNetGuide = (double) filtered[GYRO].z1;
-               yNetGuide = (double) filtered[GYRO].z2;
-               zNetGuide = (double) filtered[GYRO].z3;
+               guideSample(&guideSources[GYRO], &scsBase->gyro);
 
                guideUpdate = TRUE;
             }
@@ -1428,6 +2222,10 @@ void processGuides (void)
           * occurred and bypass timestamp checking 
           */
          guideUpdate = FALSE;         
+         guideDeadlineMisses++;
+
+         /* the sources have stopped, fall back to guideIdlePeriod */
+         guideWakeRate *= 0.5;
       }
 
 #ifdef MK
@@ -1483,9 +2281,9 @@ void processGuides (void)
                   Decided to use RM page 0 just to make sure these 2 vals are
                   synched with other guide values */
 
-               scsBase->page0.rawXGuide = (float)xNetGuide; 
-               scsBase->page0.rawYGuide = (float)yNetGuide;
-               scsBase->page0.rawZGuide = (float)zNetGuide;
+               page0Image.rawXGuide = (float)xNetGuide; 
+               page0Image.rawYGuide = (float)yNetGuide;
+               page0Image.rawZGuide = (float)zNetGuide;
 
 
 
@@ -1567,6 +2365,8 @@ void processGuides (void)
  
                }
 
+               latencyMark(LATENCY_CONTROLLED);
+
                /* Clamp the values of the guide. 
                   Tell the TCS the clamped values too, to keep 
                   it in sync with what the M2 receives. 
@@ -1664,25 +2464,8 @@ void processGuides (void)
             yNetGuideU = 0.0;
 #endif
 
-          scsBase->page0.xTiltGuide = (float) xNetGuideU;
-          scsBase->page0.yTiltGuide = (float) yNetGuideU;
-          scsBase->page0.zFocusGuide = 
-            (float) confine ((setPoint.zFocus + zNetGuideU), 
-                  Z_FOCUS_LIMIT, -Z_FOCUS_LIMIT);
-
-         /* Not used by M2, so not part of the checksum just used for displaying
-          * the components of the focus. Decided to use RM page 0 just to make sure
-          * these 2 vals are synched with zFocusGuide value */
-
-         /* package M2 data for RM */
-         scsBase->page0.zFocus = (float)setPoint.zFocus;
-         scsBase->page0.zGuide = (float)zNetGuideU;
-         scsBase->page0.xGrossTiltDmd = scsBase->page0.AxTilt + (float) xNetGuideU;
-         scsBase->page0.yGrossTiltDmd = scsBase->page0.AyTilt + (float) yNetGuideU;
-
-         /* fetch command from message queue */
-         if( epicsMessageQueueTryReceive(commandQId, (char *) &command, sizeof (long)) < 0 )
-            command = FAST_ONLY;
+         /* fetch the next command, if M2 has acknowledged the last one */
+         command = commandNext(local.NS + 1);
 
          if (command == CMD_TEST)
             local.testRequest = 1;
@@ -1694,16 +2477,46 @@ void processGuides (void)
                   m2CmdName[command], (int)command);
          }
 
-         scsBase->page0.commandCode = command;
-         lastNS = scsBase->page0.NS;
-         scsBase->page0.NS = ++local.NS;
-         if (fabs(lastNS - scsBase->page0.NS) > 1000)
+         /* compose the frame in the local image of page 0, slowTransmit
+          * cannot change it until the frame has been committed */
+         epicsMutexLock(page0Free);
+
+         page0Image.xTiltGuide = (float) xNetGuideU;
+         page0Image.yTiltGuide = (float) yNetGuideU;
+         page0Image.zFocusGuide = 
+            (float) confine ((setPoint.zFocus + zNetGuideU), 
+                  Z_FOCUS_LIMIT, -Z_FOCUS_LIMIT);
+
+         /* Not used by M2, so not part of the checksum just used for displaying
+          * the components of the focus. Decided to use RM page 0 just to make sure
+          * these 2 vals are synched with zFocusGuide value */
+
+         /* package M2 data for RM */
+         page0Image.zFocus = (float)setPoint.zFocus;
+         page0Image.zGuide = (float)zNetGuideU;
+         page0Image.xGrossTiltDmd = page0Image.AxTilt + (float) xNetGuideU;
+         page0Image.yGrossTiltDmd = page0Image.AyTilt + (float) yNetGuideU;
+
+         page0Image.commandCode = command;
+         lastNS = page0Image.NS;
+         page0Image.NS = ++local.NS;
+         if (labs(lastNS - page0Image.NS) > 1000)
          {
             epicsPrintf("SCS sending NS = %ld\n", lastNS);
          }
-         scsBase->page0.heartbeat = local.scsHeartbeat++;
-         scsBase->page0.checksum = 
-            checkSum ((void *) &scsBase->page0.NS, COMMAND_BLOCK_SIZE);
+         page0Image.heartbeat = local.scsHeartbeat++;
+         page0Image.checksum = 
+            checkSumFast ((void *) &page0Image.NS, COMMAND_BLOCK_SIZE);
+
+         /* commit the whole frame to reflective memory in one copy */
+         memcpy ((void *) &scsBase->page0, (void *) &page0Image, 
+               PAGE0_COMMIT_SIZE);
+
+         /* apply time of the TCS demands carried by the frame */
+         if (timeNow (&commitTime) == OK)
+            scheduleCommitted (commitTime);
+
+         epicsMutexUnlock(page0Free);
 
          /* flag availability of new data */
          /* The original ideal of sending only everyother pulse has bee removed */
@@ -1714,6 +2527,7 @@ void processGuides (void)
              if (command > FAST_ONLY || indx > 1 )
              {  
                  rmIntSend (INT2, M2_NODE);
+                 latencyMark(LATENCY_SENT);
                  indx = 0; 
              }
          }
@@ -1724,9 +2538,11 @@ void processGuides (void)
 #ifndef MK
             if(command > FAST_ONLY) {
                rmIntSend (INT2, M2_NODE);
+               latencyMark(LATENCY_SENT);
             }
 #else
            rmIntSend (INT2, M2_NODE);
+           latencyMark(LATENCY_SENT);
 #endif
 
          }
@@ -1746,10 +2562,9 @@ void processGuides (void)
 
          /* package data */
 
-         /* fetch command from message queue */
+         /* fetch the next command, if M2 has acknowledged the last one */
 
-         if( epicsMessageQueueTryReceive(commandQId, (char *) &command, sizeof (long)) < 0)
-            command = FAST_ONLY;
+         command = commandNext(local.NS + 1);
 
          if (command == CMD_TEST)
             local.testRequest = 1;
@@ -1758,7 +2573,11 @@ void processGuides (void)
          m2Ptr->page0.NS = ++local.NS;
          m2Ptr->page0.heartbeat = local.scsHeartbeat++;
          m2Ptr->page0.checksum = 
-            checkSum ((void *) &m2Ptr->page0.NS, COMMAND_BLOCK_SIZE);
+            checkSumFast ((void *) &m2Ptr->page0.NS, COMMAND_BLOCK_SIZE);
+
+         /* apply time of the TCS demands carried by the frame */
+         if (timeNow (&commitTime) == OK)
+            scheduleCommitted (commitTime);
 
          epicsMutexUnlock(m2MemFree);
 
@@ -1793,79 +2612,91 @@ void processGuides (void)
          /* if there is a problem, don't update the cb */
          continue;
       }
-      cbTime[cbCounter] = cbTimeStamp;
-      // cbTick[cbCounter] = tickGet();
 
+      if (cbRing != NULL)
+      {
+         telemetrySample *rec = &cbRing[cbCounter];
+
+         rec->time = cbTimeStamp;
 
-      /* Here is all the P2 specific stuff */
-      cbXRawGuide[cbCounter] = scsBase->pwfs2.z1;
-      cbYRawGuide[cbCounter] = scsBase->pwfs2.z2;
-      cbZRawGuide[cbCounter] = scsBase->pwfs2.z3;
-      cbP2Interval[cbCounter] = scsBase->pwfs2.interval;
-      cbP2Time[cbCounter] = scsBase->pwfs2.time;
+         /* Here is all the P2 specific stuff */
+         rec->xRaw = scsBase->pwfs2.z1;
+         rec->yRaw = scsBase->pwfs2.z2;
+         rec->zRaw = scsBase->pwfs2.z3;
+         rec->p2Interval = scsBase->pwfs2.interval;
+         rec->p2Time = scsBase->pwfs2.time;
 
-      cbCurBeam[cbCounter] = currentBeam;
-      cbApplyGuide[cbCounter] = applyGuide;
-      cbGuideOnA[cbCounter] = guideOnA;
-      cbInPos[cbCounter] = eventData.inPosition;
+         rec->beam = currentBeam;
+         rec->applyGuide = applyGuide;
+         rec->guideOnA = guideOnA;
+         rec->inPosition = eventData.inPosition;
 
-      cbAXDemand[cbCounter] = scsBase->page0.AxTilt;
-      cbAYDemand[cbCounter] = scsBase->page0.AyTilt;
-      cbBXDemand[cbCounter] = scsBase->page0.BxTilt;
-      cbBYDemand[cbCounter] = scsBase->page0.ByTilt;
+         rec->axDemand = page0Image.AxTilt;
+         rec->ayDemand = page0Image.AyTilt;
+         rec->bxDemand = page0Image.BxTilt;
+         rec->byDemand = page0Image.ByTilt;
 
-      cbXGuideBeforePID[cbCounter] = xNetGuide;
-      cbYGuideBeforePID[cbCounter] = yNetGuide;
-      cbZGuideBeforePID[cbCounter] = zNetGuide;
+         rec->xBeforePID = xNetGuide;
+         rec->yBeforePID = yNetGuide;
+         rec->zBeforePID = zNetGuide;
 
-      cbXGuideAfterPID[cbCounter] = xNetGuideT;
-      cbYGuideAfterPID[cbCounter] = yNetGuideT;
-      cbZGuideAfterPID[cbCounter] = zNetGuideT;
+         rec->xAfterPID = xNetGuideT;
+         rec->yAfterPID = yNetGuideT;
+         rec->zAfterPID = zNetGuideT;
 
 #ifdef MK
-      cbXGuideDemand[cbCounter] = xRecycleGuideU;
-      cbYGuideDemand[cbCounter] = yRecycleGuideU;
+         rec->xDemand = xRecycleGuideU;
+         rec->yDemand = yRecycleGuideU;
 #else
-      cbXGuideDemand[cbCounter] = xNetGuideU;
-      cbYGuideDemand[cbCounter] = yNetGuideU;
+         rec->xDemand = xNetGuideU;
+         rec->yDemand = yNetGuideU;
 #endif
-
-      cbZGuideDemand[cbCounter] = zNetGuideU;
+         rec->zDemand = zNetGuideU;
 
 #ifdef MK
-      cbVTKXCommand[cbCounter] = vtkX.command;
-      cbVTKYCommand[cbCounter] = vtkY.command;
+         rec->vtkXCommand = vtkX.command;
+         rec->vtkYCommand = vtkY.command;
 
-      cbVTKXPhaseOld[cbCounter] = vtkX.phaseOld;
-      cbVTKYPhaseOld[cbCounter] = vtkY.phaseOld;
+         rec->vtkXPhaseOld = vtkX.phaseOld;
+         rec->vtkYPhaseOld = vtkY.phaseOld;
 
-      cbVTKXPhaseNew[cbCounter] = vtkX.phase;
-      cbVTKYPhaseNew[cbCounter] = vtkY.phase;
+         rec->vtkXPhase = vtkX.phase;
+         rec->vtkYPhase = vtkY.phase;
 
-     cbVTKXFrequency[cbCounter] = vtkX.frequency.currentValue;
-     cbVTKYFrequency[cbCounter] = vtkY.frequency.currentValue;
+         rec->vtkXFrequency = vtkX.frequency.currentValue;
+         rec->vtkYFrequency = vtkY.frequency.currentValue;
 
-     cbVTKXFreqError[cbCounter] = vtkX.frequency.error;
-     cbVTKYFreqError[cbCounter] = vtkY.frequency.error;
+         rec->vtkXFreqError = vtkX.frequency.error;
+         rec->vtkYFreqError = vtkY.frequency.error;
 
-     cbVTKXdeltaPhase[cbCounter] = vtkX.deltaPhase;
-     cbVTKYdeltaPhase[cbCounter] = vtkY.deltaPhase;
+         rec->vtkXDeltaPhase = vtkX.deltaPhase;
+         rec->vtkYDeltaPhase = vtkY.deltaPhase;
 
-     cbVTKXIntegrator0[cbCounter] = vtkX.integral[0][0];
-     cbVTKXIntegrator1[cbCounter] = vtkX.integral[1][0];
+         rec->vtkXIntegral0 = vtkX.integral[0][0];
+         rec->vtkXIntegral1 = vtkX.integral[1][0];
 
-     cbVTKYIntegrator0[cbCounter] = vtkY.integral[0][0];
-     cbVTKYIntegrator1[cbCounter] = vtkY.integral[1][0];
+         rec->vtkYIntegral0 = vtkY.integral[0][0];
+         rec->vtkYIntegral1 = vtkY.integral[1][0];
 
-     cbXGuidePhasor[cbCounter] = phasorX.command;
-     cbYGuidePhasor[cbCounter] = phasorY.command;
+         rec->xPhasor = phasorX.command;
+         rec->yPhasor = phasorY.command;
 #endif
+         rec->spare = 0;
 
-      /* increment the counter and wrap around if necessary,
-       * it is a circular buffer after all. */
-      if ( ++ cbCounter == CB_RECORD_NB )
-      {
-         cbCounter = 0;
+         /* hand the same record to the telemetry recorder */
+         if (telemetryOn)
+            telemetryPush (rec);
+
+         /* increment the counter and wrap around if necessary,
+          * it is a circular buffer after all. */
+         if ( ++ cbCounter == cbSize )
+         {
+            cbCounter = 0;
+         }
+         if (cbCount < cbSize)
+         {
+            cbCount++;
+         }
       }
 #ifdef MK
       tsdiff = cbTimeStamp - tsold;
@@ -1879,8 +2710,39 @@ void processGuides (void)
        * */
       if (useDynamicVtk && checkGuideModeChange(sensedGuideRate) != ERROR) 
          guideInfo.rate = sensedGuideRate;
+
+      /* Redesign the designed guide filters for the new rate once it has
+       * been seen for a number of samples, so one missed frame does not
+       * reset the filter histories. */
+      if (useDynamicFilters && sensedGuideRate != filterGuideRate &&
+            (sensedGuideRate == GUIDE_200_HZ || sensedGuideRate == GUIDE_100_HZ ||
+             sensedGuideRate == GUIDE_50_HZ || sensedGuideRate == GUIDE_20_HZ))
+      {
+         if (sensedGuideRate != candidateRate)
+         {
+            candidateRate = sensedGuideRate;
+            candidateCount = 0;
+         }
+
+         if (++candidateCount >= FILTER_RETUNE_COUNT)
+         {
+            /* the redesign is done by the retune task, the new filters
+             * are swapped in at the start of a later pass */
+            filterRetuneRequest (sensedGuideRate);
+
+            filterGuideRate = sensedGuideRate;
+            candidateCount = 0;
+         }
+      }
+      else
+      {
+         candidateCount = 0;
+      }
 #endif 
 
+      /* time each stage of this pass */
+      latencyCommit();
+
    } /* end for(;;) FOREVER*/
 }
 
@@ -1888,7 +2750,10 @@ void processGuides (void)
 
 void slowTransmit (void)
 {
-   double timeStamp;
+   double timeStamp, frameTime;
+   Demands interpolated, scheduled;
+   int due;
+   long pageGeneration;
    int c[7];
    char cemtime[CEM_TIME_SIZE];
 
@@ -1926,17 +2791,45 @@ void slowTransmit (void)
       {
          if (timeNow (&timeStamp) == OK)
          {
-            epicsMutexLock(setPointFree);
-            setPoint.xTiltA = getInterpolation (AX, timeStamp);
-            setPoint.yTiltA = getInterpolation (AY, timeStamp);
-            setPoint.xTiltB = getInterpolation (BX, timeStamp);
-            setPoint.yTiltB = getInterpolation (BY, timeStamp);
-            setPoint.xTiltC = getInterpolation (CX, timeStamp);
-            setPoint.yTiltC = getInterpolation (CY, timeStamp);
-            setPoint.zFocus = getInterpolation (Z, timeStamp);
-            setPoint.xPosition = tcs.xPosition;
-            setPoint.yPosition = tcs.yPosition;
-            epicsMutexUnlock(setPointFree);
+            /* evaluate the demands at the time the next frame will be
+             * committed, and take the queued demands due at that frame */
+            frameTime = scheduleNextFrame (timeStamp);
+            due = scheduleDue (frameTime, &scheduled);
+
+            if (scheduleInterpolate)
+            {
+               /* keep the set point until a demand has been received */
+               if (getInterpolationAll (&interpolated, frameTime) == OK)
+               {
+                  epicsMutexLock(setPointFree);
+                  setPoint.xTiltA = interpolated.xTiltA;
+                  setPoint.yTiltA = interpolated.yTiltA;
+                  setPoint.xTiltB = interpolated.xTiltB;
+                  setPoint.yTiltB = interpolated.yTiltB;
+                  setPoint.xTiltC = interpolated.xTiltC;
+                  setPoint.yTiltC = interpolated.yTiltC;
+                  setPoint.zFocus = interpolated.zFocus;
+                  setPoint.xPosition = tcs.xPosition;
+                  setPoint.yPosition = tcs.yPosition;
+                  epicsMutexUnlock(setPointFree);
+               }
+            }
+            else if (due > 0)
+            {
+               /* step to the latest demand at the frame closest to its
+                * timeApply */
+               epicsMutexLock(setPointFree);
+               setPoint.xTiltA = scheduled.xTiltA;
+               setPoint.yTiltA = scheduled.yTiltA;
+               setPoint.xTiltB = scheduled.xTiltB;
+               setPoint.yTiltB = scheduled.yTiltB;
+               setPoint.xTiltC = scheduled.xTiltC;
+               setPoint.yTiltC = scheduled.yTiltC;
+               setPoint.zFocus = scheduled.zFocus;
+               setPoint.xPosition = scheduled.xPosition;
+               setPoint.yPosition = scheduled.yPosition;
+               epicsMutexUnlock(setPointFree);
+            }
          }
          else
          {
@@ -1975,53 +2868,58 @@ void slowTransmit (void)
          scstimeUpdate = 0;
       }
 
-      /* copy current SCS internal buffer to local buffer */
+      /* copy current SCS internal buffer to local buffer, numbered so
+       * that commands about this data wait until it is in the image */
       epicsMutexLock(refMemFree);
       /* before 10sep: localCommandBlock = *(memMap *)scsPtr; */
       localCommandBlock = *(commandBlock *)&(scsPtr->page0);
+      pageGeneration = commandPageSnapshot ();
       epicsMutexUnlock(refMemFree);
 
-      /* write demands to reflective memory interface */
+      /* write demands to the image of page 0, processGuides commits them
+       * to reflective memory with its next frame */
 
       if (simLevel == 0)
       {
+         epicsMutexLock(page0Free);
+
          if (interlockFlag != ON)
          {
 
             switch (jogBeam)
             {
                case BEAMB:
-                  scsBase->page0.AxTilt = 
+                  page0Image.AxTilt = 
                      (float) confine (setPoint.xTiltB, X_TILT_LIMIT, 
                            -X_TILT_LIMIT);
-                  scsBase->page0.AyTilt = 
+                  page0Image.AyTilt = 
                      (float) confine (setPoint.yTiltB, Y_TILT_LIMIT,
                            -Y_TILT_LIMIT);
                   break;
 
                case BEAMC:
-                  scsBase->page0.AxTilt = 
+                  page0Image.AxTilt = 
                      (float) confine (setPoint.xTiltC, X_TILT_LIMIT, 
                            -X_TILT_LIMIT);
-                  scsBase->page0.AyTilt = 
+                  page0Image.AyTilt = 
                      (float) confine (setPoint.yTiltC, Y_TILT_LIMIT, 
                            -Y_TILT_LIMIT);
                   break;
 
                default:
-                  scsBase->page0.AxTilt = 
+                  page0Image.AxTilt = 
                      (float) confine (setPoint.xTiltA, X_TILT_LIMIT, 
                            -X_TILT_LIMIT);
-                  scsBase->page0.AyTilt = 
+                  page0Image.AyTilt = 
                      (float) confine (setPoint.yTiltA, Y_TILT_LIMIT, 
                            -Y_TILT_LIMIT);
             }
-            scsBase->page0.BxTilt = (float) confine (setPoint.xTiltB, X_TILT_LIMIT, -X_TILT_LIMIT);
-            scsBase->page0.ByTilt = (float) confine (setPoint.yTiltB, Y_TILT_LIMIT, -Y_TILT_LIMIT);
-            scsBase->page0.CxTilt = (float) confine (setPoint.xTiltC, X_TILT_LIMIT, -X_TILT_LIMIT);
-            scsBase->page0.CyTilt = (float) confine (setPoint.yTiltC, Y_TILT_LIMIT, -Y_TILT_LIMIT);
-            scsBase->page0.xDemand = (float) setPoint.xPosition;
-            scsBase->page0.yDemand = (float) setPoint.yPosition;
+            page0Image.BxTilt = (float) confine (setPoint.xTiltB, X_TILT_LIMIT, -X_TILT_LIMIT);
+            page0Image.ByTilt = (float) confine (setPoint.yTiltB, Y_TILT_LIMIT, -Y_TILT_LIMIT);
+            page0Image.CxTilt = (float) confine (setPoint.xTiltC, X_TILT_LIMIT, -X_TILT_LIMIT);
+            page0Image.CyTilt = (float) confine (setPoint.yTiltC, Y_TILT_LIMIT, -Y_TILT_LIMIT);
+            page0Image.xDemand = (float) setPoint.xPosition;
+            page0Image.yDemand = (float) setPoint.yPosition;
          }
          else
          {
@@ -2029,68 +2927,76 @@ void slowTransmit (void)
              * interlocks set, adjust demands to current position
              */
 
-            scsBase->page0.AxTilt = lockPosition.xTilt;
-            scsBase->page0.BxTilt = lockPosition.xTilt;
-            scsBase->page0.CxTilt = lockPosition.xTilt;
-            scsBase->page0.xTiltGuide = 0.0;
+            page0Image.AxTilt = lockPosition.xTilt;
+            page0Image.BxTilt = lockPosition.xTilt;
+            page0Image.CxTilt = lockPosition.xTilt;
+            page0Image.xTiltGuide = 0.0;
 
-            scsBase->page0.AyTilt = lockPosition.yTilt;
-            scsBase->page0.ByTilt = lockPosition.yTilt;
-            scsBase->page0.CyTilt = lockPosition.yTilt;
-            scsBase->page0.yTiltGuide = 0.0;
+            page0Image.AyTilt = lockPosition.yTilt;
+            page0Image.ByTilt = lockPosition.yTilt;
+            page0Image.CyTilt = lockPosition.yTilt;
+            page0Image.yTiltGuide = 0.0;
 
-            scsBase->page0.zFocusGuide = lockPosition.zFocus;
+            page0Image.zFocusGuide = lockPosition.zFocus;
 
-            scsBase->page0.xDemand = lockPosition.xPos;
-            scsBase->page0.yDemand = lockPosition.yPos;
+            page0Image.xDemand = lockPosition.xPos;
+            page0Image.yDemand = lockPosition.yPos;
          }
 
-         scsBase->page0.centralBaffle = localPtr->centralBaffle;
-         scsBase->page0.deployBaffle = localPtr->deployBaffle;
-         scsBase->page0.chopProfile = localPtr->chopProfile;
-         scsBase->page0.chopFrequency = localPtr->chopFrequency;
-         scsBase->page0.chopDutyCycle = localPtr->chopDutyCycle;
-         scsBase->page0.xTiltTolerance = localPtr->xTiltTolerance;
-         scsBase->page0.yTiltTolerance = localPtr->yTiltTolerance;
-         scsBase->page0.zFocusTolerance = localPtr->zFocusTolerance;
-         scsBase->page0.xPositionTolerance = 
+         page0Image.centralBaffle = localPtr->centralBaffle;
+         page0Image.deployBaffle = localPtr->deployBaffle;
+         page0Image.chopProfile = localPtr->chopProfile;
+         page0Image.chopFrequency = localPtr->chopFrequency;
+         page0Image.chopDutyCycle = localPtr->chopDutyCycle;
+         page0Image.xTiltTolerance = localPtr->xTiltTolerance;
+         page0Image.yTiltTolerance = localPtr->yTiltTolerance;
+         page0Image.zFocusTolerance = localPtr->zFocusTolerance;
+         page0Image.xPositionTolerance = 
             localPtr->xPositionTolerance;
-         scsBase->page0.yPositionTolerance = 
+         page0Image.yPositionTolerance = 
             localPtr->yPositionTolerance;
-         scsBase->page0.bandwidth = localPtr->bandwidth;
-         scsBase->page0.xTiltGain = localPtr->xTiltGain;
-         scsBase->page0.yTiltGain = localPtr->yTiltGain;
-         scsBase->page0.zFocusGain = localPtr->zFocusGain;
-         scsBase->page0.xTiltShift = localPtr->xTiltShift;
-         scsBase->page0.yTiltShift = localPtr->yTiltShift;
-         scsBase->page0.zFocusShift = localPtr->zFocusShift;
-         scsBase->page0.xTiltSmooth = localPtr->xTiltSmooth;
-         scsBase->page0.yTiltSmooth = localPtr->yTiltSmooth;
-         scsBase->page0.zFocusSmooth = localPtr->zFocusSmooth;
-         scsBase->page0.xTcsMinRange = localPtr->xTcsMinRange;
-         scsBase->page0.yTcsMinRange = localPtr->yTcsMinRange;
-         scsBase->page0.xTcsMaxRange = localPtr->xTcsMaxRange;
-         scsBase->page0.yTcsMaxRange = localPtr->yTcsMaxRange;
-         scsBase->page0.xPMinRange = localPtr->xPMinRange;
-         scsBase->page0.yPMinRange = localPtr->yPMinRange;
-         scsBase->page0.xPMaxRange = localPtr->xPMaxRange;
-         scsBase->page0.yPMaxRange = localPtr->yPMaxRange;
-         scsBase->page0.follower = localPtr->follower;
-         scsBase->page0.foldir = localPtr->foldir;
-         scsBase->page0.followersteps = localPtr->followersteps;
-         scsBase->page0.offloader = localPtr->offloader;
-         scsBase->page0.ofldir = localPtr->ofldir;
-         scsBase->page0.offloadersteps = localPtr->offloadersteps;
-         scsBase->page0.cbafdir = localPtr->cbafdir;
-         scsBase->page0.cbsteps = localPtr->cbsteps;
-         scsBase->page0.deployable_baffle = localPtr->deployable_baffle;
-         scsBase->page0.dbafdir = localPtr->dbafdir;
-         scsBase->page0.dbsteps = localPtr->dbsteps;
-         scsBase->page0.xy_motor = localPtr->xy_motor;
-         scsBase->page0.xydir = localPtr->xydir;
-         scsBase->page0.xysteps = localPtr->xysteps;
-         scsBase->page0.xyPositionDeadband = localPtr->xyPositionDeadband;
-         strncpy (scsBase->page0.scsTime, cemtime, CEM_TIME_SIZE - 1);
+         page0Image.bandwidth = localPtr->bandwidth;
+         page0Image.xTiltGain = localPtr->xTiltGain;
+         page0Image.yTiltGain = localPtr->yTiltGain;
+         page0Image.zFocusGain = localPtr->zFocusGain;
+         page0Image.xTiltShift = localPtr->xTiltShift;
+         page0Image.yTiltShift = localPtr->yTiltShift;
+         page0Image.zFocusShift = localPtr->zFocusShift;
+         page0Image.xTiltSmooth = localPtr->xTiltSmooth;
+         page0Image.yTiltSmooth = localPtr->yTiltSmooth;
+         page0Image.zFocusSmooth = localPtr->zFocusSmooth;
+         page0Image.xTcsMinRange = localPtr->xTcsMinRange;
+         page0Image.yTcsMinRange = localPtr->yTcsMinRange;
+         page0Image.xTcsMaxRange = localPtr->xTcsMaxRange;
+         page0Image.yTcsMaxRange = localPtr->yTcsMaxRange;
+         page0Image.xPMinRange = localPtr->xPMinRange;
+         page0Image.yPMinRange = localPtr->yPMinRange;
+         page0Image.xPMaxRange = localPtr->xPMaxRange;
+         page0Image.yPMaxRange = localPtr->yPMaxRange;
+         page0Image.follower = localPtr->follower;
+         page0Image.foldir = localPtr->foldir;
+         page0Image.followersteps = localPtr->followersteps;
+         page0Image.offloader = localPtr->offloader;
+         page0Image.ofldir = localPtr->ofldir;
+         page0Image.offloadersteps = localPtr->offloadersteps;
+         page0Image.cbafdir = localPtr->cbafdir;
+         page0Image.cbsteps = localPtr->cbsteps;
+         page0Image.deployable_baffle = localPtr->deployable_baffle;
+         page0Image.dbafdir = localPtr->dbafdir;
+         page0Image.dbsteps = localPtr->dbsteps;
+         page0Image.xy_motor = localPtr->xy_motor;
+         page0Image.xydir = localPtr->xydir;
+         page0Image.xysteps = localPtr->xysteps;
+         page0Image.xyPositionDeadband = localPtr->xyPositionDeadband;
+         strncpy (page0Image.scsTime, cemtime, CEM_TIME_SIZE - 1);
+
+         /* the demands taken for this frame go with it */
+         scheduleArm ();
+
+         /* commands waiting for this copy of the page may now be sent */
+         commandPageRefreshed (pageGeneration);
+
+         epicsMutexUnlock(page0Free);
 
       }
       else
@@ -2184,6 +3090,13 @@ void slowTransmit (void)
          m2Ptr->page0.yTiltSmooth = localPtr->yTiltSmooth;
          m2Ptr->page0.zFocusSmooth = localPtr->zFocusSmooth;
          /* some missing here */
+
+         /* the demands taken for this frame go with it */
+         scheduleArm ();
+
+         /* commands waiting for this copy of the page may now be sent */
+         commandPageRefreshed (pageGeneration);
+
          epicsMutexUnlock(m2MemFree);
       }
    } // for(;;)
@@ -2216,7 +3129,7 @@ void slowTransmit (void)
  *
  * Globals:
  *      External functions:
- *              checkSum
+ *              checkSumFast
  *
  *      External variables:
  *              scsDataAvailable
@@ -2249,7 +3162,7 @@ void tiltReceive (void)
 
          epicsMutexMustLock(m2MemFree);
 
-         scsCheck = checkSum ((void *) &m2Ptr->page0.NS, COMMAND_BLOCK_SIZE);
+         scsCheck = checkSumFast ((void *) &m2Ptr->page0.NS, COMMAND_BLOCK_SIZE);
 
          if (scsCheck == m2Ptr->page0.checksum) {
 
@@ -2292,7 +3205,7 @@ void tiltReceive (void)
 
            /* package status data to return to SCS */
            m2Ptr->page1.heartbeat = m2Heartbeat++;
-           m2Ptr->page1.checksum = checkSum ((void *) &m2Ptr->page1.NR, 
+           m2Ptr->page1.checksum = checkSumFast ((void *) &m2Ptr->page1.NR, 
                  STATUS_BLOCK_SIZE);
 
            epicsMutexUnlock(m2MemFree);
@@ -2317,6 +3230,152 @@ void tiltReceive (void)
    }
 }
 
+/* ===================================================================== */
+/*
+ * Function name:
+ * publishStatus
+ *
+ * Purpose:
+ * Publish a checked status frame as the latest snapshot. Only scsReceive
+ * calls this, so it writes the slot after the latest without a lock.
+ *
+ * Invocation:
+ * publishStatus(status)
+ *
+ * Parameters in:
+ *      > status    statusBlock*  checked status frame
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void publishStatus (const statusBlock *status)
+{
+   int next = (statusLatest + 1) % STATUS_RING_SIZE;
+   statusSlot *slot = &statusRing[next];
+
+   epicsAtomicIncrIntT (&slot->sequence);          /* odd, being written */
+   epicsAtomicWriteMemoryBarrier ();
+
+   memcpy ((void *) &slot->status, (const void *) status, 
+         STATUS_SNAPSHOT_SIZE);
+   slot->generation = statusGeneration + 1;
+
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicIncrIntT (&slot->sequence);          /* even, complete */
+
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicSetIntT (&statusLatest, next);
+   epicsAtomicIncrIntT (&statusGeneration);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * readStatus
+ *
+ * Purpose:
+ * Copy the latest status frame from M2 without taking refMemFree. The
+ * copy is retried if scsReceive rewrote the slot while it was being read,
+ * which needs it to publish STATUS_RING_SIZE frames during one copy.
+ * Only the words in use are copied, the pad of status is left alone.
+ *
+ * Invocation:
+ * generation = readStatus(status)
+ *
+ * Parameters out:
+ *      < status       statusBlock*  latest status frame
+ *
+ * Return value:
+ *      < generation   long   number of frames published up to this one,
+ *                            0 if none has been received yet
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+long readStatus (statusBlock *status)
+{
+   const statusSlot *slot;
+   int sequence, generation;
+
+   do
+   {
+      slot = &statusRing[epicsAtomicGetIntT (&statusLatest)];
+      sequence = epicsAtomicGetIntT (&slot->sequence);
+
+      epicsAtomicReadMemoryBarrier ();
+
+      memcpy ((void *) status, (const void *) &slot->status,
+            STATUS_SNAPSHOT_SIZE);
+      generation = slot->generation;
+
+      epicsAtomicReadMemoryBarrier ();
+   } while ((sequence & 1) || epicsAtomicGetIntT (&slot->sequence) != sequence);
+
+   return (long) generation;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * archiveStatus
+ *
+ * Purpose:
+ * Add the position in an accepted status frame, with the TCS demands of
+ * the current beam, to the position history read by projectSource
+ *
+ * Invocation:
+ * archiveStatus(&status)
+ *
+ * Parameters in:
+ *              > status   statusBlock*   frame just accepted
+ *
+ * Globals:
+ *    External functions:
+ *    writeArchive
+ *
+ *    External variables:
+ *    > setPoint, currentBeam
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void archiveStatus (const statusBlock *status)
+{
+   double setX, setY, setZ;
+
+   epicsMutexLock(setPointFree);
+   switch (currentBeam)
+   {
+      case BEAMB:
+         setX = setPoint.xTiltB;
+         setY = setPoint.yTiltB;
+         break;
+
+      case BEAMC:
+         setX = setPoint.xTiltC;
+         setY = setPoint.yTiltC;
+         break;
+
+      default:
+         setX = setPoint.xTiltA;
+         setY = setPoint.yTiltA;
+   }
+   setZ = setPoint.zFocus;
+   epicsMutexUnlock(setPointFree);
+
+   writeArchive (status->xTilt, status->yTilt, status->zFocus,
+         setX, setY, setZ);
+}
+
 /* ===================================================================== */
 /*
  * Function name:
@@ -2352,6 +3411,8 @@ void tiltReceive (void)
  *
  * History:
  * 15-Oct-1997: Original(srp)
+ * 17-Oct-2026: Read only the words in use and publish them with
+ *              publishStatus
  *
  */
 
@@ -2362,6 +3423,9 @@ void scsReceive (void)
    long simCheck = 0xabcd;
    statusBlock localStatusBlock;
 
+   /* only the words in use are read, keep the pad defined for grab */
+   memset ((void *) &localStatusBlock, 0, sizeof (statusBlock));
+
    for (;;)
    {
       if (epicsEventWaitWithTimeout(scsReceiveNow, RECEIVE_TIMEOUT) == epicsEventWaitOK)
@@ -2370,7 +3434,8 @@ void scsReceive (void)
          {
             /* no simulation active, grab data from reflective memory */
 
-            localStatusBlock = *(statusBlock *) & scsBase->page1;
+            memcpy ((void *) &localStatusBlock, (void *) &scsBase->page1,
+                  STATUS_SNAPSHOT_SIZE);
 
             /* grab the engineering data for logging */
             /* only does anything if m2LogActive is set (via
@@ -2393,7 +3458,8 @@ void scsReceive (void)
          {
             /* simulation active, get data from m2 buffers */
             epicsMutexLock(m2MemFree);
-            localStatusBlock = *(statusBlock *) & m2Ptr->page1;
+            memcpy ((void *) &localStatusBlock, (void *) &m2Ptr->page1,
+                  STATUS_SNAPSHOT_SIZE);
             epicsMutexUnlock(m2MemFree);
 
             /* grab the engineering data for logging */
@@ -2403,7 +3469,7 @@ void scsReceive (void)
          /* check the received block */
 
          simCheck = 
-            checkSum ((void *) &localStatusBlock.NR, STATUS_BLOCK_SIZE);
+            checkSumFast ((void *) &localStatusBlock.NR, STATUS_BLOCK_SIZE);
 
          /* for diagnostics, grab a whole frame with checksum */
 
@@ -2424,8 +3490,12 @@ void scsReceive (void)
                /* all is well, copy the checked data to the scs buffer */
                local.m2Heartbeat = localStatusBlock.heartbeat;
 
+               publishStatus (&localStatusBlock);
+               archiveStatus (&localStatusBlock);
+
                epicsMutexLock(refMemFree);
-               *(statusBlock *) & scsPtr->page1 = localStatusBlock;
+               memcpy ((void *) &scsPtr->page1, (void *) &localStatusBlock,
+                     STATUS_SNAPSHOT_SIZE);
                epicsMutexUnlock(refMemFree);
 
 
@@ -2434,6 +3504,8 @@ void scsReceive (void)
                   errorLog ("scsReceive - frame unacknowledged", 1, ON);
                }
 
+               commandAcknowledge (localStatusBlock.NR);
+
                if (local.testRequest == 0 && 
                      localStatusBlock.statusWord.flags.diagnosticsAvailable == 1)
                {
@@ -2443,7 +3515,7 @@ void scsReceive (void)
                }
 
                local.testRequest = 
-                  scsPtr->page1.statusWord.flags.diagnosticsAvailable;
+                  localStatusBlock.statusWord.flags.diagnosticsAvailable;
             }
          }
          else
@@ -2515,6 +3587,7 @@ void scsReceive (void)
 int checkTiltStatus (void)
 {
    bitFieldM2 tiltStatusWord;
+   statusBlock status;
 
    static struct
    {
@@ -2538,9 +3611,8 @@ int checkTiltStatus (void)
 
    /* grab copy of m2 status word */
 
-   epicsMutexLock(refMemFree);
-   tiltStatusWord = scsPtr->page1.statusWord;
-   epicsMutexUnlock(refMemFree);
+   readStatus (&status);
+   tiltStatusWord = status.statusWord;
 
    /* if a fault has arisen that wasn't present before, set health bad */
    if (tiltStatusWord.flags.health != 0 && errorLatch.health == 0)
@@ -2758,23 +3830,23 @@ int updateEventPage (int scsInPosition, int scsPresentBeam)
  *
  * History:
  * 05-Dec-1997: Original(srp)
+ * 17-Oct-2026: Submit through commandSubmit instead of sleeping 1/3s
+ *              before each command
+ * 17-Oct-2026: commandSubmit takes no completion callback
+ * 17-Oct-2026: Completion callback passed on by writeCommandCar
  *
  */
 /* ===================================================================== */
 
-long writeCommand (const long command)
+static long writeCommandDone (const long command, commandDoneFn done,
+      void *arg)
 {
-   long localCommand;
-
-   localCommand = command;
-
    /* if interlocks are active, do not write message to queue */
    if (interlockFlag != ON)
    {
-      // taskDelay(sysClkRateGet()/3);  
-                epicsThreadSleep(1.0/3.0);
-
-      if (epicsMessageQueueSendWithTimeout(commandQId, (char *)&localCommand, sizeof (long), SEM_TIMEOUT) == ERROR)
+      /* processGuides paces the commands by the M2 acknowledgement and
+       * holds them until slowTransmit has copied the command page */
+      if (commandSubmit(command, done, arg) == ERROR)
       {
          epicsPrintf ("failed to append command message %s to message queue\n", 
                m2CmdName[command]);
@@ -2788,67 +3860,48 @@ long writeCommand (const long command)
    }
 }
 
+long writeCommand (const long command)
+{
+   return (writeCommandDone (command, NULL, NULL));
+}
+
 /* ===================================================================== */
 /*
  * Function name:
- * frameConvert
- * 
+ * writeCommandCar
+ *
  * Purpose:
- * Convert demands to new frame of reference
+ * writeCommand for a command whose completion is reported to a CAR. The
+ * caller brackets its commands with commandCarStart and
+ * commandCarRelease; the CAR goes to IDLE once M2 has acknowledged them
+ * all, or to ERR if one of them times out, is flushed or is not queued.
  *
  * Invocation:
- * STATUS = frameConvert(converted *results, frameChange *f, z1, z2)
+ * status = writeCommandCar(commandCode, car);
  *
  * Parameters in:
- * > frameChange *f pointer to structure of skew angles, scales and offsets
- * > converted   *result    pointer to structure to hold results
- * 
- * Parameters out:
- * None
- * 
+ * >       long         command code
+ * >       commandCar*  CAR of the group, from commandCarInit
+ *
  * Return value:
- *      < status    int     OK or ERROR
- *
- * Globals: 
- *  External functions:
- *  None
- * 
- *  External variables:
- * 
- * Requirements:
- * 
- * 
- * Author:
- * Sean Prior  (srp@roe.ac.uk)
- * 
+ * < status        long    as writeCommand
+ *
  * History:
- * 11-Nov-1998: Original(srp)
- * 20-Nov-1998: Modify to include mutex field (srp)
- * 24-Nov-1998: Adapt to SCS usage
+ * 17-Oct-2026: Original
+ *
  */
-
 /* ===================================================================== */
-static int frameConvert (converted *result, 
-                frameChange *f, 
-                const double x, 
-                const double y, 
-                const double z)
+
+long writeCommandCar (const long command, commandCar *car)
 {
-    /* check that frame structure has been initialised */
-    if (f == NULL || result == NULL) {
-        errlogMessage("frame conversion pointers not initialised\n");
-        return(ERROR);
-    }
+   long status;
 
-    /* access frame */
-    epicsMutexLock(f->access); 
-    /* perform the conversion */
-    result->x = f->scaleX*(f->cosTheta*x - f->sinTheta*y) + f->offsetX;
-    result->y = f->scaleY*(f->sinTheta*x + f->cosTheta*y) + f->offsetY;
-    result->z = f->scaleZ * z;
-    epicsMutexUnlock(f->access);
+   epicsAtomicIncrIntT (&car->outstanding);
 
-   return OK;
+   if ((status = writeCommandDone (command, commandCarDone, car)) != 0)
+      commandCarDone (command, 0, COMMAND_FLUSHED, car);
+
+   return (status);
 }
 
 /* ===================================================================== */
@@ -2886,6 +3939,7 @@ static int frameConvert (converted *result,
  *
  * History:
  * 15-Oct-1997: Original(srp)
+ * 17-Oct-2026: Use the biquad cascade if one is loaded
  *
  */
 
@@ -2895,6 +3949,10 @@ double iir_filter (const double input, MATLAB * iir)
 {
   double *inPtr = NULL, *outPtr = NULL, *aPtr = NULL, *bPtr = NULL;
 
+  /* use the cascade form when readFilters was able to factor the filter */
+  if (iir->sos.nsections > 0)
+     return (sosFilter (input, &iir->sos));
+
   iir->inHistory[0] = input;
   iir->outHistory[0] = 0;
 
@@ -2932,15 +3990,245 @@ double iir_filter (const double input, MATLAB * iir)
      return (iir->outHistory[0]);
 }
 
+/* ===================================================================== */
+/*
+ * Function name:
+ * iir_filter3
+ *
+ * Purpose:
+ * perform the filter operation on x, y and z at once. This is the fast
+ * path used by processGuides; iir_filter remains the scalar reference.
+ * The new sample goes into the slot before the current head of the
+ * circular histories so no data is moved, and each tap updates all lanes
+ * with the same coefficient so the compiler can keep the lanes in vector
+ * registers. If the filter has been factored into biquad sections the
+ * cascade is run instead of the direct form.
+ *
+ * Invocation:
+ * iir_filter3(sample, *iir)
+ *
+ * Parameters in:
+ *              > sample  double[MAX_AXES] x, y, z samples to be filtered
+ *              > iir     *FUSED_IIR pointer to the fused filter
+ *
+ * Parameters out:
+ *              < sample  double[MAX_AXES] filtered x, y, z
+ *
+ * Return value:
+ * None
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* ===================================================================== */
+
+void iir_filter3 (double sample[MAX_AXES], FUSED_IIR * iir)
+{
+   double acc[IIR_LANES] = {0.0, 0.0, 0.0, 0.0};
+   double *in = NULL, *out = NULL, *s1 = NULL, *s2 = NULL;
+   double coeff, y;
+   BIQUAD *section = NULL;
+   int head, k, lane;
+
+   /* cascade form: each section runs on all lanes, transposed direct
+    * form II with the state held per lane */
+   if (iir->sos.nsections > 0)
+   {
+      for (lane = 0; lane < MAX_AXES; lane++)
+      {
+         acc[lane] = sample[lane] * iir->sos.gain;
+      }
+
+      for (k = 0; k < iir->sos.nsections; k++)
+      {
+         section = &iir->sos.section[k];
+         s1 = iir->sosState[k][0];
+         s2 = iir->sosState[k][1];
+
+         for (lane = 0; lane < IIR_LANES; lane++)
+         {
+            y = section->b0 * acc[lane] + s1[lane];
+            s1[lane] = section->b1 * acc[lane] - section->a1 * y + s2[lane];
+            s2[lane] = section->b2 * acc[lane] - section->a2 * y;
+            acc[lane] = y;
+         }
+      }
+
+      for (lane = 0; lane < MAX_AXES; lane++)
+      {
+         sample[lane] = acc[lane];
+      }
+
+      return;
+   }
+
+   head = iir->head = (iir->head - 1) & IIR_HISTORY_MASK;
+
+   in = iir->inHistory[head];
+   for (lane = 0; lane < MAX_AXES; lane++)
+   {
+      in[lane] = sample[lane];
+   }
+
+   for (k = 0; k < iir->nb; k++)
+   {
+      coeff = iir->numerator[k];
+      in = iir->inHistory[(head + k) & IIR_HISTORY_MASK];
+
+      for (lane = 0; lane < IIR_LANES; lane++)
+      {
+         acc[lane] += coeff * in[lane];
+      }
+   }
+
+   for (k = 1; k < iir->na; k++)
+   {
+      coeff = iir->denominator[k];
+      out = iir->outHistory[(head + k) & IIR_HISTORY_MASK];
+
+      for (lane = 0; lane < IIR_LANES; lane++)
+      {
+         acc[lane] -= coeff * out[lane];
+      }
+   }
+
+   out = iir->outHistory[head];
+   for (lane = 0; lane < IIR_LANES; lane++)
+   {
+      out[lane] = acc[lane];
+   }
+
+   for (lane = 0; lane < MAX_AXES; lane++)
+   {
+      sample[lane] = acc[lane];
+   }
+}
+
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * cbInit
+ *
+ * Purpose:
+ * Allocate the ring of guide loop records with cbRecordNb records
+ *
+ * Invocation:
+ * status = cbInit()
+ *
+ * Return value:
+ *              < status  int    OK or ERROR
+ *
+ * Globals:
+ *      External variables:
+ *      > cbRecordNb  int    records in the ring, CB_RECORD_NB by default
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int cbInit (void)
+{
+   if (cbRing != NULL)
+      return (OK);
+
+   if (cbRecordNb < 1)
+      cbRecordNb = CB_RECORD_NB;
+
+   if ((cbRing = (telemetrySample *) calloc (cbRecordNb,
+               sizeof (telemetrySample))) == NULL)
+   {
+      errorLog ("cbInit - cannot allocate the guide ring buffer", 1, ON);
+      return (ERROR);
+   }
+
+   cbCounter = 0;
+   cbCount = 0;
+   cbSize = cbRecordNb;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * cbColumn
+ *
+ * Purpose:
+ * Copy one field of the guide ring buffer, oldest record first, for
+ * consumers which want a column rather than records. The field is named
+ * as in the telemetry files (xBeforePID, vtkXPhase, ...).
+ *
+ * Invocation:
+ * count = cbColumn(name, values, maxValues)
+ *
+ * Parameters in:
+ *              > name       char*    field name
+ *              > maxValues  int      size of values
+ *
+ * Parameters out:
+ *              < values     double*  field of each record
+ *
+ * Return value:
+ *              < count      int      values copied, or ERROR if the field
+ *                                    is unknown
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int cbColumn (char *name, double *values, int maxValues)
+{
+   const telemetryField *field;
+   const char *value;
+   int first, count, i;
+
+   if ((field = telemetryFieldFind (name)) == NULL || cbRing == NULL)
+      return (ERROR);
+
+   count = (cbCount < maxValues) ? cbCount : maxValues;
+
+   /* the newest count records, oldest first */
+   first = cbCounter - count;
+   if (first < 0)
+      first += cbSize;
+
+   for (i = 0; i < count; i++)
+   {
+      value = (const char *) &cbRing[(first + i) % cbSize] + field->offset;
+      values[i] = telemetryFieldValue (field, value);
+   }
+
+   return (count);
+}
 
 /* 16-Aug-2000: changed to display in chronological order 
-   16-Aug-2000: added Ax,Ay,Bx,By position demands */
+   16-Aug-2000: added Ax,Ay,Bx,By position demands 
+   17-Oct-2026: read from the ring of telemetrySample records */
 int saveCb ()
 {
     char fileName[80];
     double fileTime;
-    int i;
+    int i, n;
     FILE *pFile;
+    telemetrySample *rec;
 
     
     if (timeNow(&fileTime) != OK)
@@ -2949,6 +4237,12 @@ int saveCb ()
    return (ERROR);
     }
 
+    if (cbRing == NULL)
+    {
+   errorLog ("saveCb - no guide ring buffer\n", 1, ON);
+   return (ERROR);
+    }
+
     sprintf(fileName, "./chop-guide-%d.log", (int)fileTime);
     pFile = fopen ( fileName, "w" );
 
@@ -2958,62 +4252,33 @@ int saveCb ()
         return (ERROR);
     }
 
-    for ( i = cbCounter ; i < CB_RECORD_NB ; i ++ ) 
+    /* write from the oldest data to the newest */
+    for ( n = 0 ; n < cbSize ; n ++ ) 
     {
-        //fprintf ( pFile, "  3 %f %f %f %ld %d\n", 
-      //cbTime[i], cbP2Time[i], cbP2Interval[i], cbTick[i], i);
-        fprintf ( pFile, "  3 %f %f %f %d\n", 
-      cbTime[i], cbP2Time[i], cbP2Interval[i], i);
-        fprintf ( pFile, "  4 %+4.2f %+4.2f %+4.2f\n", 
-      cbXRawGuide[i], cbYRawGuide[i], cbZRawGuide[i]);
-        fprintf ( pFile, "  7 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideBeforePID[i], cbYGuideBeforePID[i], 
-                cbZGuideBeforePID[i]);
-        fprintf ( pFile, "  8 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideAfterPID[i], cbYGuideAfterPID[i], cbZGuideAfterPID[i]);
-        fprintf ( pFile, "  9 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideDemand[i], cbYGuideDemand[i], cbZGuideDemand[i]);
-   fprintf ( pFile, " 10 %1d %1d %1d %1d\n",
-                 cbCurBeam[i], cbApplyGuide[i], cbGuideOnA[i], cbInPos[i] );
-        fprintf ( pFile, " 11 %+4.2f %+4.2f %4.2f %4.2f\n", 
-      cbAXDemand[i], cbAYDemand[i], cbBXDemand[i], cbBYDemand[i]);
-
-#ifdef MK
-        fprintf ( pFile, " 13 %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f \n", 
-      cbVTKXCommand[i], cbVTKXPhaseOld[i], cbVTKXPhaseNew[i], cbVTKXFrequency[i], cbVTKXIntegrator0[i], cbVTKXIntegrator1[i], cbXGuideBeforePID[i], cbXGuidePhasor[i], cbXGuideAfterPID[i], cbXGuideDemand[i]);
-        fprintf ( pFile, " 15 %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f \n", 
-      cbVTKYCommand[i], cbVTKYPhaseOld[i], cbVTKYPhaseNew[i], cbVTKYFrequency[i], cbVTKYIntegrator0[i], cbVTKYIntegrator1[i], cbYGuideBeforePID[i], cbYGuidePhasor[i], cbYGuideAfterPID[i], cbYGuideDemand[i]);
-#endif
-    }
+        i = (cbCounter + n) % cbSize;
+        rec = &cbRing[i];
 
-    /* write from beginning of array to newest data */
-    for ( i = 0 ; i < cbCounter ; i ++ )
-    {
-        //fprintf ( pFile, "  3 %f %f %f %ld %d\n", 
-   //   cbTime[i], cbP2Time[i], cbP2Interval[i], cbTick[i], i);
         fprintf ( pFile, "  3 %f %f %f %d\n", 
-      cbTime[i], cbP2Time[i], cbP2Interval[i], i);
+      rec->time, rec->p2Time, rec->p2Interval, i);
         fprintf ( pFile, "  4 %+4.2f %+4.2f %+4.2f\n", 
-      cbXRawGuide[i], cbYRawGuide[i], cbZRawGuide[i]);
+      rec->xRaw, rec->yRaw, rec->zRaw);
         fprintf ( pFile, "  7 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideBeforePID[i], cbYGuideBeforePID[i], 
-                cbZGuideBeforePID[i]);
+      rec->xBeforePID, rec->yBeforePID, rec->zBeforePID);
         fprintf ( pFile, "  8 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideAfterPID[i], cbYGuideAfterPID[i], cbZGuideAfterPID[i]);
+      rec->xAfterPID, rec->yAfterPID, rec->zAfterPID);
         fprintf ( pFile, "  9 %+4.2f %+4.2f %+4.2f\n", 
-      cbXGuideDemand[i], cbYGuideDemand[i], cbZGuideDemand[i]);
+      rec->xDemand, rec->yDemand, rec->zDemand);
    fprintf ( pFile, " 10 %1d %1d %1d %1d\n",
-                 cbCurBeam[i], cbApplyGuide[i], cbGuideOnA[i], cbInPos[i] );
+                 rec->beam, rec->applyGuide, rec->guideOnA, rec->inPosition );
         fprintf ( pFile, " 11 %+4.2f %+4.2f %4.2f %4.2f\n", 
-      cbAXDemand[i], cbAYDemand[i], cbBXDemand[i], cbBYDemand[i]);
+      rec->axDemand, rec->ayDemand, rec->bxDemand, rec->byDemand);
 
 #ifdef MK
         fprintf ( pFile, " 13 %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f \n", 
-      cbVTKXCommand[i], cbVTKXPhaseOld[i], cbVTKXPhaseNew[i], cbVTKXFrequency[i], cbVTKXIntegrator0[i], cbVTKXIntegrator1[i], cbXGuideBeforePID[i], cbXGuidePhasor[i], cbXGuideAfterPID[i], cbXGuideDemand[i]);
+      rec->vtkXCommand, rec->vtkXPhaseOld, rec->vtkXPhase, rec->vtkXFrequency, rec->vtkXIntegral0, rec->vtkXIntegral1, rec->xBeforePID, rec->xPhasor, rec->xAfterPID, rec->xDemand);
         fprintf ( pFile, " 15 %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f %+7.5f \n", 
-      cbVTKYCommand[i], cbVTKYPhaseOld[i], cbVTKYPhaseNew[i], cbVTKYFrequency[i], cbVTKYIntegrator0[i], cbVTKYIntegrator1[i], cbYGuideBeforePID[i], cbYGuidePhasor[i], cbYGuideAfterPID[i], cbYGuideDemand[i]);
+      rec->vtkYCommand, rec->vtkYPhaseOld, rec->vtkYPhase, rec->vtkYFrequency, rec->vtkYIntegral0, rec->vtkYIntegral1, rec->yBeforePID, rec->yPhasor, rec->yAfterPID, rec->yDemand);
 #endif
-
     }
 
     fclose (pFile);
@@ -3065,6 +4330,9 @@ int saveCb ()
  * 08-Dec-2000  Coeff are computing in detControl.c and the cutoffFreq set by
  *              the user
  * 28-Oct-1998  Original version - Sean Prior
+ * 17-Oct-2026  Run the filter as a biquad section through biquadFilter
+ * 17-Oct-2026  Direct form I section instead of biquadFilter, whose state
+ *              depends on the coefficients
  *-
  */
 
@@ -3074,26 +4342,31 @@ double newDfilter
    int Id
    )
 {
-   int i = 0;
-   double sum = 0;
+   double sum;
 
-   /* put new sample into the array */
-
-   sampleData[2][Id] = newSample;
-
-   /* multiply samples by coefficients and accumulate */
+   if (Id < 0 || Id > 2)
+   {
+      errlogPrintf("newDfilter - item Id [%d] out of range\n", Id);
+      return(0.0);
+   }
 
-   for(i=0; i < 5; i++)
-      sum += sampleData[i][Id]*coeffData[i][Id];
+   /* coeffData holds the output coefficients (-a1, -a2) followed by the
+    * input coefficients (b0, b1, b2). The state is the raw samples, as in
+    * the original filter, so new coefficients (MK dynamic VTK tuning)
+    * apply from the next sample without a transient; the transposed form
+    * used by biquadFilter keeps products with the old coefficients. */
 
-   /* ripple samples ready for next call */
+   sum = coeffData[0][Id] * newDfilterState[Id].y1
+       + coeffData[1][Id] * newDfilterState[Id].y2
+       + coeffData[2][Id] * newSample
+       + coeffData[3][Id] * newDfilterState[Id].x1
+       + coeffData[4][Id] * newDfilterState[Id].x2;
 
-   sampleData[4][Id] = sampleData[3][Id];
-   sampleData[3][Id] = sampleData[2][Id];
-   sampleData[1][Id] = sampleData[0][Id];
-   sampleData[0][Id] = sum;
+   newDfilterState[Id].x2 = newDfilterState[Id].x1;
+   newDfilterState[Id].x1 = newSample;
+   newDfilterState[Id].y2 = newDfilterState[Id].y1;
+   newDfilterState[Id].y1 = sum;
 
-   /*printf ( "sum[%d] = %f\n" , Id, sum );*/
    return(sum);
 }
 
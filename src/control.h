@@ -29,6 +29,16 @@
  * 16-Dec-1999: Added global variables
  * 19-OCT-2017: Begin conversion to EPICS OSI (mdw)
  * 14-Dec-2017: Changed VSTART to VIBSTART because of <sys/termios.h> conflict (mdw)
+ * 17-Oct-2026: Added RM settle modes and rmSettleShow
+ * 17-Oct-2026: Added guideLoopReport
+ * 17-Oct-2026: commandQId moved to command.h
+ * 17-Oct-2026: Added commandPageInit and page0Free
+ * 17-Oct-2026: Added readStatus
+ * 17-Oct-2026: Added cbInit, cbColumn and cbRecordNb
+ * 17-Oct-2026: Added highSpeed channels, trigger modes and highSpeedFrame (MK)
+ * 17-Oct-2026: Added guideDelayShow
+ * 17-Oct-2026: Added commandPageClear
+ * 17-Oct-2026: Added writeCommandCar
  */
 /* ===================================================================== */
 #ifndef _INCLUDED_CONTROL_H
@@ -36,11 +46,18 @@
 
 #include "chopControl.h"        /* For BEAMA definition */
 #include "guide.h"
+#include "command.h"            /* For commandCar */
 //#include "utilities.h"          /* For MAX_SOURCES */
 
 #define AUTOGUIDE 0
 #define PROJECT   1
 
+/* How processGuides waits for the guide page after ISR3 (rmSettleMode) */
+
+#define RM_SETTLE_NONE  0       /* read the page at once                */
+#define RM_SETTLE_POLL  1       /* spin until the page interval changes */
+#define RM_SETTLE_SLEEP 2       /* sleep rmSettleTimeout, as before     */
+
 #define SCS_NODE                0       /* Node 0 is the SCS       */
 #define M2_NODE                 1       /* Node 1 is the M2 system */      
 #define AGP1_NODE               2       /* Node 2 is the A&G PWFS1 */   
@@ -428,6 +445,37 @@ typedef struct                  /* data from m2 to log */
 #ifdef MK
 #define HS_RECORD_LENGTH 4000
 
+/* Channels captured by highSpeed, in the order of its outputs VALA..VALO */
+
+enum
+{
+    HS_XTILT_POS = 0,
+    HS_YTILT_POS,
+    HS_Z_POS,
+    HS_XTILT_NET_GUIDE,
+    HS_YTILT_NET_GUIDE,
+    HS_Z_NET_GUIDE,
+    HS_VTKX_COMMAND,
+    HS_VTKX_FREQUENCY,
+    HS_VTKX_PHASE,
+    HS_VTKY_COMMAND,
+    HS_VTKY_FREQUENCY,
+    HS_VTKY_PHASE,
+    HS_XRAW_GUIDE,
+    HS_YRAW_GUIDE,
+    HS_ZRAW_GUIDE,
+    HS_CHANNELS
+};
+
+/* hsTriggerMode, what ends a highSpeed capture */
+
+enum
+{
+    HS_TRIGGER_OFF = 0,         /* free running frames                   */
+    HS_TRIGGER_VTK,             /* VTK frequency error above the level   */
+    HS_TRIGGER_STEP             /* guide step above the level            */
+};
+
 typedef struct {
     double xTiltPosHS[HS_RECORD_LENGTH]; /*Set FTV<output> to numsamples*/
     double yTiltPosHS[HS_RECORD_LENGTH]; /*Set FTV<output> to numsamples*/
@@ -457,6 +505,15 @@ enum
 
 void  fireLoops(void *);
 void processGuides(void);
+int rmSettleShow(void);
+int guideDelayShow(void);
+long guideLoopReport(struct genSubRecord *pgsub);
+int commandPageInit(void);
+int commandPageClear(int xyOnly, double xDemand, double yDemand, 
+      double deadband);
+long readStatus(statusBlock *status);
+int cbInit(void);
+int cbColumn(char *name, double *values, int maxValues);
 void slowTransmit(void);
 void tiltReceive(void);
 void scsReceive(void);
@@ -469,8 +526,10 @@ void cemTimerEnd();
 int updateEventPage(int scsInPosition, int scsPresentBeam);
 
 long writeCommand (const long command);
+long writeCommandCar (const long command, commandCar *car);
 
 double iir_filter(const double input, MATLAB* iir);
+void iir_filter3(double sample[MAX_AXES], FUSED_IIR* iir);
 
 /* SCS to M2 command codes */
 enum
@@ -531,11 +590,13 @@ enum
 /* Global variables*/
 
 extern int simLevel;
+extern int cbRecordNb;
 extern memMap *scsPtr;
 extern memMap *scsBase;
 extern memMap *m2Ptr;
 
 extern epicsMutexId m2MemFree;
+extern epicsMutexId page0Free;
 extern epicsMutexId wfsFree[MAX_SOURCES];
 extern epicsMutexId eventDataSem;
 extern epicsMutexId setPointFree;
@@ -547,7 +608,6 @@ extern epicsEventId guideUpdateNow;
 extern epicsEventId scsDataAvailable;
 extern epicsEventId scsReceiveNow;
 
-extern epicsMessageQueueId commandQId;
 extern epicsMessageQueueId receiveQId;
 
 extern long interlockFlag;
@@ -564,6 +624,12 @@ extern PID controller[MAX_AXES];
 
 #ifdef MK
 extern HighSpeed *highSpeedData;
+extern long hsSamples;
+extern long hsTriggerMode;
+extern double hsTriggerLevel;
+extern long hsPreTrigger;
+
+const float *highSpeedFrame (int channel, long *sequence);
 #endif
 
 /* not used extern wfs raw[MAX_SOURCES];*/
@@ -38,6 +38,8 @@
  * 07-May-1999: Added RCS id
  * 15-Dec-1999: Added real2Drive
  * 06-Dec-2017: Begin EPICS OSI conversion (mdw)
+ * 17-Oct-2026: realDrive, real2Drive and statusDrive read M2 status with
+ *              readStatus instead of taking refMemFree
  *
  */
 /* INDENT ON */
@@ -95,10 +97,10 @@
  * 
  * Globals: 
  *  External functions:
- *  None
+ *      readStatus
  * 
  *  External variables:
- *      ! refMemFree
+ *  None
  *
  * 
  * Requirements:
@@ -115,39 +117,38 @@
 /* ===================================================================== */
 long    realDrive (struct genSubRecord * pgsub)
 {
+    statusBlock status;
 
     /* note sense reversal for in position, on ref mem 0 = in position */
 
-    epicsMutexLock(refMemFree);
+    readStatus (&status);
 
-    *(long *) pgsub->vala   = scsPtr->page1.checksum;
-    *(long *) pgsub->valb   = scsPtr->page1.NR;
-    *(double *) pgsub->valc = scsPtr->page1.xTilt;
-    *(double *) pgsub->vald = scsPtr->page1.yTilt;
-    *(double *) pgsub->vale = scsPtr->page1.zFocus;
-    *(double *) pgsub->valf = scsPtr->page1.actuator1;
-    *(double *) pgsub->valg = scsPtr->page1.actuator2;
-    *(double *) pgsub->valh = scsPtr->page1.actuator3;
-    *(long *) pgsub->vali   = scsPtr->page1.inPosition;
+    *(long *) pgsub->vala   = status.checksum;
+    *(long *) pgsub->valb   = status.NR;
+    *(double *) pgsub->valc = status.xTilt;
+    *(double *) pgsub->vald = status.yTilt;
+    *(double *) pgsub->vale = status.zFocus;
+    *(double *) pgsub->valf = status.actuator1;
+    *(double *) pgsub->valg = status.actuator2;
+    *(double *) pgsub->valh = status.actuator3;
+    *(long *) pgsub->vali   = status.inPosition;
 
-    if (scsPtr->page1.chopTransition)
+    if (status.chopTransition)
        *(long *) pgsub->valj   = 0;
     else
        *(long *) pgsub->valj   = 1;
 
-    *(long *) pgsub->valk   = (long) scsPtr->page1.statusWord.all;
-    *(long *) pgsub->vall   = scsPtr->page1.heartbeat;
-    *(long *) pgsub->valm   = scsPtr->page1.beamPosition;
-    *(double *) pgsub->valn = scsPtr->page1.xPosition;
-    *(double *) pgsub->valo = scsPtr->page1.yPosition;
-    *(long *) pgsub->valp   = scsPtr->page1.deployBaffle;
-    *(long *) pgsub->valq   = scsPtr->page1.centralBaffle;
-    *(double *) pgsub->valr = scsPtr->page1.baffleEncoderA;
-    *(double *) pgsub->vals = scsPtr->page1.baffleEncoderB;
-    *(double *) pgsub->valt = scsPtr->page1.baffleEncoderC;
-    *(long *) pgsub->valu   = scsPtr->page1.topEnd;
-
-    epicsMutexUnlock(refMemFree);
+    *(long *) pgsub->valk   = (long) status.statusWord.all;
+    *(long *) pgsub->vall   = status.heartbeat;
+    *(long *) pgsub->valm   = status.beamPosition;
+    *(double *) pgsub->valn = status.xPosition;
+    *(double *) pgsub->valo = status.yPosition;
+    *(long *) pgsub->valp   = status.deployBaffle;
+    *(long *) pgsub->valq   = status.centralBaffle;
+    *(double *) pgsub->valr = status.baffleEncoderA;
+    *(double *) pgsub->vals = status.baffleEncoderB;
+    *(double *) pgsub->valt = status.baffleEncoderC;
+    *(long *) pgsub->valu   = status.topEnd;
 
     return (OK);
 }
@@ -177,10 +178,10 @@ long    realDrive (struct genSubRecord * pgsub)
  * 
  * Globals: 
  *  External functions:
- *  None
+ *      readStatus
  * 
  *  External variables:
- *      ! refMemFree
+ *  None
  *
  * 
  * Requirements:
@@ -198,11 +199,11 @@ long    realDrive (struct genSubRecord * pgsub)
 
 long    real2Drive (struct genSubRecord * pgsub)
 {
+    statusBlock status;
 
-    epicsMutexLock(refMemFree);
-    *(double *) pgsub->vala = scsPtr->page1.upperBearingAngle;
-    *(double *) pgsub->valb = scsPtr->page1.lowerBearingAngle;
-    epicsMutexUnlock(refMemFree);
+    readStatus (&status);
+    *(double *) pgsub->vala = status.upperBearingAngle;
+    *(double *) pgsub->valb = status.lowerBearingAngle;
 
     return (OK);
 }
@@ -494,19 +495,18 @@ long    displayScs2 (struct genSubRecord * pgsub)
 /* ===================================================================== */
 long    statusDrive (struct genSubRecord * pgsub)
 {
+    statusBlock status;
 
-    epicsMutexLock(refMemFree);
+    readStatus (&status);
 
     /* read the m2 status word as bytes and put out to ports */
-    *(long *) pgsub->vala = (char) scsPtr->page1.statusWord.byte[3];
-    *(long *) pgsub->valb = (char) scsPtr->page1.statusWord.byte[2];
-    *(long *) pgsub->valc = (char) scsPtr->page1.statusWord.byte[1];
-    *(long *) pgsub->vald = (char) scsPtr->page1.statusWord.byte[0];
+    *(long *) pgsub->vala = (char) status.statusWord.byte[3];
+    *(long *) pgsub->valb = (char) status.statusWord.byte[2];
+    *(long *) pgsub->valc = (char) status.statusWord.byte[1];
+    *(long *) pgsub->vald = (char) status.statusWord.byte[0];
 
     /* read enclosure temperature */
-    *(double *) pgsub->vale = scsPtr->page1.enclosureTemp;
-
-    epicsMutexUnlock(refMemFree);
+    *(double *) pgsub->vale = status.enclosureTemp;
 
     return (OK);
 }
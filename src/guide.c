@@ -19,6 +19,15 @@
  * CADguideConfig       - Read guide configuration parameters
  * createFilter         - create filter to demanded specification
  * clearFilters         - reset filter history to zero
+ * loadFusedFilter      - copy a source configuration to its fused filter
+ * loadFilterBank       - read the filter coefficient files into memory
+ * designFilter         - design a filter for the exact frequencies requested
+ * retuneFilters        - redesign the designed filters for a new sample rate
+ * filterInit           - create the filter lock and the retune task
+ * filterRetuneRequest  - ask the retune task to redesign for a new rate
+ * guideFilter          - fused filter processGuides should run for a source
+ * guideFilterSwap      - make the staged fused filters active
+ * fetchFilter          - get a filter from the in-memory filter bank
  * displayFilter        - show filter coefficients
  * displayCoeffs        - show filter coefficient table
  * lookupConfig         - keep record of previous guide configs to update widgets
@@ -62,6 +71,17 @@
  *              compiled before control.c (where it used to be declared)
  *              Zero the interval for pwfs2 
  *              Changed tabs to blanks
+ * 17-Oct-2026: Keep a fused three axis filter per source alongside filter[]
+ * 17-Oct-2026: Factor filters into biquad sections when they are read,
+ *              dfilter runs its section through biquadFilter
+ * 17-Oct-2026: Coefficient files are read once into an in-memory filter
+ *              bank, readFilters no longer seeks and reads on every call
+ * 17-Oct-2026: Add NOTCH and designed Butterworth/Chebyshev filters
+ * 17-Oct-2026: highSpeed publishes double buffered frames, with optional
+ *              capture around a VTK error or guide step trigger (MK)
+ * 17-Oct-2026: Fused filters are double buffered and swapped in by
+ *              processGuides, filters are retuned by a low priority task
+ *              under filterFree
  *
  */
 /* INDENT ON */
@@ -72,6 +92,11 @@
 #include <stdlib.h>
 #include <math.h>
 
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+
 #include <tcslib.h>
 #include <cad.h>
 #include <car.h>
@@ -106,6 +131,45 @@
 #define DECIM_CUTOFF        0.05 /* cutoff for decimation filters 
                                     (1.0 = half sample frequency) */
 
+#define FILTER_TABLES       4    /* LOWPASS, HIGHPASS, BANDPASS, BANDSTOP */
+#define FILTER_BLOCK_SIZE   97   /* band filters for the lowest freq1 */
+
+/* In-memory copy of the filter coefficient files, indexed by
+ * filter type - LOWPASS */
+
+typedef struct
+{
+     char    *fileName;
+     FILTER  *entry;
+     int     count;
+} filterTable;
+
+static filterTable filterBank[FILTER_TABLES] =
+{
+     {LOW_COEFFS,  NULL, 0},
+     {HIGH_COEFFS, NULL, 0},
+     {PASS_COEFFS, NULL, 0},
+     {STOP_COEFFS, NULL, 0}
+};
+
+#define DESIGN_CACHE_SIZE   16   /* designed filter configurations kept */
+
+/* Filters designed by designFilter, keyed on everything that goes into
+ * the design */
+
+typedef struct
+{
+     int     valid;
+     int     type;
+     long    design;
+     long    order;
+     double  ripple;
+     double  sampleRate;
+     double  freq1;
+     double  freq2;
+     SOS     sos;
+} designedFilter;
+
 /* Guide source names */
 
 static char *filterName[] =
@@ -116,6 +180,7 @@ static char *filterName[] =
     "HIGHPASS",
     "BANDPASS",
     "BANDSTOP",
+    "NOTCH   ",
     NULL
 };
 
@@ -138,9 +203,13 @@ static MATLAB decFilter[12];
 
 /* define prototypes */
 static int clearFilters (int);
+static void loadFusedFilter (int source);
+static void filterRetuneTask (void);
 int displayFilter (const int source, const int axis);
 static int readFilters (MATLAB * filterAddr, int type, 
                         double freq1, double freq2);
+static int designFilter (MATLAB * filterAddr, int type, double sampleRate,
+                         double freq1, double freq2);
 static double dfilter(double newSample, int Id);
 
 /* Declare external variables */
@@ -176,6 +245,25 @@ int guideMaster[MAX_SOURCES][MAX_BEAMS] =
 
 MATLAB filter[MAX_SOURCES][MAX_AXES];
 
+/* filter design selection, may be changed from the shell */
+long filterDesign = DESIGN_TABLE;
+long filterOrder = 4;           /* prototype order for designed filters */
+double filterRipple = 0.5;      /* Chebyshev passband ripple (dB)       */
+
+/* Fused filters run by processGuides. Each source has two of them: the
+ * active one is run by processGuides, the other is written by createFilter
+ * and clearFilters under filterFree and marked as staged. processGuides
+ * makes staged filters active at the start of a pass (guideFilterSwap),
+ * so it never sees coefficients that are half written. */
+static FUSED_IIR fusedBank[2][MAX_SOURCES];
+static int fusedActive[MAX_SOURCES];
+static int fusedStaged[MAX_SOURCES];
+static int fusedPending = 0;            /* any source staged, atomic    */
+
+static epicsMutexId filterFree = NULL;  /* filter[] and the design cache */
+static epicsEventId filterRetuneNow = NULL;
+static int filterRetuneRate = 0;        /* rate asked for (Hz), atomic  */
+
 #ifdef MK
 HighSpeed *highSpeedData;
 #endif
@@ -667,7 +755,7 @@ long CADguideConfig (struct cadRecord * pcad)
 #endif
                                   NULL } ;
      static char *filterOpts[] = {"OFF", "RAW", "LOWPASS", "HIGHPASS",
-                                  "BANDPASS", "BANDSTOP", NULL} ;
+                                  "BANDPASS", "BANDSTOP", "NOTCH", NULL} ;
 
      cadDirLog ("guideConfig", pcad->dir, 10, pcad);
 
@@ -717,7 +805,7 @@ long CADguideConfig (struct cadRecord * pcad)
                break ;
           }
 
-          if (filterType < NOTUSED || filterType > BANDSTOP)
+          if (filterType < NOTUSED || filterType > NOTCH)
           {
                errorLog ("CADguideConfig - filter type out of range", 2, ON);
                tcsCsAppendMessage (pcad, "filter type out of range") ;
@@ -1353,7 +1441,7 @@ long resetGuideConfig (struct genSubRecord *pgsub)
  *
  * Parameters in:
  *              > source        int     guide source for this filter
- *              > filterType    int     one of OFF or RAW or LOWPASS or HIGHPASS or BANDPASS or BANDSTOP
+ *              > filterType    int     one of OFF or RAW or LOWPASS or HIGHPASS or BANDPASS or BANDSTOP or NOTCH
  *              > sampleRate    double  guide source update rate (Hz)
  *              > freq1         double  low cutoff frequency (Hz)
  *              > freq2         double  high cutoff frequency (Hz)
@@ -1381,6 +1469,9 @@ long resetGuideConfig (struct genSubRecord *pgsub)
  * History:
  * 15-Oct-1997: Original(srp)
  * 09-Jan-1998: Add option to set source OFF
+ * 17-Oct-2026: Design the filter instead of using the coefficient files
+ *              for NOTCH, or if filterDesign is not DESIGN_TABLE
+ * 17-Oct-2026: Hold filterFree while the filter is built and staged
  *
  */
 
@@ -1392,6 +1483,7 @@ weightC)
 {
      double crossover1, crossover2;
      int axis = XTILT;
+     int status;
      MATLAB tempFilter =
      {
           0,
@@ -1421,6 +1513,8 @@ weightC)
           return (ERROR);
      }
 
+     epicsMutexMustLock (filterFree);
+
      switch (filterType)
      {
      case NOTUSED:
@@ -1442,17 +1536,30 @@ weightC)
      case HIGHPASS:
      case BANDPASS:
      case BANDSTOP:
+     case NOTCH:
+
+          if (filterType == NOTCH || (filterDesign != DESIGN_TABLE && filterType != RAW))
+          {
+               /* design the filter for exactly these frequencies */
 
-          /* calculate normalised crossover frequency */
+               status = designFilter (&tempFilter, filterType, sampleRate, freq1, freq2);
+          }
+          else
+          {
+               /* calculate normalised crossover frequency */
+
+               crossover1 = 2 * freq1 / sampleRate;
+               crossover2 = 2 * freq2 / sampleRate;
 
-          crossover1 = 2 * freq1 / sampleRate;
-          crossover2 = 2 * freq2 / sampleRate;
+               /* select filter nearest to the crossover just calculated */
+               /* use a dummy structure in case the configuration is not available */
 
-          /* select filter nearest to the crossover just calculated */
-          /* use a dummy structure in case the configuration is not available */
+               status = readFilters (&tempFilter, filterType, crossover1, crossover2);
+          }
 
-          if ((readFilters (&tempFilter, filterType, crossover1, crossover2)) != OK)
+          if (status != OK)
           {
+               epicsMutexUnlock (filterFree);
                errorLog ("createFilter - unable to retrieve specified filter", 1, ON);
                return (ERROR);
           }
@@ -1493,6 +1600,10 @@ weightC)
           break;
      }
 
+     loadFusedFilter (source);
+
+     epicsMutexUnlock (filterFree);
+
      return (OK);
 }
 
@@ -1533,6 +1644,8 @@ weightC)
  *
  * History:
  * 15-Oct-1997: Original(srp)
+ * 17-Oct-2026: Stage a cleared fused filter instead of clearing the one
+ *              processGuides is running
  *
  */
 
@@ -1543,6 +1656,8 @@ static int clearFilters (int source)
 {
      int axis, i;
 
+     epicsMutexMustLock (filterFree);
+
      for (axis = 0; axis < MAX_AXES; axis++)
      {
           for (i = 0; i < MAX_HISTORY; i++)
@@ -1551,10 +1666,107 @@ static int clearFilters (int source)
                filter[source][axis].outHistory[i] = 0;
 
           }
+          sosClear (&filter[source][axis].sos);
      }
+
+     /* the fused filter processGuides is running is not touched, a copy
+      * with an empty history is staged in its place */
+     loadFusedFilter (source);
+
+     epicsMutexUnlock (filterFree);
+
      return (OK);
 }
 
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * loadFusedFilter
+ *
+ * Purpose:
+ * Copy the coefficients of the XTILT filter of a source, which createFilter
+ * has already copied to YTILT and ZFOCUS, into the inactive fused three
+ * axis filter of the source, clear its history and stage it for
+ * processGuides to swap in. Called with filterFree held.
+ *
+ * Invocation:
+ * loadFusedFilter(source)
+ *
+ * Parameters in:
+ *              > source        int     guide source to load
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ * None
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      filter
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Write the inactive bank and stage it
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static void loadFusedFilter (int source)
+{
+     FUSED_IIR *fused = &fusedBank[!fusedActive[source]][source];
+     MATLAB *iir = &filter[source][XTILT];
+     int i, lane;
+
+     fused->nb = (iir->nb > MAX_HISTORY) ? MAX_HISTORY : iir->nb;
+     fused->na = (iir->na > MAX_HISTORY) ? MAX_HISTORY : iir->na;
+
+     for (i = 0; i < MAX_HISTORY; i++)
+     {
+          fused->numerator[i] = iir->numerator[i];
+          fused->denominator[i] = iir->denominator[i];
+     }
+
+     for (i = 0; i < IIR_HISTORY; i++)
+     {
+          for (lane = 0; lane < IIR_LANES; lane++)
+          {
+               fused->inHistory[i][lane] = 0;
+               fused->outHistory[i][lane] = 0;
+          }
+     }
+     fused->head = 0;
+
+     fused->sos = iir->sos;
+     sosClear (&fused->sos);
+
+     for (i = 0; i < SOS_MAX_SECTIONS; i++)
+     {
+          for (lane = 0; lane < IIR_LANES; lane++)
+          {
+               fused->sosState[i][0][lane] = 0;
+               fused->sosState[i][1][lane] = 0;
+          }
+     }
+
+     fused->type = iir->type;
+
+     /* publish the complete filter before it can be swapped in */
+     fusedStaged[source] = TRUE;
+     epicsAtomicWriteMemoryBarrier ();
+     epicsAtomicSetIntT (&fusedPending, TRUE);
+}
+
 /* ===================================================================== */
 /* INDENT OFF */
 /*
@@ -1663,19 +1875,17 @@ int displayFilter (const int source, const int axis)
 /* INDENT OFF */
 /*
  * Function name:
- * readFilters
+ * loadFilterBank
  *
  * Purpose:
- * Read the predefined filter coefficient values from file
+ * Read the four predefined filter coefficient files into memory so that
+ * filters can be configured later without any file I/O. Each table is
+ * read in one block into a single allocation.
  *
  * Invocation:
- * status = readFilters(filterAddr, type, freq1, freq2)
+ * status = loadFilterBank()
  *
  * Parameters in:
- *              > filterAddr    *FILTER         address of filter structure
- *              > type          int             filter type
- *              > freq1         double          low crossover frequency (Hz)
- *              > freq2         double          high crossover frequency (Hz)
  * None
  *
  * Parameters out:
@@ -1689,45 +1899,147 @@ int displayFilter (const int source, const int axis)
  *      None
  *
  *      External variables:
- *      None
+ *      filterBank
  *
  * Requirements:
+ * Called once from scsInit before any filter is created
  *
  * Author:
- * Sean Prior  (srp@roe.ac.uk)
  *
  * History:
- * 10-Dec-1997: Original(srp)
- * 03-Mar-1998: Load filter files from /data directory rather than /src
- * 04-Mar-1998; pass address of filter structure rather than pointer with malloc
+ * 17-Oct-2026: Original
  *
  */
 
 /* INDENT ON */
 /* ===================================================================== */
 
-static int readFilters (MATLAB * testFilter, int type, double freq1, double freq2)
+static int loadFilterTable (filterTable * table)
 {
      FILE *fptr = NULL;
-     char filename[MAX_STRING_SIZE] = "";
-     int found1 = FALSE;
-     int i, sum1, lim1, blockSize;
+     FILTER *entry = NULL;
+     long size;
+     int count;
 
-     FILTER dummyFilter =
+     if ((fptr = fopen (table->fileName, "rb")) == NULL)
      {
-          0.0,
-          0.0,
-          0,
-          0,
-          {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
-          {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0}
-     };
+          errorLog ("loadFilterTable - Unable to open filter coefficients file", 1, ON);
+          return (ERROR);
+     }
+
+     if (fseek (fptr, 0, SEEK_END) != 0 || (size = ftell (fptr)) <= 0 ||
+         fseek (fptr, 0, SEEK_SET) != 0)
+     {
+          errorLog ("loadFilterTable - unable to size coefficients file", 1, ON);
+          fclose (fptr);
+          return (ERROR);
+     }
+
+     count = (int) (size / sizeof (FILTER));
+
+     if ((entry = (FILTER *) malloc (count * sizeof (FILTER))) == NULL)
+     {
+          errorLog ("loadFilterTable - unable to allocate filter table", 1, ON);
+          fclose (fptr);
+          return (ERROR);
+     }
+
+     if (fread (entry, sizeof (FILTER), count, fptr) != (size_t) count)
+     {
+          errorLog ("loadFilterTable - file coefficients read error", 1, ON);
+          free (entry);
+          fclose (fptr);
+          return (ERROR);
+     }
+
+     fclose (fptr);
+
+     table->count = count;
+     table->entry = entry;
+
+     if (debugLevel > DEBUG_NONE)
+     {
+          printf ("loadFilterTable - %d filters from %s\n", count, table->fileName);
+     }
+
+     return (OK);
+}
+
+int loadFilterBank (void)
+{
+     int i;
+     int status = OK;
 
-     /* read coefficients from file */
+     for (i = 0; i < FILTER_TABLES; i++)
+     {
+          if (filterBank[i].entry == NULL && loadFilterTable (&filterBank[i]) != OK)
+          {
+               status = ERROR;
+          }
+     }
+
+     return (status);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * fetchFilter
+ *
+ * Purpose:
+ * Copy the predefined filter nearest the requested normalised crossover
+ * frequencies out of the in-memory filter bank. No file I/O is done, the
+ * bank must already have been loaded by loadFilterBank.
+ *
+ * The lowpass and highpass tables hold one filter per 0.01 step of freq1.
+ * The bandpass and bandstop tables hold, for each freq1 step, a block of
+ * filters for each freq2 step above it, each block one shorter than the
+ * last, so the start of the block for freq1 step n is
+ * n * FILTER_BLOCK_SIZE - n * (n - 1) / 2.
+ *
+ * Invocation:
+ * status = fetchFilter(filterAddr, type, freq1, freq2)
+ *
+ * Parameters in:
+ *              > filterAddr    *MATLAB         address of filter structure
+ *              > type          int             filter type
+ *              > freq1         double          low crossover (normalised)
+ *              > freq2         double          high crossover (normalised)
+ *
+ * Parameters out:
+ *              < filterAddr    *MATLAB         coefficients and cascade
+ *
+ * Return value:
+ *              < status        int             OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      filterBank
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original, replaces the file seek and read in readFilters
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+int fetchFilter (MATLAB * testFilter, int type, double freq1, double freq2)
+{
+     filterTable *table = NULL;
+     FILTER *entry = NULL;
+     int i, index, lim1;
 
      switch (type)
      {
-          /* open the file corresponding to the filter type        */
           /* for the RAW (no filtering) option use the lowpass     */
           /* higher levels will handle the option                  */
 
@@ -1736,397 +2048,981 @@ static int readFilters (MATLAB * testFilter, int type, double freq1, double freq
 
      case RAW:
      case LOWPASS:
-          strncpy (filename, LOW_COEFFS, MAX_STRING_SIZE - 1);
+          table = &filterBank[LOWPASS - LOWPASS];
           if (freq1 < 0.01 || freq1 > 0.99)
           {
-               errorLog ("readFilters - freq out of range", 1, ON);
+               errorLog ("fetchFilter - freq out of range", 1, ON);
                return (ERROR);
           }
           freq2 = freq1;
           break;
 
      case HIGHPASS:
-          strncpy (filename, HIGH_COEFFS, MAX_STRING_SIZE - 1);
+          table = &filterBank[HIGHPASS - LOWPASS];
           if (freq1 < 0.01 || freq1 > 0.99)
           {
-               errorLog ("readFilters - freq out of range", 1, ON);
+               errorLog ("fetchFilter - freq out of range", 1, ON);
                return (ERROR);
           }
           freq2 = freq1;
           break;
 
      case BANDPASS:
-          strncpy (filename, PASS_COEFFS, MAX_STRING_SIZE - 1);
+          table = &filterBank[BANDPASS - LOWPASS];
           if (freq1 < 0.01 || freq1 > 0.8)
           {
-               errorLog ("readFilters - freq out of range", 1, ON);
+               errorLog ("fetchFilter - freq out of range", 1, ON);
                return (ERROR);
           }
           break;
 
      case BANDSTOP:
-          strncpy (filename, STOP_COEFFS, MAX_STRING_SIZE - 1);
+          table = &filterBank[BANDSTOP - LOWPASS];
           if (freq1 < 0.01 || freq1 > 0.8)
           {
-               errorLog ("readFilters - freq out of range", 1, ON);
+               errorLog ("fetchFilter - freq out of range", 1, ON);
                return (ERROR);
           }
           break;
 
      default:
-          errorLog ("readFilters - filter type not recognised", 2, ON);
+          errorLog ("fetchFilter - filter type not recognised", 2, ON);
           return (ERROR);
      }
 
-     if ((fptr = fopen (filename, "rb")) == NULL)
+     if (table->entry == NULL)
      {
-          errorLog ("readFilters - Unable to open filter coefficients file", 1, ON);
+          errorLog ("fetchFilter - filter bank not loaded", 1, ON);
+          return (ERROR);
      }
-     else
-     {
-          lim1 = (int) (freq1 * 100 - 1);
-
-          if (type < BANDPASS)
-          {
-               sum1 = lim1;
-          }
-          else
-          {
-               /* find file entry corresponding to this limit */
-
-               blockSize = 97;
-               sum1 = 0;
-               i = 0;
-
-               while (i < lim1)
-               {
-                    sum1 += blockSize--;
-                    i++;
-               }
-               sum1 += (int) ((freq2 - freq1) * 100 - 1);
-          }
 
-          /* read coefficients from file */
+     /* find table entry corresponding to this limit */
 
-          if (fseek (fptr, sum1 * sizeof (FILTER), SEEK_SET) != 1)
-          {
-               if (fread ((FILTER *) & dummyFilter, sizeof (FILTER), 1, fptr) != 1)
-               {
-                    errorLog ("readFilters - file coefficients read error", 1, ON);
-               }
-               else
-               {
-                    found1 = TRUE;
-               }
-          }
-          else
-          {
-               printf ("fseek operation failed\n");
-          }
+     lim1 = (int) (freq1 * 100 - 1);
 
-          fclose (fptr);
+     if (type < BANDPASS)
+     {
+          index = lim1;
      }
-
-     if (found1 == TRUE)
+     else
      {
-          /* copy the filter coefficients into the passed filter structure */
-
-          testFilter->na = dummyFilter.na;
-          testFilter->nb = dummyFilter.nb;
+          index = lim1 * FILTER_BLOCK_SIZE - (lim1 * (lim1 - 1)) / 2 +
+                  (int) ((freq2 - freq1) * 100 - 1);
+     }
 
-          if (dummyFilter.na > MAX_HISTORY || dummyFilter.na < 1)
-          {
-               printf ("retrieved filter denominator has %d elements\n", dummyFilter.na);
-               return (ERROR);
-          }
-          else if (dummyFilter.nb > MAX_HISTORY || dummyFilter.nb < 1)
-          {
-               printf ("retrieved filter numerator has %d elements\n", dummyFilter.na);
-               return (ERROR);
-          }
+     if (index < 0 || index >= table->count)
+     {
+          printf ("fetchFilter - no filter for %f, %f in %s\n", freq1, freq2,
+                  table->fileName);
+          return (ERROR);
+     }
 
-          for (i = 0; i < dummyFilter.nb; i++)
-          {
-               testFilter->numerator[i] = dummyFilter.Bcoeffs[i];
-          }
+     entry = &table->entry[index];
 
-          for (i = 0; i < dummyFilter.na; i++)
-          {
-               testFilter->denominator[i] = dummyFilter.Acoeffs[i];
-          }
+     /* copy the filter coefficients into the passed filter structure */
 
-          return (OK);
+     if (entry->na > MAX_HISTORY || entry->na < 1)
+     {
+          printf ("retrieved filter denominator has %d elements\n", entry->na);
+          return (ERROR);
      }
-     else
+     else if (entry->nb > MAX_HISTORY || entry->nb < 1)
      {
-          printf ("readFilters - unable to retrieve filter\n");
+          printf ("retrieved filter numerator has %d elements\n", entry->nb);
           return (ERROR);
      }
-}
-
-#ifdef MK
-void printHS() {
-
-    int i;
-
-    printf("xTiltPosHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->xTiltPosHS[i]);
-    printf("\n");
-return;
 
-    printf("yTiltPosHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->yTiltPosHS[i]);
-    printf("\n");
+     testFilter->na = entry->na;
+     testFilter->nb = entry->nb;
 
-    printf("zPosHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->zPosHS[i]);
-    printf("\n");
-
-    printf("xTiltNetGuideHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->xTiltNetGuideHS[i]);
-    printf("\n");
-
-    printf("yTiltNetGuideHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->yTiltNetGuideHS[i]);
-    printf("\n");
-
-    printf("zNetGuideHS:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->zNetGuideHS[i]);
-    printf("\n");
-
-    printf("vtkXCommand:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkXCommand[i]);
-    printf("\n");
-
-    printf("vtkXFrequency:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkXFrequency[i]);
-    printf("\n");
-
-    printf("vtkXPhase:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkXPhase[i]);
-    printf("\n");
-
-
-    printf("vtkYCommand:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkYCommand[i]);
-    printf("\n");
+     for (i = 0; i < entry->nb; i++)
+     {
+          testFilter->numerator[i] = entry->Bcoeffs[i];
+     }
 
-    printf("vtkYFrequency:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkYFrequency[i]);
-    printf("\n");
+     for (i = 0; i < entry->na; i++)
+     {
+          testFilter->denominator[i] = entry->Acoeffs[i];
+     }
 
-    printf("vtkYPhase:");
-    for (i=0; i<200; i++)
-        printf("[%d]=%f ",i, highSpeedData->vtkYPhase[i]);
-    printf("\n");
+     /* factor into second order sections, keep the direct form
+      * if the filter cannot be factored accurately */
 
+     if (tf2sos (testFilter->numerator, entry->nb,
+                 testFilter->denominator, entry->na,
+                 &testFilter->sos) != OK)
+     {
+          errorLog ("fetchFilter - using direct form filter", 2, ON);
+     }
 
+     return (OK);
 }
 
+/* ===================================================================== */
+/* INDENT OFF */
 /*
+ * Function name:
+ * readFilters
  *
+ * Purpose:
+ * Retrieve the predefined filter coefficient values. The coefficients
+ * come from the in-memory filter bank; the bank is only read from file
+ * here if scsInit has not already loaded it.
  *
+ * Invocation:
+ * status = readFilters(filterAddr, type, freq1, freq2)
  *
- */
-long initHighSpeed (struct genSubRecord *pgsub) {
-
-   printf("initHighSpeed\n");
-   /*HighSpeed Initialize*/
-   if ((highSpeedData = (HighSpeed *) calloc (0, sizeof (*highSpeedData) ) ) == NULL)    
-   {
-       printf ("calloc fail on creation of highSpeedData buffer\n");
-       return (ERROR);
-   }
+ * Parameters in:
+ *              > filterAddr    *FILTER         address of filter structure
+ *              > type          int             filter type
+ *              > freq1         double          low crossover frequency (Hz)
+ *              > freq2         double          high crossover frequency (Hz)
+ * None
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ *              < status        int             OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ * Sean Prior  (srp@roe.ac.uk)
+ *
+ * History:
+ * 10-Dec-1997: Original(srp)
+ * 03-Mar-1998: Load filter files from /data directory rather than /src
+ * 04-Mar-1998; pass address of filter structure rather than pointer with malloc
+ * 17-Oct-2026: Use the in-memory filter bank via fetchFilter
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static int readFilters (MATLAB * testFilter, int type, double freq1, double freq2)
+{
+     if (loadFilterBank () != OK)
+     {
+          errorLog ("readFilters - filter bank incomplete", 2, ON);
+     }
+
+     if (fetchFilter (testFilter, type, freq1, freq2) != OK)
+     {
+          printf ("readFilters - unable to retrieve filter\n");
+          return (ERROR);
+     }
+
+     return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * designFilter
+ *
+ * Purpose:
+ * Design a filter for the exact frequencies and sample rate requested
+ * rather than taking the nearest entry from the coefficient files. The
+ * method, order and ripple are taken from filterDesign, filterOrder and
+ * filterRipple. Designs are cached so that switching between a few
+ * configurations does not repeat the design.
+ *
+ * Invocation:
+ * status = designFilter(filterAddr, type, sampleRate, freq1, freq2)
+ *
+ * Parameters in:
+ *              > filterAddr    *MATLAB         address of filter structure
+ *              > type          int             filter type
+ *              > sampleRate    double          sample rate (Hz)
+ *              > freq1         double          low crossover frequency (Hz)
+ *              > freq2         double          high crossover frequency (Hz)
+ *
+ * Parameters out:
+ *              < filterAddr    *MATLAB         coefficients filled in
+ *
+ * Return value:
+ *              < status        int             OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      sosDesign, sos2tf
+ *
+ *      External variables:
+ *      filterDesign, filterOrder, filterRipple
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static int designFilter (MATLAB * testFilter, int type, double sampleRate,
+                         double freq1, double freq2)
+{
+     static designedFilter cache[DESIGN_CACHE_SIZE];
+     static int next = 0;
+     designedFilter *entry = NULL;
+     double b[2 * SOS_MAX_SECTIONS + 1], a[2 * SOS_MAX_SECTIONS + 1];
+     int band, method, i, n;
+
+     switch (type)
+     {
+     case LOWPASS:
+          band = SOS_LOWPASS;
+          break;
+
+     case HIGHPASS:
+          band = SOS_HIGHPASS;
+          break;
+
+     case BANDPASS:
+          band = SOS_BANDPASS;
+          break;
+
+     case BANDSTOP:
+          band = SOS_BANDSTOP;
+          break;
+
+     case NOTCH:
+          band = SOS_NOTCH;
+          break;
+
+     default:
+          errorLog ("designFilter - filter type cannot be designed", 2, ON);
+          return (ERROR);
+     }
+
+     method = (filterDesign == DESIGN_CHEBYSHEV) ? SOS_CHEBYSHEV : SOS_BUTTERWORTH;
+
+     if (sampleRate <= 0.0)
+     {
+          errorLog ("designFilter - sample rate out of range", 2, ON);
+          return (ERROR);
+     }
+
+     for (i = 0; i < DESIGN_CACHE_SIZE; i++)
+     {
+          if (cache[i].valid && cache[i].type == type &&
+              cache[i].design == filterDesign && cache[i].order == filterOrder &&
+              cache[i].ripple == filterRipple && cache[i].sampleRate == sampleRate &&
+              cache[i].freq1 == freq1 && cache[i].freq2 == freq2)
+          {
+               entry = &cache[i];
+               break;
+          }
+     }
+
+     if (entry == NULL)
+     {
+          /* not designed before, replace the oldest entry */
+
+          entry = &cache[next];
+          next = (next + 1) % DESIGN_CACHE_SIZE;
+          entry->valid = 0;
+
+          if (sosDesign (band, method, (int) filterOrder, filterRipple,
+                         freq1 / sampleRate, freq2 / sampleRate, &entry->sos) != OK)
+          {
+               errorLog ("designFilter - unable to design filter", 2, ON);
+               return (ERROR);
+          }
+
+          entry->type = type;
+          entry->design = filterDesign;
+          entry->order = filterOrder;
+          entry->ripple = filterRipple;
+          entry->sampleRate = sampleRate;
+          entry->freq1 = freq1;
+          entry->freq2 = freq2;
+          entry->valid = 1;
+
+          if (debugLevel > DEBUG_MIN)
+          {
+               printf ("designFilter - type %d at %f Hz designed\n", type, sampleRate);
+          }
+     }
+
+     /* direct form for display and for the coefficient driven paths,
+        the cascade is what is run */
+
+     n = sos2tf (&entry->sos, b, a);
+
+     testFilter->nb = n;
+     testFilter->na = n;
+
+     for (i = 0; i < 11; i++)
+     {
+          testFilter->numerator[i] = (i < n) ? b[i] * entry->sos.gain : 0.0;
+          testFilter->denominator[i] = (i < n) ? a[i] : 0.0;
+     }
+
+     testFilter->sos = entry->sos;
+
+     return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * retuneFilters
+ *
+ * Purpose:
+ * Redesign the designed filters (NOTCH, or any filter when filterDesign
+ * is not DESIGN_TABLE) of every source for a new sample rate, keeping
+ * their type, frequencies and weights. Table filters are left alone.
+ *
+ * Invocation:
+ * status = retuneFilters(sampleRate)
+ *
+ * Parameters in:
+ *              > sampleRate    double          new sample rate (Hz)
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ *              < status        int             OK or ERROR if any source
+ *                                              could not be redesigned
+ *
+ * Globals:
+ *      External functions:
+ *      createFilter
+ *
+ *      External variables:
+ *      filter, filterDesign
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+int retuneFilters (double sampleRate)
+{
+     MATLAB *current;
+     int source, status = OK;
+
+     epicsMutexMustLock (filterFree);
+
+     for (source = PWFS1; source <= GYRO; source++)
+     {
+          current = &filter[source][XTILT];
+
+          if (current->sampleFreq == sampleRate)
+               continue;
+
+          if (current->type == NOTCH ||
+              (filterDesign != DESIGN_TABLE && current->type > RAW))
+          {
+               if (createFilter (source, current->type, sampleRate,
+                                 current->freq1, current->freq2, current->weightA,
+                                 current->weightB, current->weightC) != OK)
+               {
+                    status = ERROR;
+               }
+          }
+     }
+
+     epicsMutexUnlock (filterFree);
+
+     return (status);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * filterInit
+ *
+ * Purpose:
+ * Create the lock shared by everything that builds filters and the low
+ * priority task that redesigns them when the guide rate changes. Must be
+ * called before the first createFilter.
+ *
+ * Invocation:
+ * status = filterInit()
+ *
+ * Parameters in:
+ * None
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ *              < status        int             OK or ERROR
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+int filterInit (void)
+{
+     if (filterFree != NULL)
+          return (OK);
+
+     if ((filterFree = epicsMutexCreate ()) == NULL ||
+         (filterRetuneNow = epicsEventCreate (epicsEventEmpty)) == NULL)
+     {
+          errorLog ("filterInit - cannot create filter semaphores", 1, ON);
+          return (ERROR);
+     }
+
+     if (!epicsThreadCreate ("tFilterRetune", epicsThreadPriorityLow,
+                             epicsThreadGetStackSize (epicsThreadStackMedium),
+                             (EPICSTHREADFUNC) filterRetuneTask, (void *) NULL))
+     {
+          errorLog ("filterInit - cannot spawn the retune task", 1, ON);
+          return (ERROR);
+     }
+
+     return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * filterRetuneTask
+ *
+ * Purpose:
+ * Wait for processGuides to ask for a new guide rate and redesign the
+ * filters for it. Runs at low priority so that the design, and any
+ * logging it does, never delays a guide sample.
+ *
+ * Invocation:
+ * filterRetuneTask()
+ *
+ * Parameters in:
+ * None
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ * None
+ *
+ * Globals:
+ *      External functions:
+ *      retuneFilters
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static void filterRetuneTask (void)
+{
+     int rate;
+
+     for (;;)
+     {
+          epicsEventMustWait (filterRetuneNow);
+
+          /* only the latest rate matters if several were asked for */
+          rate = epicsAtomicGetIntT (&filterRetuneRate);
+
+          if (rate > 0 && retuneFilters ((double) rate) != OK)
+               errorLog ("filterRetuneTask - unable to retune guide filters", 1, ON);
+     }
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * filterRetuneRequest
+ *
+ * Purpose:
+ * Ask the retune task to redesign the filters for a new guide rate.
+ * Does not block, so it may be called from processGuides.
+ *
+ * Invocation:
+ * filterRetuneRequest(sampleRate)
+ *
+ * Parameters in:
+ *              > sampleRate    long            new sample rate (Hz)
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ * None
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+void filterRetuneRequest (long sampleRate)
+{
+     if (filterRetuneNow == NULL)
+          return;
+
+     epicsAtomicSetIntT (&filterRetuneRate, (int) sampleRate);
+     epicsEventSignal (filterRetuneNow);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * guideFilter
+ *
+ * Purpose:
+ * Return the fused filter processGuides should run for a source. Only
+ * processGuides may use it, since only processGuides swaps filters.
+ *
+ * Invocation:
+ * fused = guideFilter(source)
+ *
+ * Parameters in:
+ *              > source        int             guide source
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ *              < fused         FUSED_IIR *     active filter of the source
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+FUSED_IIR *guideFilter (int source)
+{
+     return (&fusedBank[fusedActive[source]][source]);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * guideFilterSwap
+ *
+ * Purpose:
+ * Make the fused filters staged by createFilter or clearFilters active.
+ * Called by processGuides at the start of a pass. If a filter is being
+ * built the swap is left for the next pass rather than waiting for it.
+ *
+ * Invocation:
+ * guideFilterSwap()
+ *
+ * Parameters in:
+ * None
+ *
+ * Parameters out:
+ * None
+ *
+ * Return value:
+ * None
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+void guideFilterSwap (void)
+{
+     int source;
+
+     if (!epicsAtomicGetIntT (&fusedPending))
+          return;
+
+     if (epicsMutexTryLock (filterFree) != epicsMutexLockOK)
+          return;
+
+     for (source = 0; source < MAX_SOURCES; source++)
+     {
+          if (fusedStaged[source])
+          {
+               fusedActive[source] = !fusedActive[source];
+               fusedStaged[source] = FALSE;
+          }
+     }
+     epicsAtomicSetIntT (&fusedPending, FALSE);
+
+     epicsMutexUnlock (filterFree);
+}
+
+#ifdef MK
+/* High speed capture for the engineering waveforms. Each call of
+ * highSpeed adds one sample of HS_CHANNELS values. Samples are written in
+ * order into the fill frame; when it holds hsSamples samples it becomes
+ * the published frame and the other frame is filled. In a triggered mode
+ * the fill frame is used as a ring until the trigger, and a frame of
+ * hsPreTrigger samples before and the rest after the trigger is published.
+ * The published frame is always complete and in time order. */
+
+static float hsFrame[2][HS_CHANNELS][HS_RECORD_LENGTH];
+static int hsFill = 0;                /* frame being written            */
+static int hsPublished = -1;          /* frame last published, or -1    */
+static long hsCount = 0;              /* samples in the fill frame      */
+static long hsHead = 0;               /* next ring position, triggered  */
+static long hsPost = -1;              /* samples still wanted after the
+                                         trigger, -1 if not triggered    */
+static long hsSequence = 0;           /* frames published               */
+
+long hsSamples = HS_RECORD_LENGTH;    /* samples per published frame    */
+long hsTriggerMode = HS_TRIGGER_OFF;
+double hsTriggerLevel = 1.0;          /* VTK frequency error or step    */
+long hsPreTrigger = HS_RECORD_LENGTH/4;
+
+static const char *hsChannelName[HS_CHANNELS] =
+{
+    "xTiltPosHS", "yTiltPosHS", "zPosHS",
+    "xTiltNetGuideHS", "yTiltNetGuideHS", "zNetGuideHS",
+    "vtkXCommand", "vtkXFrequency", "vtkXPhase",
+    "vtkYCommand", "vtkYFrequency", "vtkYPhase",
+    "xRawGuideHS", "yRawGuideHS", "zRawGuideHS"
+};
+
+/*
+ * highSpeedFrame - the published frame of one channel, oldest sample
+ * first, with the number of frames published so far. NULL until the first
+ * frame is complete.
+ */
+const float *highSpeedFrame (int channel, long *sequence)
+{
+    int frame = hsPublished;
+
+    if (sequence != NULL)
+        *sequence = hsSequence;
+
+    if (frame < 0 || channel < 0 || channel >= HS_CHANNELS)
+        return (NULL);
+
+    return (hsFrame[frame][channel]);
+}
+
+void printHS() {
+
+    int i, channel;
+    long sequence;
+    const float *data;
+
+    for (channel = 0; channel < HS_CHANNELS; channel++)
+    {
+        if ((data = highSpeedFrame (channel, &sequence)) == NULL)
+        {
+            printf("no high speed frame yet\n");
+            return;
+        }
+
+        printf("%s (frame %ld):", hsChannelName[channel], sequence);
+        for (i=0; i<200; i++)
+            printf("[%d]=%f ",i, data[i]);
+        printf("\n");
+    }
+}
+
+/*
+ * hsRotate - put a frame filled as a ring in time order, the oldest
+ * sample being at position first
+ */
+static void hsRotate (float *data, long length, long first)
+{
+    long i, j;
+    float t;
+
+    if (first <= 0 || first >= length)
+        return;
+
+    for (i = 0, j = first - 1; i < j; i++, j--)
+    {
+        t = data[i]; data[i] = data[j]; data[j] = t;
+    }
+    for (i = first, j = length - 1; i < j; i++, j--)
+    {
+        t = data[i]; data[i] = data[j]; data[j] = t;
+    }
+    for (i = 0, j = length - 1; i < j; i++, j--)
+    {
+        t = data[i]; data[i] = data[j]; data[j] = t;
+    }
+}
+
+/*
+ * hsPublish - make the fill frame the published frame, copy it once to the
+ * genSub outputs and start filling the other frame
+ */
+static void hsPublish (struct genSubRecord *pgsub, long length)
+{
+    void *out[HS_CHANNELS];
+    int channel;
+
+    out[HS_XTILT_POS] = pgsub->vala;
+    out[HS_YTILT_POS] = pgsub->valb;
+    out[HS_Z_POS] = pgsub->valc;
+    out[HS_XTILT_NET_GUIDE] = pgsub->vald;
+    out[HS_YTILT_NET_GUIDE] = pgsub->vale;
+    out[HS_Z_NET_GUIDE] = pgsub->valf;
+    out[HS_VTKX_COMMAND] = pgsub->valg;
+    out[HS_VTKX_FREQUENCY] = pgsub->valh;
+    out[HS_VTKX_PHASE] = pgsub->vali;
+    out[HS_VTKY_COMMAND] = pgsub->valj;
+    out[HS_VTKY_FREQUENCY] = pgsub->valk;
+    out[HS_VTKY_PHASE] = pgsub->vall;
+    out[HS_XRAW_GUIDE] = pgsub->valm;
+    out[HS_YRAW_GUIDE] = pgsub->valn;
+    out[HS_ZRAW_GUIDE] = pgsub->valo;
+
+    hsPublished = hsFill;
+    hsFill = 1 - hsFill;
+    hsSequence++;
+
+    for (channel = 0; channel < HS_CHANNELS; channel++)
+    {
+        memcpy (out[channel], hsFrame[hsPublished][channel],
+                length*sizeof (float));
+        if (length < HS_RECORD_LENGTH)
+            memset ((float *)out[channel] + length, 0,
+                    (HS_RECORD_LENGTH - length)*sizeof (float));
+    }
+
+    *(long *) pgsub->valt = hsSequence;
+}
+
+/*
+ *
+ *
+ *
+ */
+long initHighSpeed (struct genSubRecord *pgsub) {
+
+   printf("initHighSpeed\n");
+   /*HighSpeed Initialize*/
+   if ((highSpeedData = (HighSpeed *) calloc (0, sizeof (*highSpeedData) ) ) == NULL)    
+   {
+       printf ("calloc fail on creation of highSpeedData buffer\n");
+       return (ERROR);
+   }
 
    printf("HighSpeed calloc set to %p\n",highSpeedData);
 
+   hsFill = 0;
+   hsPublished = -1;
+   hsCount = 0;
+   hsHead = 0;
+   hsPost = -1;
+
    printf("initHighSpeed good\n");
   return(OK);
 }
 
 
-long hsSamples = HS_RECORD_LENGTH/100;
 /***
  *
+ * highSpeed - add one sample to the fill frame and publish the frame when
+ * it is complete. VALA..VALO are only written when a frame is published,
+ * once per frame, so the waveforms always read a whole frame in time
+ * order. VALU gives the frame length to the waveform control, VALT the
+ * number of frames published.
+ *
+ * 17-Oct-2026: Double buffered frames with triggered capture replace the
+ *              rings unrolled into VALA..VALO every hsSamples calls
  *
  */
 long highSpeed (struct genSubRecord *pgsub) {
 
-    static long count = 0;
-    static long subcount = HS_RECORD_LENGTH-1;
+    static float lastXGuide = 0.0, lastYGuide = 0.0;
     Vtk *vtkx, *vtky;
+    float sample[HS_CHANNELS];
+    long length, pre, pos;
+    int channel, trigger;
+
+    length = hsSamples;
+    if (length < 1 || length > HS_RECORD_LENGTH)
+        length = HS_RECORD_LENGTH;
 
-    static float xTiltPosHS[HS_RECORD_LENGTH];
-    static float yTiltPosHS[HS_RECORD_LENGTH]; 
-    static float zPosHS[HS_RECORD_LENGTH];
-
-    static float xTiltNetGuideHS[HS_RECORD_LENGTH];
-    static float yTiltNetGuideHS[HS_RECORD_LENGTH];
-    static float zNetGuideHS[HS_RECORD_LENGTH];
-
-    static float vtkXCommand[HS_RECORD_LENGTH];
-    static float vtkXFrequency[HS_RECORD_LENGTH];
-    static float vtkXPhase[HS_RECORD_LENGTH];  /*New vtkX phase*/
-
-    static float vtkYCommand[HS_RECORD_LENGTH];
-    static float vtkYFrequency[HS_RECORD_LENGTH];
-    static float vtkYPhase[HS_RECORD_LENGTH]; /*New vtkY phase*/
-
-    static float xRawGuideHS[HS_RECORD_LENGTH];
-    static float yRawGuideHS[HS_RECORD_LENGTH];
-    static float zRawGuideHS[HS_RECORD_LENGTH]; /*Raw Guides*/
-
-    /* Set some flag for bad status and leave.*/
-    /*
-     *
-    *(long *) pgsub->valt = 0;
-    if (highSpeedData == NULL) {
-        *(long *) pgsub->valt = 1;
-       
-        return(ERROR);
-    }
-    */
-    
     /*Output Number of Samples to VALU*/
-    *(long *) pgsub->valu = hsSamples;
+    *(long *) pgsub->valu = length;
 
     vtkx = getVtkX();
     vtky = getVtkY();
 
-    xTiltPosHS[count]        = (float) scsBase->page1.xTilt;
-    yTiltPosHS[count]        = (float) scsBase->page1.yTilt; 
-    zPosHS[count]            = (float) scsBase->page1.zFocus;
+    sample[HS_XTILT_POS]        = (float) scsBase->page1.xTilt;
+    sample[HS_YTILT_POS]        = (float) scsBase->page1.yTilt; 
+    sample[HS_Z_POS]            = (float) scsBase->page1.zFocus;
 
     /*Guide values after PID, SW, and VTK*/
-    xTiltNetGuideHS[count]   = (float) xGuideTcs; 
-    yTiltNetGuideHS[count]   = (float) yGuideTcs;
-    zNetGuideHS[count]       = (float) zGuideTcs;
+    sample[HS_XTILT_NET_GUIDE]  = (float) xGuideTcs; 
+    sample[HS_YTILT_NET_GUIDE]  = (float) yGuideTcs;
+    sample[HS_Z_NET_GUIDE]      = (float) zGuideTcs;
 
-    vtkXCommand[count]       = (float) vtkx->command;
-    vtkXFrequency[count]     = (float) vtkx->frequency.currentValue;
-    vtkXPhase[count]         = (float) vtkx->phase;  /*New vtkX phase*/
+    sample[HS_VTKX_COMMAND]     = (float) vtkx->command;
+    sample[HS_VTKX_FREQUENCY]   = (float) vtkx->frequency.currentValue;
+    sample[HS_VTKX_PHASE]       = (float) vtkx->phase;  /*New vtkX phase*/
 
-    vtkYCommand[count]       = (float) vtky->command;
-    vtkYFrequency[count]     = (float) vtky->frequency.currentValue;
-    vtkYPhase[count]         = (float) vtky->phase; /*New vtkY phase*/
+    sample[HS_VTKY_COMMAND]     = (float) vtky->command;
+    sample[HS_VTKY_FREQUENCY]   = (float) vtky->frequency.currentValue;
+    sample[HS_VTKY_PHASE]       = (float) vtky->phase; /*New vtkY phase*/
 
     /*Guide values BEFORE any of the PID, SW, or VTK */
-    xRawGuideHS[count]       = (float) scsBase->page0.rawXGuide; 
-    yRawGuideHS[count]       = (float) scsBase->page0.rawYGuide; 
-    zRawGuideHS[count]       = (float) scsBase->page0.rawZGuide; 
-
-     /*Test HighSpeed Waveform*/
-     if (subcount == 0 ) {
-        int numOldSamples = HS_RECORD_LENGTH - (count+1);
-        int numNewSamples = HS_RECORD_LENGTH - numOldSamples;
-
-        /*Input pointers */
-        float *xTiltin = xTiltPosHS;
-        float *yTiltin = yTiltPosHS;
-        float *zPosin = zPosHS;
-        float *xTiltNetGuidein = xTiltNetGuideHS;
-        float *yTiltNetGuidein = yTiltNetGuideHS;
-        float *zNetGuidein = zNetGuideHS;
-        float *vtkXCommandin = vtkXCommand;
-        float *vtkXFrequencyin = vtkXFrequency;
-        float *vtkXPhasein = vtkXPhase;
-        float *vtkYCommandin = vtkYCommand;
-        float *vtkYFrequencyin = vtkYFrequency;
-        float *vtkYPhasein = vtkYPhase;
-        float *xRawGuidein = xRawGuideHS;
-        float *yRawGuidein = yRawGuideHS;
-        float *zRawGuidein = zRawGuideHS;
-
-        /*Output pointers */
-        float *xTiltPosOut         = (float *)pgsub->vala;
-        float *yTiltPosOut         = (float *)pgsub->valb;
-        float *zPosOut             = (float *)pgsub->valc;
-        float *xTiltNetGuideOut    = (float *)pgsub->vald;
-        float *yTiltNetGuideOut    = (float *)pgsub->vale;
-        float *zNetGuideOut        = (float *)pgsub->valf;
-        float *vtkXCommandOut      = (float *)pgsub->valg;
-        float *vtkXFrequencyOut    = (float *)pgsub->valh;
-        float *vtkXPhaseOut        = (float *)pgsub->vali;
-        float *vtkYCommandOut      = (float *)pgsub->valj;
-        float *vtkYFrequencyOut    = (float *)pgsub->valk;
-        float *vtkYPhaseOut        = (float *)pgsub->vall;
-        float *xRawGuideOut        = (float *)pgsub->valm;
-        float *yRawGuideOut        = (float *)pgsub->valn;
-        float *zRawGuideOut        = (float *)pgsub->valo;
-
-        memcpy (xTiltPosOut, (float *)(xTiltin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(xTiltPosOut+numOldSamples), (float *)(xTiltin),  numNewSamples*sizeof (float));
-
-        memcpy (yTiltPosOut, (float *)(yTiltin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(yTiltPosOut+numOldSamples), (float *)yTiltin,  numNewSamples*sizeof (float));
-
-        memcpy (zPosOut, (float *)(zPosin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(zPosOut+numOldSamples), (float *)zPosin,  numNewSamples*sizeof (float));
-
-        memcpy (xTiltNetGuideOut, (float *)(xTiltNetGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(xTiltNetGuideOut+numOldSamples), (float *)xTiltNetGuidein,  numNewSamples*sizeof (float));
-
-        memcpy (yTiltNetGuideOut, (float *)(yTiltNetGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(yTiltNetGuideOut+numOldSamples), (float *)yTiltNetGuidein,  numNewSamples*sizeof (float));
-
-        memcpy (zNetGuideOut, (float *)(zNetGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(zNetGuideOut+numOldSamples), (float *)zNetGuidein,  numNewSamples*sizeof (float));
-
-        memcpy (vtkXCommandOut, (float *)(vtkXCommandin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkXCommandOut+numOldSamples), (float *)vtkXCommandin,  numNewSamples*sizeof (float));
-
-        memcpy (vtkXFrequencyOut, (float *)(vtkXFrequencyin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkXFrequencyOut+numOldSamples), (float *)vtkXFrequencyin,  numNewSamples*sizeof (float));
-
-        memcpy (vtkXPhaseOut, (float *)(vtkXPhasein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkXPhaseOut+numOldSamples), (float *)vtkXPhasein,  numNewSamples*sizeof (float));
-
-        memcpy (vtkYCommandOut, (float *)(vtkYCommandin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkYCommandOut+numOldSamples), (float *)vtkYCommandin,  numNewSamples*sizeof (float));
-
-        memcpy (vtkYFrequencyOut, (float *)(vtkYFrequencyin+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkYFrequencyOut+numOldSamples), (float *)vtkYFrequencyin,  numNewSamples*sizeof (float));
-
-        memcpy (vtkYPhaseOut, (float *)(vtkYPhasein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(vtkYPhaseOut+numOldSamples), (float *)vtkYPhasein,  numNewSamples*sizeof (float));
-
-        memcpy (xRawGuideOut, (float *)(xRawGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(xRawGuideOut+numOldSamples), (float *)xRawGuidein,  numNewSamples*sizeof (float));
-
-        memcpy (yRawGuideOut, (float *)(yRawGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(yRawGuideOut+numOldSamples), (float *)yRawGuidein,  numNewSamples*sizeof (float));
-
-        memcpy (zRawGuideOut, (float *)(zRawGuidein+count+1),  numOldSamples*sizeof (float));
-        memcpy ((float *)(zRawGuideOut+numOldSamples), (float *)zRawGuidein,  numNewSamples*sizeof (float));
-
-        /*
-         *
-         * memcpy ((double *)pgsub->vall, vtkYPhase,  numsamples*sizeof (double));
-         *
-         */
-        subcount = hsSamples-1;
-
-     } else {
-        
-         subcount--;
-     }
-     if (count == HS_RECORD_LENGTH-1)
-         count=0;
-     else
-         count++;
+    sample[HS_XRAW_GUIDE]       = (float) scsBase->page0.rawXGuide; 
+    sample[HS_YRAW_GUIDE]       = (float) scsBase->page0.rawYGuide; 
+    sample[HS_ZRAW_GUIDE]       = (float) scsBase->page0.rawZGuide; 
+
+    if (hsTriggerMode == HS_TRIGGER_OFF)
+    {
+        /* free running, frames follow each other */
+        if (hsCount >= length)
+            hsCount = 0;
+
+        for (channel = 0; channel < HS_CHANNELS; channel++)
+            hsFrame[hsFill][channel][hsCount] = sample[channel];
+
+        if (++hsCount >= length)
+        {
+            hsPublish (pgsub, length);
+            hsCount = 0;
+            hsHead = 0;
+        }
+    }
+    else
+    {
+        /* triggered, keep the last samples in a ring until triggered */
+        if (hsHead >= length)
+            hsHead = 0;
+
+        pos = hsHead;
+        for (channel = 0; channel < HS_CHANNELS; channel++)
+            hsFrame[hsFill][channel][pos] = sample[channel];
+
+        hsHead = (hsHead + 1) % length;
+        if (hsCount < length)
+            hsCount++;
+
+        pre = hsPreTrigger;
+        if (pre < 0 || pre >= length)
+            pre = length - 1;
+
+        if (hsPost < 0)
+        {
+            if (hsTriggerMode == HS_TRIGGER_VTK)
+                trigger = (fabs (vtkx->frequency.error) > hsTriggerLevel ||
+                           fabs (vtky->frequency.error) > hsTriggerLevel);
+            else
+                trigger = (fabs (sample[HS_XTILT_NET_GUIDE] - lastXGuide) >
+                           hsTriggerLevel ||
+                           fabs (sample[HS_YTILT_NET_GUIDE] - lastYGuide) >
+                           hsTriggerLevel);
+
+            /* the trigger sample is sample pre of the frame */
+            if (trigger && hsCount > pre)
+                hsPost = length - pre - 1;
+        }
+        else if (hsPost > 0)
+        {
+            hsPost--;
+        }
+
+        if (hsPost == 0)
+        {
+            for (channel = 0; channel < HS_CHANNELS; channel++)
+                hsRotate (hsFrame[hsFill][channel], length, hsHead);
+
+            hsPublish (pgsub, length);
+            hsCount = 0;
+            hsHead = 0;
+            hsPost = -1;
+        }
+    }
 
-     return (OK);
+    lastXGuide = sample[HS_XTILT_NET_GUIDE];
+    lastYGuide = sample[HS_YTILT_NET_GUIDE];
+
+    return (OK);
 }
 #endif
 
@@ -2589,22 +3485,26 @@ long lookupGuide (struct genSubRecord * pgsub)
  * HISTORY (optional):
  * 28-Oct-1998  Original version          Sean Prior
  * 22-Jan-1999  Imported from Gemini A&G, add array index check and return 0.0 for error (srp)
+ * 17-Oct-2026  Run the filter as a biquad section through biquadFilter
  *-
  */
 
 static double dfilter(double newSample, int Id)
 {
      int i = 0;
-     double sum = 0.;
-     static double sample[6][MAX_FILTER_CHANNELS];
+     static int loaded = FALSE;
+     static BIQUAD section[MAX_FILTER_CHANNELS];
 
-     static double coeffs[] = {
-          1.0,
-          1.77863177782458,
-          -0.80080264666571,
+     /* b0, b1, b2, a1, a2 of the two pole lowpass */
+
+     static const BIQUAD lowpass = {
           0.00554271721028,
           0.01108543442056,
-          0.00554271721028
+          0.00554271721028,
+          -1.77863177782458,
+          0.80080264666571,
+          0.0,
+          0.0
      };
 
      /* check filter Id in range */
@@ -2615,22 +3515,13 @@ static double dfilter(double newSample, int Id)
           return(0.0);
      }
 
-     /* put new sample into the array */
-
-     sample[3][Id] = newSample;
-
-     /* multiply samples by coefficients and accumulate */
-
-     for(i=1; i < 6; i++)
-          sum += sample[i][Id]*coeffs[i];
-
-     /* ripple samples ready for next call */
-
-     sample[5][Id] = sample[4][Id];
-     sample[4][Id] = sample[3][Id];
-     sample[2][Id] = sample[1][Id];
-     sample[1][Id] = sum;
+     if (!loaded)
+     {
+          for (i = 0; i < MAX_FILTER_CHANNELS; i++)
+               section[i] = lowpass;
+          loaded = TRUE;
+     }
 
-     return(sum);
+     return(biquadFilter(newSample, &section[Id]));
 }
 
@@ -27,6 +27,10 @@
  * -------
  * 17-Nov-1999: Created new header files.
  * 16-Dec-1999: Added global variables
+ * 17-Oct-2026: Added fused three axis filter and cascade (SOS) form
+ * 17-Oct-2026: Added NOTCH filter type and filter design selection
+ * 17-Oct-2026: fusedFilter replaced by guideFilter/guideFilterSwap, added
+ *              filterInit and filterRetuneRequest
  *
  */
 /* INDENT ON */
@@ -45,6 +49,7 @@
 #endif
 
 #include "utilities.h"
+#include "biquad.h"     /* For SOS */
 
 #define XTILT   0       /* axis identifiers */
 #define YTILT   1
@@ -95,7 +100,18 @@ enum
         LOWPASS,
         HIGHPASS,
         BANDPASS,
-        BANDSTOP
+        BANDSTOP,
+        NOTCH
+};
+
+/* How createFilter obtains coefficients for LOWPASS .. BANDSTOP. NOTCH
+ * filters are always designed. */
+
+enum
+{
+        DESIGN_TABLE = 0,       /* nearest entry in the coefficient files */
+        DESIGN_BUTTERWORTH,     /* designed for the exact frequencies     */
+        DESIGN_CHEBYSHEV
 };
 
 /* Define structures to hold filter configurations */   
@@ -125,8 +141,34 @@ typedef struct
         double  sampleFreq;     /* sample frequency                     */
         double  freq1;          /* low cutoff                           */
         double  freq2;          /* high cutoff                          */
+        SOS     sos;            /* cascade form of numerator/denominator,
+                                   nsections is 0 if not available      */
 } MATLAB;
 
+/* Fused three axis filter. createFilter configures XTILT, YTILT and ZFOCUS
+ * of a source with the same coefficients, so one set of coefficients drives
+ * all three axes. The histories are interleaved x/y/z (padded to IIR_LANES)
+ * and held in circular buffers so that advancing them is an index bump and
+ * the per-tap update is a short vector operation. */
+
+#define IIR_LANES       4       /* x, y, z and one pad lane             */
+#define IIR_HISTORY     16      /* circular history, power of two > 11  */
+#define IIR_HISTORY_MASK (IIR_HISTORY - 1)
+
+typedef struct
+{
+        long    nb;             /* number of numerator coefficients     */
+        long    na;             /* number of denominator coefficients   */
+        double  numerator[11];  /* B coefficients (b0, b1, b(nb-1)      */
+        double  denominator[11];/* A coefficients (1, a1, a2, a(na-1)   */
+        double  inHistory[IIR_HISTORY][IIR_LANES];  /* input history    */
+        double  outHistory[IIR_HISTORY][IIR_LANES]; /* output history   */
+        int     head;           /* slot holding the newest sample       */
+        SOS     sos;            /* cascade coefficients, used if loaded */
+        double  sosState[SOS_MAX_SECTIONS][2][IIR_LANES]; /* s1, s2     */
+        int     type;           /* filter type, RAW and NOTUSED bypass  */
+} FUSED_IIR;
+
 /* Get the updateInterval for pwfs2 */
 typedef struct  
 {
@@ -167,6 +209,20 @@ int createFilter(int source, int filterType,
                  double sampleRate, double freq1, double freq2, 
                  double weightA, double weightB, double weightC);
 
+int loadFilterBank(void);
+
+int retuneFilters(double sampleRate);
+
+int filterInit(void);
+
+void filterRetuneRequest(long sampleRate);
+
+FUSED_IIR *guideFilter(int source);
+
+void guideFilterSwap(void);
+
+int fetchFilter(MATLAB *filterAddr, int type, double freq1, double freq2);
+
 /* Global variables */
 
 extern anUpdateInterval updateInterval;
@@ -182,6 +238,9 @@ extern int guideOnC;
 extern double weight[MAX_SOURCES][MAX_BEAMS];
 extern int guideMaster[MAX_SOURCES][MAX_BEAMS];
 extern MATLAB filter[MAX_SOURCES][MAX_AXES];
+extern long filterDesign;
+extern long filterOrder;
+extern double filterRipple;
 
 #endif
 
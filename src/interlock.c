@@ -33,6 +33,8 @@
  * 
  * 19-Jul-1997: Original (srp)
  * 07-May-1999: Added RCS id
+ * 17-Oct-2026: Flush queued M2 commands with commandFlush
+ * 17-Oct-2026: lockMonitor reads the mirror position with readStatus
  *
  */
 /* INDENT ON */
@@ -41,7 +43,8 @@
 #include <drvXy240.h>
 
 #include "archive.h"        /* For refMemFree */
-#include "control.h"        /* For scsPtr, interlockFlag, commandQId */
+#include "control.h"        /* For scsPtr, interlockFlag */
+#include "command.h"        /* For commandFlush */
 #include "interlock.h"
 #include "utilities.h"      /* For reportHealth */
 #include "eventBus.h"       /* for XYCARDNUM */
@@ -115,8 +118,8 @@ long    initInterlock (struct subRecord * psub)
 
 long    lockMonitor (struct subRecord * psub)
 {
-    long    received;
     static int Qcleared = 0;
+    statusBlock status;
     long    interlockStatus = OFF;
     long    interlockOverride = OFF;
 
@@ -152,13 +155,12 @@ long    lockMonitor (struct subRecord * psub)
         interlockFlag = ON;
 
         /* record current mirror position */
-        epicsMutexLock(refMemFree);
-        lockPosition.xTilt = scsPtr->page1.xTilt;
-        lockPosition.yTilt = scsPtr->page1.yTilt;
-        lockPosition.zFocus = scsPtr->page1.zFocus;
-        lockPosition.xPos = scsPtr->page1.xPosition;
-        lockPosition.yPos = scsPtr->page1.yPosition;
-        epicsMutexUnlock(refMemFree);
+        readStatus(&status);
+        lockPosition.xTilt = status.xTilt;
+        lockPosition.yTilt = status.yTilt;
+        lockPosition.zFocus = status.zFocus;
+        lockPosition.xPos = status.xPosition;
+        lockPosition.yPos = status.yPosition;
 
 
         /* clear command message queues */
@@ -167,8 +169,7 @@ long    lockMonitor (struct subRecord * psub)
             errlogMessage("interlock detected - begin clearing message queue");
 
             /* read out and discard messages until none left */
-            while ( epicsMessageQueueTryReceive(commandQId, (char *) &received, sizeof (long)) != MSG_Q_EMPTY)
-                ;
+            commandFlush();
 
             Qcleared = 1;
             errlogMessage("message queue cleared\n");
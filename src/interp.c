@@ -9,19 +9,24 @@
  * 
  * PURPOSE
  * -------
- * Functions to curve fit a quadratic to the 20Hz TCS follow demands
+ * Functions to fit a smooth trajectory to the 20Hz TCS follow demands so
+ * that slowTransmit can evaluate it at the guide rate
  * 
  * FUNCTION NAME(S)
  * ----------------
- * testInterpolator - Provide demand values to exercise the interpolator
- * getInterpolation - perform quadratic calculation to get estimate
- * tcsInterpolate   - curve fit quadratic to TCS demand data
+ * interpInit       - create the lock serialising tcsInterpolate
+ * getInterpolationAll - evaluate the trajectory of all axes
+ * getInterpolation - evaluate the trajectory of one axis
+ * tcsInterpolate   - add a TCS demand to the trajectory
+ * interpShow       - report the trajectory and the rejected demands
  * 
  * DEPENDENCIES
  * ------------
  *
  * LIMITATIONS
  * -----------
+ * Beyond the newest demand the trajectory is extrapolated along its end
+ * tangent for at most interpExtrapolate seconds, then held.
  * 
  * AUTHOR
  * ------
@@ -33,6 +38,12 @@
  * 17-Oct-1997: Original (srp)
  * 24-Oct-1997: Expand number of axes to 7 to include tilts for each beam
  * 07-May-1999: Added RCS id
+ * 17-Oct-2026: Replace the three point quadratic, whose first two
+ *              coefficients were forced to zero, by cubic Hermite segments
+ *              through a ring of recent demands. Reject late and out of
+ *              order demands, restart after a gap in the demand stream
+ * 17-Oct-2026: Publish each fit as a trajectory read without a lock,
+ *              getInterpolationAll evaluates all axes from one of them
  *
  */
 /* INDENT ON */
@@ -43,46 +54,266 @@
 #include "utilities.h"    /* For debugLevel */
 
 #include <stdio.h>
+#include <string.h>       /* For memcpy */
+#include <timeLib.h>      /* For timeNow */
+#include <epicsMutex.h>
+#include <epicsAtomic.h>  /* For epicsAtomicGetIntT */
 
 #define NUM_INTERP_AXES    7    /* number of channels that need interpolating */
-#define NUM_INTERP_SAMPLES 3    /* number of time samples needed for 
-                                   interpolation      */
-#define NUM_INTERP_COEFFS  3    /* number of time samples needed for 
-                                   interpolation      */
+#define NUM_INTERP_SAMPLES 8    /* demands kept in the ring, 0.4 s at 20Hz   */
+#define NUM_INTERP_COEFFS  4    /* cubic coefficients a, b, c, d per segment  */
 
 /* Define function prototypes */
 
 int errorLog(char *errorString, int debugLevel, int fileLog);
 
+/* one TCS demand, the values in axis order AX .. Z */
+
+typedef struct
+{
+    double  time;                       /* timeApply of the demand */
+    double  value[NUM_INTERP_AXES];
+} interpSample;
+
+/* A published trajectory. Segment i runs from start[i] to start[i + 1], or
+ * to newestTime for the last, and is evaluated in seconds from its start.
+ * The coefficients are stored axis innermost so that all axes are
+ * evaluated together. Past newestTime the value follows the end tangent. */
+
+typedef struct
+{
+    int     sequence;                   /* odd while being written */
+    int     demands;                    /* demands in the fit, 0 if none */
+    int     segmentCount;
+    double  start[NUM_INTERP_SAMPLES - 1];
+    double  coeff[NUM_INTERP_SAMPLES - 1][NUM_INTERP_COEFFS][NUM_INTERP_AXES];
+    double  newestTime;
+    double  newestValue[NUM_INTERP_AXES];
+    double  newestSlope[NUM_INTERP_AXES];
+} interpTrajectory;
+
+#define INTERP_RING_SIZE   3    /* published trajectories, see interpRead */
+
 /* Define globals */
 
-double  t[NUM_INTERP_SAMPLES];          /* t0, t1, t2   zero is oldest */
+double  interpLateLimit = 0.1;      /* reject demands sent longer ago (s)   */
+double  interpMaxGap = 0.5;         /* restart after a longer gap (s)       */
+double  interpExtrapolate = 0.05;   /* extrapolate this far, then hold (s)  */
+
+long    interpAccepted = 0;
+long    interpLate = 0;
+long    interpOutOfOrder = 0;
+long    interpRestarts = 0;
+
+/* serialises tcsInterpolate and interpShow, readers of the trajectory
+ * take no lock */
+static epicsMutexId interpFree = NULL;
+
+/* ring of demands, oldest first once unrolled, owned by tcsInterpolate */
+static interpSample sample[NUM_INTERP_SAMPLES];
+static int sampleHead = 0;              /* next slot to write */
+static int sampleCount = 0;
+static double newestTime = 0.0;
+
+/* trajectories published by tcsInterpolate */
+static interpTrajectory trajectory[INTERP_RING_SIZE];
+static int trajectoryLatest = 0;
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * interpInit
+ * 
+ * Purpose:
+ * Create the lock serialising tcsInterpolate and interpShow
+ * 
+ * Invocation:
+ * status = interpInit();
+ * 
+ * Return value:
+ *      < status    int OK or ERROR
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
 
-/* sample values for each axis x0, x1, x2 zero is oldest */
-double  sample[NUM_INTERP_AXES][NUM_INTERP_SAMPLES] =  
+int     interpInit (void)
 {
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0}
-};
-
-double  interpCoeff[NUM_INTERP_AXES][NUM_INTERP_COEFFS] =   /* a, b, c coefficients for each axis */
+    if (interpFree == NULL && (interpFree = epicsMutexCreate ()) == NULL)
+    {
+        errorLog ("interpInit - error creating interpFree", 1, ON);
+        return (ERROR);
+    }
+
+    return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * interpRead
+ * 
+ * Purpose:
+ * Copy from the latest published trajectory the cubic that covers the
+ * target time, for all axes, without a lock. The copy is retried if
+ * tcsInterpolate rewrote the trajectory while it was being read, which
+ * needs INTERP_RING_SIZE demands to arrive during one copy.
+ * 
+ * Invocation:
+ * demands = interpRead(coeff, &dt, targetTime);
+ * 
+ * Parameters in:
+ *      > targetTime    double  time for which estimate required
+ * 
+ * Parameters out:
+ *      < coeff     double[][] a, b, c, d for each axis
+ *      < dt        double*    time from the start of the cubic
+ * 
+ * Return value:
+ *      < demands   int number of demands in the trajectory
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static int interpRead (double coeff[NUM_INTERP_COEFFS][NUM_INTERP_AXES],
+    double *dt, double targetTime)
 {
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0},
-    {0, 0, 0}
-};
-
-double  denominator;
-double  timeDatum;
+    const interpTrajectory *tr;
+    int     sequence, demands, axis, i;
+
+    do
+    {
+        tr = &trajectory[epicsAtomicGetIntT (&trajectoryLatest)];
+        sequence = epicsAtomicGetIntT (&tr->sequence);
+
+        epicsAtomicReadMemoryBarrier ();
+
+        demands = tr->demands;
+        i = tr->segmentCount - 1;
+
+        if (i < 0 || targetTime >= tr->newestTime)
+        {
+            /* after the newest demand, follow the end tangent then hold */
+
+            *dt = targetTime - tr->newestTime;
+            if (*dt > interpExtrapolate)
+                *dt = interpExtrapolate;
+            if (*dt < 0.0)
+                *dt = 0.0;
+
+            for (axis = 0; axis < NUM_INTERP_AXES; axis++)
+            {
+                coeff[0][axis] = 0.0;
+                coeff[1][axis] = 0.0;
+                coeff[2][axis] = tr->newestSlope[axis];
+                coeff[3][axis] = tr->newestValue[axis];
+            }
+        }
+        else
+        {
+            /* usually the newest segment, search back from there */
+
+            for (; i > 0 && targetTime < tr->start[i]; i--)
+                ;
+
+            *dt = targetTime - tr->start[i];
+            if (*dt < 0.0)
+                *dt = 0.0;
+
+            memcpy (coeff, tr->coeff[i], sizeof (tr->coeff[i]));
+        }
+
+        epicsAtomicReadMemoryBarrier ();
+    } while ((sequence & 1) || epicsAtomicGetIntT (&tr->sequence) != sequence);
+
+    return (demands);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * getInterpolationAll
+ * 
+ * Purpose:
+ * Estimate the demands of all axes for the supplied time from one
+ * trajectory fitted by tcsInterpolate
+ * 
+ * Invocation:
+ * status = getInterpolationAll(&demand, targetTime);
+ * 
+ * Parameters in:
+ *      > targetTime    double  time for which estimate required
+ * 
+ * Parameters out:
+ *      < demand    Demands*    xTiltA .. yTiltC and zFocus estimated,
+ *                              timeApply set to targetTime, the rest
+ *                              left alone
+ * 
+ * Return value:
+ *      < status    int OK, ERROR if no demand has been received
+ * 
+ * Globals: 
+ *  External variables:
+ *  interpExtrapolate
+ * 
+ * Requirements:
+ * Before the oldest demand the oldest value is held, after the newest the
+ * end tangent is followed for interpExtrapolate seconds and then held.
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+int     getInterpolationAll (Demands *demand, double targetTime)
+{
+    double  coeff[NUM_INTERP_COEFFS][NUM_INTERP_AXES];
+    double  value[NUM_INTERP_AXES];
+    double  dt;
+    int     demands, axis;
+
+    demands = interpRead (coeff, &dt, targetTime);
+
+    for (axis = 0; axis < NUM_INTERP_AXES; axis++)
+    {
+        value[axis] = ((coeff[0][axis] * dt + coeff[1][axis]) * dt
+            + coeff[2][axis]) * dt + coeff[3][axis];
+    }
+
+    demand->timeApply = targetTime;
+    demand->xTiltA = value[AX];
+    demand->yTiltA = value[AY];
+    demand->xTiltB = value[BX];
+    demand->yTiltB = value[BY];
+    demand->xTiltC = value[CX];
+    demand->yTiltC = value[CY];
+    demand->zFocus = value[Z];
+
+    if (debugLevel == DEBUG_RESERVED2)
+    {
+        printf ("getInterpolationAll targettime=%f, demands=%d, "
+            "A=%f %f B=%f %f C=%f %f Z=%f\n", targetTime, demands,
+            value[AX], value[AY], value[BX], value[BY], value[CX],
+            value[CY], value[Z]);
+    }
+
+    return ((demands > 0) ? OK : ERROR);
+}
 
 /* ===================================================================== */
 /* INDENT OFF */
@@ -91,8 +322,9 @@ double  timeDatum;
  * getInterpolation
  * 
  * Purpose:
- * current value of variable is estimated for the supplied time using
- * the quadratic coefficients
+ * current value of variable is estimated for the supplied time from the
+ * trajectory fitted by tcsInterpolate. Use getInterpolationAll when more
+ * than one axis is needed.
  * 
  * Invocation:
  * value = getInterpolation(axis, targetTime);
@@ -121,6 +353,8 @@ double  timeDatum;
  * 
  * History:
  * 15-Oct-1997: Original(srp)
+ * 17-Oct-2026: Evaluate the cubic segment covering targetTime
+ * 17-Oct-2026: Read the published trajectory with interpRead
  * 
  */
 
@@ -129,13 +363,8 @@ double  timeDatum;
 
 double  getInterpolation (int selectAxis, double targetTime)
 {
-    if (debugLevel == DEBUG_RESERVED2)
-    {
-        printf
-        ("getInterpolation with axis=%1d, targettime=%f, coeffs=%f %f %f \n",
-        selectAxis, targetTime, interpCoeff[selectAxis][0], 
-        interpCoeff[selectAxis][1], interpCoeff[selectAxis][2]);
-    }
+    double  coeff[NUM_INTERP_COEFFS][NUM_INTERP_AXES];
+    double  dt;
 
     if(selectAxis < 0 || selectAxis > (NUM_INTERP_AXES - 1))
     {
@@ -143,10 +372,120 @@ double  getInterpolation (int selectAxis, double targetTime)
         return(ERROR);
     }
 
-    targetTime -= timeDatum;
-    return ((interpCoeff[selectAxis][0] * targetTime
-         + interpCoeff[selectAxis][1]) * targetTime
-        + interpCoeff[selectAxis][2]);
+    interpRead (coeff, &dt, targetTime);
+
+    return (((coeff[0][selectAxis] * dt + coeff[1][selectAxis]) * dt
+        + coeff[2][selectAxis]) * dt + coeff[3][selectAxis]);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * interpFit
+ * 
+ * Purpose:
+ * Compute the cubic Hermite segments through the demands in the ring.
+ * The tangent at an interior demand is the three point derivative for
+ * uneven spacing, zero where the neighbouring slopes change sign so that
+ * the trajectory does not overshoot a turning point; the end tangents are
+ * the slopes of the end segments. Called by tcsInterpolate with
+ * interpFree taken.
+ * 
+ * Invocation:
+ * interpFit(tr);
+ * 
+ * Parameters out:
+ *      < tr        interpTrajectory*   trajectory being published
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Write the fit into a trajectory to be published
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+static void interpFit (interpTrajectory *tr)
+{
+    const interpSample *p[NUM_INTERP_SAMPLES];
+    double  slope[NUM_INTERP_SAMPLES];      /* slope of segment ending at i */
+    double  tangent[NUM_INTERP_SAMPLES];
+    double  h, h0, h1, delta;
+    int     axis, i, n;
+
+    n = sampleCount;
+    for (i = 0; i < n; i++)
+    {
+        p[i] = &sample[(sampleHead - n + i + NUM_INTERP_SAMPLES) 
+            % NUM_INTERP_SAMPLES];
+    }
+
+    tr->demands = n;
+    tr->segmentCount = n - 1;
+    tr->newestTime = p[n - 1]->time;
+
+    for (i = 0; i < n - 1; i++)
+    {
+        tr->start[i] = p[i]->time;
+    }
+
+    for (axis = 0; axis < NUM_INTERP_AXES; axis++)
+    {
+        tr->newestValue[axis] = p[n - 1]->value[axis];
+
+        if (n < 2)
+        {
+            tr->newestSlope[axis] = 0.0;
+            continue;
+        }
+
+        for (i = 1; i < n; i++)
+        {
+            slope[i] = (p[i]->value[axis] - p[i - 1]->value[axis]) /
+                (p[i]->time - p[i - 1]->time);
+        }
+
+        tangent[0] = slope[1];
+        tangent[n - 1] = slope[n - 1];
+
+        for (i = 1; i < n - 1; i++)
+        {
+            if (slope[i] * slope[i + 1] <= 0.0)
+            {
+                tangent[i] = 0.0;
+            }
+            else
+            {
+                h0 = p[i]->time - p[i - 1]->time;
+                h1 = p[i + 1]->time - p[i]->time;
+                tangent[i] = (h1 * slope[i] + h0 * slope[i + 1]) / (h0 + h1);
+            }
+        }
+
+        for (i = 0; i < n - 1; i++)
+        {
+            h = p[i + 1]->time - p[i]->time;
+            delta = p[i + 1]->value[axis] - p[i]->value[axis];
+
+            /* coefficient a */
+            tr->coeff[i][0][axis] = (tangent[i] + tangent[i + 1]
+                - 2.0 * delta / h) / (h * h);
+
+            /* coefficient b */
+            tr->coeff[i][1][axis] = (3.0 * delta / h
+                - 2.0 * tangent[i] - tangent[i + 1]) / h;
+
+            /* coefficient c */
+            tr->coeff[i][2][axis] = tangent[i];
+
+            /* coefficient d */
+            tr->coeff[i][3][axis] = p[i]->value[axis];
+        }
+
+        tr->newestSlope[axis] = tangent[n - 1];
+    }
 }
 
 /* ===================================================================== */
@@ -156,7 +495,10 @@ double  getInterpolation (int selectAxis, double targetTime)
  * tcsInterpolate
  * 
  * Purpose:
- * Curve fit a quadratic to the received 20Hz TCS follow demands
+ * Add a received 20Hz TCS follow demand to the ring, refit the trajectory
+ * and publish it. A demand sent more than interpLateLimit ago, or not
+ * applied after the newest demand already held, is rejected. After a gap
+ * of more than interpMaxGap the ring restarts from the new demand.
  * 
  * Invocation:
  * tcsInterpolate(newTcsDemands)
@@ -165,17 +507,17 @@ double  getInterpolation (int selectAxis, double targetTime)
  *      > newTcsDemands Demands structure of timestamped demands
  * 
  * Parameters out:
- *      < coefficients a, b and c for the quadratic
+ *      < trajectory published for getInterpolationAll
  * 
  * Return value:
- * None
+ *      < status    int OK if the demand was accepted, else ERROR
  * 
  * Globals: 
  *  External functions:
- *  None
+ *  timeNow
  * 
  *  External variables:
- *  None
+ *  interpLateLimit, interpMaxGap
  * 
  * Requirements:
  * 
@@ -185,99 +527,141 @@ double  getInterpolation (int selectAxis, double targetTime)
  * History:
  * 15-Oct-1997: Original(srp)
  * 24-Oct-1997: Expand to allow for 7 axes for all beam positions
+ * 17-Oct-2026: Ring of demands and cubic Hermite segments, reject late
+ *              and out of order demands
+ * 17-Oct-2026: Publish the fit in the slot after the latest trajectory
+ * 17-Oct-2026: Return whether the demand was accepted
  * 
  */
 
 /* INDENT ON */
 /* ===================================================================== */
 
-void    tcsInterpolate (Demands newTcsDemand)
+int     tcsInterpolate (Demands newTcsDemand)
 {
     /* this routine called each time the TCS demand updates (20Hz)       */
-    /* calculates the interpolation coefficients for a quadratic fit     */
 
-    char    message[81];
-    int axis;
+    interpSample *new;
+    interpTrajectory *tr;
+    double  now;
+    int     next;
 
-    /* first remove an offset from the time value in case of numerical   */
-    /* problems dealing with large numbers. The offfset is taken as the      */
-    /* oldest of the three times                         */
+    if (timeNow (&now) == OK && now - newTcsDemand.timeSent > interpLateLimit)
+    {
+        interpLate++;
+        if (debugLevel > DEBUG_MED)
+        {
+            errlogPrintf ("tcsInterpolate - late demand, sent %f now %f\n",
+                newTcsDemand.timeSent, now);
+        }
+        return (ERROR);
+    }
 
-    /* the time values are common to all axes */
+    epicsMutexLock (interpFree);
 
-    timeDatum = t[0];
-    t[1] = t[1] - timeDatum;
-    t[2] = newTcsDemand.timeApply - timeDatum;
+    if (sampleCount > 0 && newTcsDemand.timeApply <= newestTime)
+    {
+        epicsMutexUnlock (interpFree);
+        interpOutOfOrder++;
+        errorLog ("tcsInterpolate - demand out of order", 2, ON);
+        return (ERROR);
+    }
 
-    denominator = t[1] * t[2] * (t[1] - t[2]);
+    if (sampleCount > 0 && newTcsDemand.timeApply - newestTime > interpMaxGap)
+    {
+        sampleCount = 0;
+        interpRestarts++;
+    }
 
-/* As a test put the new data into all three samples. This will effectively
-*  bypass the interpolation.
-*/
-    sample[AX][2] = newTcsDemand.xTiltA;
-    sample[AY][2] = newTcsDemand.yTiltA;
-    sample[BX][2] = newTcsDemand.xTiltB;
-    sample[BY][2] = newTcsDemand.yTiltB;
-    sample[CX][2] = newTcsDemand.xTiltC;
-    sample[CY][2] = newTcsDemand.yTiltC;
-    sample[Z][2] = newTcsDemand.zFocus;
+    new = &sample[sampleHead];
+    new->time = newTcsDemand.timeApply;
+    new->value[AX] = newTcsDemand.xTiltA;
+    new->value[AY] = newTcsDemand.yTiltA;
+    new->value[BX] = newTcsDemand.xTiltB;
+    new->value[BY] = newTcsDemand.yTiltB;
+    new->value[CX] = newTcsDemand.xTiltC;
+    new->value[CY] = newTcsDemand.yTiltC;
+    new->value[Z] = newTcsDemand.zFocus;
+    newestTime = new->time;
 
-    if (denominator != 0)
-    {
-        for (axis = 0; axis < NUM_INTERP_AXES; axis++)
-        {
-            /* coefficient a */
-            interpCoeff[axis][0] = (sample[axis][0] * (t[1] - t[2])
-               + sample[axis][1] * t[2] - sample[axis][2] * t[1]) / denominator;
+    sampleHead = (sampleHead + 1) % NUM_INTERP_SAMPLES;
+    if (sampleCount < NUM_INTERP_SAMPLES)
+        sampleCount++;
 
-            /* coefficient b */
-            interpCoeff[axis][1] = (sample[axis][0] * (t[2] * t[2] - t[1] * t[1])
-               - sample[axis][1] * t[2] * t[2] + sample[axis][2] * t[1] * t[1])
-               / denominator;
+    /* fit into the slot after the latest, readers retry if they see it
+     * being written */
 
-            /* coefficient c */
-            interpCoeff[axis][2] = sample[axis][0];
+    next = (trajectoryLatest + 1) % INTERP_RING_SIZE;
+    tr = &trajectory[next];
 
-            /* this debug level above that which can be set on the eng screens, set from console if required */
+    epicsAtomicIncrIntT (&tr->sequence);            /* odd, being written */
+    epicsAtomicWriteMemoryBarrier ();
 
-            interpCoeff[axis][0] = 0.0;
-            interpCoeff[axis][1] = 0.0;
-            if ((debugLevel > DEBUG_MED) & (debugLevel <= DEBUG_MED))
-            {
-                sprintf(message, "axis = %d\n", axis);
-                errlogPrintf("%s", message);
+    interpFit (tr);
 
-                sprintf(message, "coefficients = %4.2f, b= %4.2f, c=%4.2f\n",
-                    interpCoeff[axis][0], interpCoeff[axis][1], interpCoeff[axis][2]);
-                errlogPrintf("%s", message);
+    epicsAtomicWriteMemoryBarrier ();
+    epicsAtomicIncrIntT (&tr->sequence);            /* even, complete */
 
-                sprintf(message, "position     = %4.2f %4.2f %4.2f\n",
-                    sample[axis][0], sample[axis][1], sample[axis][2]); 
-                errlogPrintf("%s", message);
+    epicsAtomicWriteMemoryBarrier ();
+    epicsAtomicSetIntT (&trajectoryLatest, next);
 
-                sprintf(message, "times        = %4.2f %4.2f %4.2f\n", 
-                   t[0], t[1], t[2]);
-                errlogPrintf("%s", message);
+    interpAccepted++;
 
-            }
+    epicsMutexUnlock (interpFree);
 
-            /* ripple down old values */
+    return (OK);
+}
 
-            sample[axis][0] = sample[axis][1];
-            sample[axis][1] = sample[axis][2];
-        }
-    }
-    else
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * interpShow
+ * 
+ * Purpose:
+ * Report the demands in the ring and the counts of rejected demands,
+ * callable from the IOC shell
+ * 
+ * Invocation:
+ * status = interpShow();
+ * 
+ * Return value:
+ *      < status    int OK
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+int     interpShow (void)
+{
+    interpSample ring[NUM_INTERP_SAMPLES];
+    int     i, n;
+
+    epicsMutexLock (interpFree);
+    n = sampleCount;
+    for (i = 0; i < n; i++)
     {
-        sprintf(message, "interp denom zero t[0] = %4.2f, t[1] = %4.2f, t[2] = %4.2f\n", t[1], t[1], t[2]);
-        errorLog("tcsInterpolate - denominator zero", 2, ON);
+        ring[i] = sample[(sampleHead - n + i + NUM_INTERP_SAMPLES) 
+            % NUM_INTERP_SAMPLES];
     }
+    epicsMutexUnlock (interpFree);
 
-    /* ripple down old time but restore to real time rather than offset
-     * time */
-
-    t[0] = t[1] + timeDatum;
-    t[1] = t[2] + timeDatum;
-}
+    printf ("accepted %ld, late %ld, out of order %ld, restarts %ld\n",
+        interpAccepted, interpLate, interpOutOfOrder, interpRestarts);
+    printf ("late limit %.3f s, max gap %.3f s, extrapolate %.3f s\n",
+        interpLateLimit, interpMaxGap, interpExtrapolate);
 
+    for (i = 0; i < n; i++)
+    {
+        printf ("%17.6f  A %9.4f %9.4f  B %9.4f %9.4f  C %9.4f %9.4f  "
+            "Z %9.4f\n", ring[i].time, ring[i].value[AX], ring[i].value[AY],
+            ring[i].value[BX], ring[i].value[BY], ring[i].value[CX],
+            ring[i].value[CY], ring[i].value[Z]);
+    }
 
+    return (OK);
+}
@@ -26,6 +26,9 @@
  * HISTORY
  * -------
  * 17-Nov-1999: Created new header files. KG
+ * 17-Oct-2026: Added interpInit, interpShow and the trajectory limits
+ * 17-Oct-2026: Added getInterpolationAll
+ * 17-Oct-2026: tcsInterpolate returns whether the demand was accepted
  *
  */
 /* INDENT ON */
@@ -46,8 +49,18 @@ enum                            /* axis identifiers for each beam */
         Z
 };
 
+int interpInit (void);
+
+int getInterpolationAll (Demands *, double);
+
 double getInterpolation (int, double);
 
-void tcsInterpolate (Demands);
+int tcsInterpolate (Demands);
+
+int interpShow (void);
+
+extern double interpLateLimit;
+extern double interpMaxGap;
+extern double interpExtrapolate;
 
 #endif
@@ -0,0 +1,398 @@
+/* ===================================================================== */
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * latency.c
+ *
+ * PURPOSE
+ * -------
+ * Latency recorder for the processGuides loop. processGuides marks the
+ * monotonic time at fixed points of each pass (ISR3 received, woken,
+ * converted, filtered, PID/VTK applied, M2 interrupt raised) and at the
+ * end of the pass the time spent in each stage is added to a histogram.
+ * The histograms are log-linear (HDR style): 16 buckets per power of two
+ * of microseconds, so percentiles are good to about 6% from 1us to 16s
+ * with a fixed 336 buckets per stage.
+ *
+ * Only processGuides writes the histograms, so no locks are needed;
+ * readers take the counts as they find them and a reset is only a request
+ * carried out by the writer.
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ * latencyMark     - mark the time at a point of the guide loop
+ * latencyCommit   - add the stages marked in this pass to the histograms
+ * latencyReset    - request that the histograms are cleared
+ * latencyShow     - print the percentiles of each stage
+ * latencyReport   - genSub routine, percentiles of each stage to VALA..D
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ * Stage times are taken modulo 2^32 microseconds (about 71 minutes).
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ *
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>           /* For clock_gettime */
+
+#include "latency.h"
+#include "utilities.h"      /* For OK, ERROR */
+
+#define LATENCY_SUB_BITS   4                             /* 16 per octave  */
+#define LATENCY_SUB_COUNT  (1 << LATENCY_SUB_BITS)
+#define LATENCY_MAX_BITS   24                            /* 2^24 us = 16s  */
+#define LATENCY_BUCKETS    ((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * \
+                            LATENCY_SUB_COUNT)
+
+typedef struct
+{
+   unsigned long   count[LATENCY_BUCKETS];
+   unsigned long   total;          /* samples recorded                  */
+   unsigned long   max;            /* longest stage time (us)           */
+} latencyHistogram;
+
+static const char *stageName[LATENCY_STAGES] =
+{
+   "wakeup",
+   "convert",
+   "filter",
+   "control",
+   "send",
+   "total"
+};
+
+int latencyOn = TRUE;
+
+static latencyHistogram histogram[LATENCY_STAGES];
+static unsigned long mark[LATENCY_POINTS];
+static int marked[LATENCY_POINTS];
+static volatile unsigned long isrTime;
+static volatile int isrMarked = FALSE;
+static volatile int resetRequest = FALSE;
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyNow, latencyBucket, latencyValue
+ *
+ * Purpose:
+ * Monotonic time in microseconds, the histogram bucket holding a stage
+ * time and the largest stage time a bucket holds
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static unsigned long latencyNow (void)
+{
+   struct timespec now;
+
+   clock_gettime (CLOCK_MONOTONIC, &now);
+
+   return (unsigned long) now.tv_sec * 1000000UL +
+      (unsigned long) (now.tv_nsec / 1000);
+}
+
+static int latencyBucket (unsigned long us)
+{
+   int msb = LATENCY_SUB_BITS;
+
+   if (us < LATENCY_SUB_COUNT)
+      return (int) us;
+
+   if (us >= (1UL << LATENCY_MAX_BITS))
+      return LATENCY_BUCKETS - 1;
+
+   while ((us >> (msb + 1)) != 0)
+      msb++;
+
+   return (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT +
+      (int) ((us >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1));
+}
+
+static unsigned long latencyValue (int bucket)
+{
+   int shift;
+
+   if (bucket < LATENCY_SUB_COUNT)
+      return (unsigned long) bucket;
+
+   shift = bucket / LATENCY_SUB_COUNT - 1;
+
+   return ((unsigned long) (LATENCY_SUB_COUNT + bucket % LATENCY_SUB_COUNT + 1)
+         << shift) - 1;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyPercentile
+ *
+ * Purpose:
+ * Stage time (us) below which the fraction q of the samples fall, read
+ * from a histogram
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static double latencyPercentile (const latencyHistogram *h, double q)
+{
+   unsigned long target, sum = 0;
+   int i;
+
+   if (h->total == 0)
+      return 0.0;
+
+   target = (unsigned long) (q * h->total + 0.5);
+   if (target < 1)
+      target = 1;
+
+   for (i = 0; i < LATENCY_BUCKETS; i++)
+   {
+      sum += h->count[i];
+      if (sum >= target)
+         return (double) ((latencyValue (i) < h->max) ? latencyValue (i) : h->max);
+   }
+
+   return (double) h->max;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyMark
+ *
+ * Purpose:
+ * Mark the time at a point of the current pass of processGuides. The
+ * LATENCY_ISR mark is made by rmISR3 and held until LATENCY_WOKEN is
+ * marked, so that an interrupt arriving during a pass is counted in the
+ * pass which it wakes.
+ *
+ * Invocation:
+ * latencyMark(point)
+ *
+ * Parameters in:
+ *              > point   int    LATENCY_ISR .. LATENCY_SENT
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void latencyMark (int point)
+{
+   if (!latencyOn || point < 0 || point >= LATENCY_POINTS)
+      return;
+
+   if (point == LATENCY_ISR)
+   {
+      isrTime = latencyNow ();
+      isrMarked = TRUE;
+      return;
+   }
+
+   if (point == LATENCY_WOKEN && isrMarked)
+   {
+      mark[LATENCY_ISR] = isrTime;
+      marked[LATENCY_ISR] = TRUE;
+      isrMarked = FALSE;
+   }
+
+   mark[point] = latencyNow ();
+   marked[point] = TRUE;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyCommit
+ *
+ * Purpose:
+ * End of a pass of processGuides: add every stage whose start and end
+ * were both marked to its histogram and clear the marks
+ *
+ * Invocation:
+ * latencyCommit()
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void latencyCommit (void)
+{
+   latencyHistogram *h;
+   unsigned long us;
+   int stage, from, to;
+
+   if (resetRequest)
+   {
+      memset (histogram, 0, sizeof (histogram));
+      resetRequest = FALSE;
+   }
+
+   for (stage = 0; stage < LATENCY_STAGES; stage++)
+   {
+      from = (stage == LATENCY_TOTAL) ? LATENCY_ISR : stage;
+      to = (stage == LATENCY_TOTAL) ? LATENCY_SENT : stage + 1;
+
+      if (!marked[from] || !marked[to])
+         continue;
+
+      us = mark[to] - mark[from];
+      h = &histogram[stage];
+
+      h->count[latencyBucket (us)]++;
+      h->total++;
+      if (us > h->max)
+         h->max = us;
+   }
+
+   memset (marked, 0, sizeof (marked));
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyReset
+ *
+ * Purpose:
+ * Ask processGuides to clear the histograms at the end of its next pass
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void latencyReset (void)
+{
+   resetRequest = TRUE;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * latencyShow
+ *
+ * Purpose:
+ * Print the 50th and 99th percentile and the maximum time of each stage
+ *
+ * Invocation:
+ * status = latencyShow()
+ *
+ * Return value:
+ *              < status  int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int latencyShow (void)
+{
+   int stage;
+
+   printf ("stage         samples      p50 (us)    p99 (us)    max (us)\n");
+
+   for (stage = 0; stage < LATENCY_STAGES; stage++)
+   {
+      printf ("%-10s %10lu  %10.0f  %10.0f  %10lu\n", stageName[stage],
+            histogram[stage].total,
+            latencyPercentile (&histogram[stage], 0.50),
+            latencyPercentile (&histogram[stage], 0.99),
+            histogram[stage].max);
+   }
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * latencyReport
+ *
+ * Purpose:
+ * genSub routine publishing the latency of each stage of the guide loop,
+ * in the order wakeup, convert, filter, control, send, total
+ *
+ * Invocation:
+ * status = latencyReport(pgsub)
+ *
+ * Parameters in:
+ *              > pgsub->a    long   non zero to clear the histograms
+ *
+ * Parameters out:
+ *              < pgsub->vala double[6]   50th percentile (us)
+ *              < pgsub->valb double[6]   99th percentile (us)
+ *              < pgsub->valc double[6]   maximum (us)
+ *              < pgsub->vald long[6]     samples
+ *
+ * Return value:
+ *              < status      long        OK
+ *
+ * Globals:
+ *      External functions:
+ *      None
+ *
+ *      External variables:
+ *      None
+ *
+ * Requirements:
+ *
+ * Author:
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+long latencyReport (struct genSubRecord *pgsub)
+{
+   int stage;
+
+   for (stage = 0; stage < LATENCY_STAGES; stage++)
+   {
+      ((double *) pgsub->vala)[stage] =
+         latencyPercentile (&histogram[stage], 0.50);
+      ((double *) pgsub->valb)[stage] =
+         latencyPercentile (&histogram[stage], 0.99);
+      ((double *) pgsub->valc)[stage] = (double) histogram[stage].max;
+      ((long *) pgsub->vald)[stage] = (long) histogram[stage].total;
+   }
+
+   if (*(long *) pgsub->a != 0)
+   {
+      latencyReset ();
+      *(long *) pgsub->a = 0;
+   }
+
+   return (OK);
+}
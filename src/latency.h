@@ -0,0 +1,80 @@
+/*+
+ *
+ * FILENAME
+ * --------
+ * latency.h
+ *
+ * PURPOSE
+ * -------
+ * Header file defines the public interface for latency.c
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+#ifndef _INCLUDED_LATENCY_H
+#define _INCLUDED_LATENCY_H
+
+#ifndef _INCLUDED_GENSUBRECORD_H
+#define _INCLUDED_GENSUBRECORD_H
+#include <genSubRecord.h>
+#endif
+
+/* Points in one pass of processGuides at which the time is marked */
+
+enum
+{
+        LATENCY_ISR = 0,        /* ISR3 received                        */
+        LATENCY_WOKEN,          /* processGuides woken by guideUpdateNow*/
+        LATENCY_CONVERTED,      /* guide sample in M2 coordinates       */
+        LATENCY_FILTERED,       /* guide sample filtered                */
+        LATENCY_CONTROLLED,     /* PID and VTK applied                  */
+        LATENCY_SENT,           /* rmIntSend(INT2, M2_NODE) raised      */
+        LATENCY_POINTS
+};
+
+/* Stages histogrammed, stage n runs from point n to point n + 1 and the
+ * last stage from LATENCY_ISR to LATENCY_SENT */
+
+enum
+{
+        LATENCY_WAKEUP = 0,
+        LATENCY_CONVERT,
+        LATENCY_FILTER,
+        LATENCY_CONTROL,
+        LATENCY_SEND,
+        LATENCY_TOTAL,
+        LATENCY_STAGES
+};
+
+/* Public functions */
+
+void latencyMark (int point);
+
+void latencyCommit (void);
+
+void latencyReset (void);
+
+int latencyShow (void);
+
+long latencyReport (struct genSubRecord *pgsub);
+
+/* Global variables */
+
+extern int latencyOn;
+
+#endif
@@ -0,0 +1,498 @@
+/* ===================================================================== */
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * schedule.c
+ *
+ * PURPOSE
+ * -------
+ * Time triggered scheduling of the TCS follow demands. Each demand accepted
+ * by tcsInterpolate is queued here under its timeApply. When slowTransmit
+ * prepares the next command frame it asks for the time that frame will be
+ * committed to reflective memory, predicted from the frames committed so
+ * far, and takes from the queue every demand for which that frame is the
+ * closest. The frame is then evaluated at its own commit time, either on
+ * the interpolated trajectory or, with scheduleInterpolate off, by holding
+ * the latest demand due, instead of at whatever time slowTransmit ran.
+ *
+ * processGuides reports the time each frame was committed, and the
+ * difference from the timeApply of every demand the frame carried is kept
+ * as the apply error of that demand.
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ * scheduleInit      - create the lock on the queue
+ * scheduleDemand    - queue a demand, called by receiveTcsDemand
+ * scheduleNextFrame - predicted commit time of the next frame
+ * scheduleDue       - take the demands due at a frame, called by
+ *                     slowTransmit
+ * scheduleArm       - attach the demands taken to the frame being composed
+ * scheduleCommitted - record the commit time of a frame, called by
+ *                     processGuides
+ * scheduleShow      - print the queue and the apply errors
+ * scheduleReset     - clear the apply error statistics
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ * The frame period is learnt from the commit times, so the first demands
+ * after the guide loop starts are taken at the frame after slowTransmit
+ * runs.
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ *
+ * 17-Oct-2026: Original
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+#include <stdio.h>
+#include <math.h>           /* For sqrt, fabs */
+
+#include <epicsMutex.h>
+
+#include "schedule.h"
+#include "utilities.h"      /* For OK, ERROR, errorLog */
+
+#define SCHEDULE_QUEUE_SIZE   32        /* 1.6s of demands at 20Hz        */
+#define SCHEDULE_PER_FRAME    8         /* demands carried by one frame   */
+#define SCHEDULE_HISTORY      16        /* apply errors kept for display  */
+#define SCHEDULE_MAX_PERIOD   0.1       /* longer frame gaps are stalls   */
+
+int scheduleInterpolate = TRUE;         /* FALSE to step at each demand   */
+double scheduleMaxLate = 0.5;           /* discard demands older than (s) */
+
+static epicsMutexId scheduleFree = NULL;
+
+/* demands waiting for their frame, oldest first */
+static Demands queue[SCHEDULE_QUEUE_SIZE];
+static int queueHead = 0;
+static int queueCount = 0;
+
+/* timeApply of the demands taken by scheduleDue and of those attached to
+ * the frame being composed */
+static double prepared[SCHEDULE_PER_FRAME];
+static int preparedCount = 0;
+static double armed[SCHEDULE_PER_FRAME];
+static int armedCount = 0;
+
+/* frame timing learnt from scheduleCommitted */
+static double lastCommit = 0.0;
+static double framePeriod = 0.0;
+
+/* apply error statistics */
+static unsigned long queued = 0;
+static unsigned long applied = 0;
+static unsigned long late = 0;
+static unsigned long discarded = 0;
+static unsigned long overflows = 0;
+static double errorSum = 0.0;
+static double errorSumSq = 0.0;
+static double errorMax = 0.0;
+static double history[SCHEDULE_HISTORY][2];     /* timeApply, apply error */
+static int historyNext = 0;
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleInit
+ *
+ * Purpose:
+ * Create the lock on the queue and the frame timing
+ *
+ * Invocation:
+ * status = scheduleInit()
+ *
+ * Return value:
+ *              < status  int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int scheduleInit (void)
+{
+   if (scheduleFree == NULL && (scheduleFree = epicsMutexCreate ()) == NULL)
+   {
+      errorLog ("scheduleInit - error creating scheduleFree", 1, ON);
+      return ERROR;
+   }
+
+   return OK;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleDemand
+ *
+ * Purpose:
+ * Queue a TCS demand to be applied at the frame closest to its timeApply.
+ * Demands arrive in timeApply order, tcsInterpolate rejects any other.
+ *
+ * Invocation:
+ * status = scheduleDemand(&demand)
+ *
+ * Parameters in:
+ *              > demand  Demands*   demand accepted by tcsInterpolate
+ *
+ * Return value:
+ *              < status  int    OK, ERROR if the queue is full
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int scheduleDemand (const Demands *demand)
+{
+   int status = OK;
+
+   epicsMutexLock (scheduleFree);
+
+   if (queueCount < SCHEDULE_QUEUE_SIZE)
+   {
+      queue[(queueHead + queueCount) % SCHEDULE_QUEUE_SIZE] = *demand;
+      queueCount++;
+      queued++;
+   }
+   else
+   {
+      overflows++;
+      status = ERROR;
+   }
+
+   epicsMutexUnlock (scheduleFree);
+
+   return status;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleNextFrame
+ *
+ * Purpose:
+ * Predict the commit time of the first frame after now from the last
+ * commit and the learnt frame period
+ *
+ * Invocation:
+ * frameTime = scheduleNextFrame(now)
+ *
+ * Parameters in:
+ *              > now        double   current time
+ *
+ * Return value:
+ *              < frameTime  double   predicted commit time, now if the
+ *                                    frame period is not known yet
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+double scheduleNextFrame (double now)
+{
+   double frameTime, period;
+
+   epicsMutexLock (scheduleFree);
+   frameTime = lastCommit;
+   period = framePeriod;
+   epicsMutexUnlock (scheduleFree);
+
+   if (period <= 0.0 || now - frameTime > SCHEDULE_MAX_PERIOD)
+      return now;
+
+   while (frameTime < now)
+      frameTime += period;
+
+   return frameTime;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleDue
+ *
+ * Purpose:
+ * Take from the queue every demand for which the frame committed at
+ * frameTime is the closest, or which is already overdue. Demands overdue
+ * by more than scheduleMaxLate, left from an earlier follow, are
+ * discarded. The demands taken are attached to the frame by scheduleArm.
+ *
+ * Invocation:
+ * due = scheduleDue(frameTime, &demand)
+ *
+ * Parameters in:
+ *              > frameTime  double     predicted commit time of the frame
+ *
+ * Parameters out:
+ *              < demand     Demands*   latest demand taken, unchanged if
+ *                                      none is due
+ *
+ * Return value:
+ *              < due        int        number of demands taken
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int scheduleDue (double frameTime, Demands *demand)
+{
+   const Demands *next;
+   double half;
+   int due = 0;
+
+   epicsMutexLock (scheduleFree);
+
+   half = framePeriod / 2.0;
+
+   while (queueCount > 0)
+   {
+      next = &queue[queueHead];
+
+      if (next->timeApply >= frameTime + half)
+         break;
+
+      if (next->timeApply < frameTime - scheduleMaxLate)
+      {
+         discarded++;
+      }
+      else
+      {
+         if (next->timeApply < frameTime - half)
+            late++;
+
+         if (preparedCount < SCHEDULE_PER_FRAME)
+            prepared[preparedCount++] = next->timeApply;
+
+         *demand = *next;
+         due++;
+      }
+
+      queueHead = (queueHead + 1) % SCHEDULE_QUEUE_SIZE;
+      queueCount--;
+   }
+
+   epicsMutexUnlock (scheduleFree);
+
+   return due;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleArm
+ *
+ * Purpose:
+ * Attach the demands taken by scheduleDue to the frame being composed.
+ * Called by slowTransmit while it holds the lock on the frame, so that
+ * they are reported against the frame that carries them.
+ *
+ * Invocation:
+ * scheduleArm()
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void scheduleArm (void)
+{
+   int i;
+
+   epicsMutexLock (scheduleFree);
+
+   for (i = 0; i < preparedCount && armedCount < SCHEDULE_PER_FRAME; i++)
+      armed[armedCount++] = prepared[i];
+
+   preparedCount = 0;
+
+   epicsMutexUnlock (scheduleFree);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleCommitted
+ *
+ * Purpose:
+ * Record the time a frame was committed to reflective memory: learn the
+ * frame period and the apply error of each demand the frame carried.
+ * Called by processGuides while it holds the lock on the frame.
+ *
+ * Invocation:
+ * scheduleCommitted(commitTime)
+ *
+ * Parameters in:
+ *              > commitTime  double   time the frame was committed
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+void scheduleCommitted (double commitTime)
+{
+   double interval, error;
+   int i;
+
+   epicsMutexLock (scheduleFree);
+
+   interval = commitTime - lastCommit;
+   if (interval > 0.0 && interval < SCHEDULE_MAX_PERIOD)
+   {
+      if (framePeriod <= 0.0)
+         framePeriod = interval;
+      else
+         framePeriod += (interval - framePeriod) / 16.0;
+   }
+   lastCommit = commitTime;
+
+   for (i = 0; i < armedCount; i++)
+   {
+      error = commitTime - armed[i];
+
+      errorSum += error;
+      errorSumSq += error * error;
+      if (fabs (error) > errorMax)
+         errorMax = fabs (error);
+
+      history[historyNext][0] = armed[i];
+      history[historyNext][1] = error;
+      historyNext = (historyNext + 1) % SCHEDULE_HISTORY;
+
+      applied++;
+   }
+
+   armedCount = 0;
+
+   epicsMutexUnlock (scheduleFree);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleShow
+ *
+ * Purpose:
+ * Print the queue, the frame timing and the apply errors
+ *
+ * Invocation:
+ * status = scheduleShow()
+ *
+ * Return value:
+ *              < status  int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int scheduleShow (void)
+{
+   double recent[SCHEDULE_HISTORY][2];
+   double mean = 0.0, rms = 0.0, maximum, period, nextApply = 0.0;
+   unsigned long counts[5];
+   int waiting, next, i, n;
+
+   epicsMutexLock (scheduleFree);
+
+   counts[0] = queued;
+   counts[1] = applied;
+   counts[2] = late;
+   counts[3] = discarded;
+   counts[4] = overflows;
+   if (applied > 0)
+   {
+      mean = errorSum / applied;
+      rms = sqrt (errorSumSq / applied);
+   }
+   maximum = errorMax;
+   period = framePeriod;
+   waiting = queueCount;
+   if (queueCount > 0)
+      nextApply = queue[queueHead].timeApply;
+   next = historyNext;
+   for (i = 0; i < SCHEDULE_HISTORY; i++)
+   {
+      recent[i][0] = history[i][0];
+      recent[i][1] = history[i][1];
+   }
+
+   epicsMutexUnlock (scheduleFree);
+
+   printf ("demand schedule, %s, frame period %.3f ms\n",
+         scheduleInterpolate ? "interpolated" : "stepped", period * 1000.0);
+   printf ("queued %lu, applied %lu, late %lu, discarded %lu, overflows %lu\n",
+         counts[0], counts[1], counts[2], counts[3], counts[4]);
+   printf ("waiting %d", waiting);
+   if (waiting > 0)
+      printf (", next timeApply %.6f", nextApply);
+   printf ("\n");
+   printf ("apply error mean %.3f ms, rms %.3f ms, max %.3f ms\n",
+         mean * 1000.0, rms * 1000.0, maximum * 1000.0);
+
+   n = (counts[1] < SCHEDULE_HISTORY) ? (int) counts[1] : SCHEDULE_HISTORY;
+   if (n > 0)
+      printf ("        timeApply   error (ms)\n");
+
+   for (i = 0; i < n; i++)
+   {
+      next = (next + SCHEDULE_HISTORY - 1) % SCHEDULE_HISTORY;
+      printf ("%17.6f  %10.3f\n", recent[next][0], recent[next][1] * 1000.0);
+   }
+
+   return OK;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * scheduleReset
+ *
+ * Purpose:
+ * Clear the apply error statistics
+ *
+ * Invocation:
+ * status = scheduleReset()
+ *
+ * Return value:
+ *              < status  int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int scheduleReset (void)
+{
+   epicsMutexLock (scheduleFree);
+
+   queued = applied = late = discarded = overflows = 0;
+   errorSum = errorSumSq = errorMax = 0.0;
+   historyNext = 0;
+
+   epicsMutexUnlock (scheduleFree);
+
+   return OK;
+}
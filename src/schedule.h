@@ -0,0 +1,57 @@
+/*+
+ *
+ * FILENAME
+ * --------
+ * schedule.h
+ *
+ * PURPOSE
+ * -------
+ * Header file defines the public interface for schedule.c
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+#ifndef _INCLUDED_SCHEDULE_H
+#define _INCLUDED_SCHEDULE_H
+
+#include "control.h"    /* For Demands */
+
+/* Public functions */
+
+int scheduleInit (void);
+
+int scheduleDemand (const Demands *demand);
+
+double scheduleNextFrame (double now);
+
+int scheduleDue (double frameTime, Demands *demand);
+
+void scheduleArm (void);
+
+void scheduleCommitted (double commitTime);
+
+int scheduleShow (void);
+
+int scheduleReset (void);
+
+/* Global variables */
+
+extern int scheduleInterpolate;
+extern double scheduleMaxLate;
+
+#endif
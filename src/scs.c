@@ -55,6 +55,8 @@
  * 02-Jun-1999: Expanded tabs to blanks
  *
  * 06-Oct-2017: Conversion to EPICS OSI started. (MDW)
+ * 17-Oct-2026: receiveTcsDemand reads M2 status with readStatus
+ * 17-Oct-2026: Accepted follow demands queued with scheduleDemand
  *
  */
 
@@ -78,6 +80,7 @@
 #include "guide.h"          /* For enum define of instrument indices */
 #include "interlock.h"      /* For scsState */
 #include "interp.h"         /* For tcsInterpolate */
+#include "schedule.h"       /* For scheduleDemand */
 
 /* Define default tilt and focus scaling */
 #define DEFAULT_TILT_SCALE    3.917
@@ -236,6 +239,7 @@ long receiveTcsDemand (struct genSubRecord * pgsub)
     double tcsUpdate[FOLLOW_ARRAY_SIZE];
            /*= {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 22.22, 33.33};*/
     double *ptr, scsTimeNow;
+    statusBlock status;
 
 
     static double lastDmdX;
@@ -353,7 +357,8 @@ long receiveTcsDemand (struct genSubRecord * pgsub)
 
       if (arrayS == 0) {
 
-    beam = (int)(scsPtr->page1.beamPosition);
+    readStatus (&status);
+    beam = (int)(status.beamPosition);
 
     /* Inspect "beam" */
     if ((beam != BEAMA) && (beam != BEAMB) && (beam != BEAMC)) {
@@ -366,10 +371,10 @@ long receiveTcsDemand (struct genSubRecord * pgsub)
 
       beamDiscrepancy = FALSE;
 
-      currFrame = (int) scsPtr->page1.NR;
-      currFocus = scsPtr->page1.zFocus;
-      currXtilt = scsPtr->page1.xTilt;
-      currYtilt = scsPtr->page1.yTilt;
+      currFrame = (int) status.NR;
+      currFocus = status.zFocus;
+      currXtilt = status.xTilt;
+      currYtilt = status.yTilt;
 
 
       /* "first" gets reset to TRUE each time follow is turned ON */
@@ -524,7 +529,9 @@ long receiveTcsDemand (struct genSubRecord * pgsub)
       tcs.xTiltC = position.xTiltNew;
       tcs.yTiltC = position.yTiltNew;
 
-      tcsInterpolate (tcs);
+      /* fit the trajectory and queue the demand for its frame */
+      if (tcsInterpolate (tcs) == OK)
+        scheduleDemand (&tcs);
 
       /* too much time to print - don't use
          if (beamDiscrepancy == TRUE)
@@ -32,6 +32,14 @@
  * 23-Jun-1998: Create message queue for health reporting
  * 07-May-1999: Added RCS id
  * 05-Dec-2017: Begin conversion to EPICS OSI (mdw)
+ * 17-Oct-2026: Command queue created by commandInit
+ * 17-Oct-2026: Page 0 image created by commandPageInit
+ * 17-Oct-2026: Telemetry ring created by telemetryInit
+ * 17-Oct-2026: Guide ring buffer allocated by cbInit
+ * 17-Oct-2026: Interpolator lock created by interpInit
+ * 17-Oct-2026: Demand schedule created by scheduleInit
+ * 17-Oct-2026: Filter lock and retune task created by filterInit
+ * 17-Oct-2026: chopConfigC found for the command completion callbacks
  *
  * oi
  */
@@ -49,13 +57,18 @@
 #include "setup.h"
 #include "utilities.h"  /* For errorLog, loadInitFiles, compileStatus,
                            statusCompiled, doPvLoad, pvLoadComplete */
-#include "guide.h"      /* For createFilter, setPointFree */
+#include "guide.h"      /* For createFilter, filterInit, setPointFree */
 #include "archive.h"    /* For loggerTask, refMemFree, logCAddr */
 #include "control.h"    /* For fireLoops, slowTransmit, scsReceive, scsPtr, 
                            scsBase, m2Ptr, m2MemFree, slowUpdate, wfsFree
                            diagnosticsAvailable, scsDataAvailable,
-                           scsReceiveNow, commandQId, receiveQId 
+                           scsReceiveNow, receiveQId
                            SYSTEM_CLOCK_RATE */
+#include "command.h"    /* For commandInit, commandCarInit */
+#include "chop.h"       /* For chopConfigCar */
+#include "telemetry.h"  /* For telemetryInit */
+#include "interp.h"     /* For interpInit */
+#include "schedule.h"   /* For scheduleInit */
 
 
 #define TOP "m2:"
@@ -120,6 +133,8 @@ epicsMessageQueueId  healthQId = NULL;
  * 10-Feb-1998: Incorporate spawning of guide handling tasks
  * 05-Dec-2017: Removed scsReady semaphore creation code since the semaphore
  *              wasn't being used anywhere. (mdw)
+ * 17-Oct-2026: Load the filter coefficient bank before creating filters
+ * 17-Oct-2026: Find chopConfigC for chopConfigCar
  */
 
 /* INDENT ON */
@@ -145,12 +160,35 @@ int scsInit (void)
       return (ERROR);
    }
 
+   /* get address of the chop configuration CAR, driven by the
+    * acknowledgement of the commands CADchopConfig sends */
+
+   if (commandCarInit (&chopConfigCar, TOP "chopConfigC") != OK)
+   {
+      errlogPrintf("scsInit - unable to fetch address of chopConfigC CAR\n");
+      return (ERROR);
+   }
+
    /* mutex semaphore to prevent multiple access to guide data */
    for (source = PWFS1; source <= GYRO; source++)
    {
       wfsFree[source] = epicsMutexMustCreate();
    }
 
+   /* read the filter coefficient tables once, so that guide configuration
+    * does not need any file I/O */
+   if (loadFilterBank () != OK)
+   {
+      errlogPrintf("scsInit - unable to load filter coefficient bank\n");
+   }
+
+   /* create the lock and retune task used by createFilter */
+   if (filterInit () != OK)
+   {
+      errlogPrintf("scsInit - unable to create filter lock\n");
+      return (ERROR);
+   }
+
    /* create dummy filters for each of the guide sources */
    for (source = PWFS1; source <= GYRO; source++)
    {
@@ -244,15 +282,46 @@ int scsInit (void)
 
    printf ("initRefMem, scsPtr = 0x%p, scsBase = 0x%p\n",  scsPtr, scsBase); 
 
+   /* local image of the command page, committed by processGuides */
+
+   if (commandPageInit () != OK)
+   {
+      errorLog ("initRefMem(): error in creation of page 0 image", 1, ON);
+   }
+
    /* create command message queue */
 
-   if ((commandQId = epicsMessageQueueCreate(100, sizeof (long))) == NULL)
+   if (commandInit () != OK)
    {
-      errorLog ("initRefMem(): error in creation of commandQId message queue", 1, ON);
+      errorLog ("initRefMem(): error in creation of command pipeline", 1, ON);
    }
-   else
+
+   /* ring of guide loop samples for the telemetry recorder */
+
+   if (telemetryInit () != OK)
+   {
+      errorLog ("initRefMem(): error in creation of telemetry ring", 1, ON);
+   }
+
+   /* lock on the TCS demand trajectory */
+
+   if (interpInit () != OK)
+   {
+      errorLog ("initRefMem(): error in creation of interpolator lock", 1, ON);
+   }
+
+   /* queue of TCS demands waiting for their frame */
+
+   if (scheduleInit () != OK)
+   {
+      errorLog ("initRefMem(): error in creation of demand schedule", 1, ON);
+   }
+
+   /* ring of guide loop records, cbRecordNb may be set before this */
+
+   if (cbInit () != OK)
    {
-      printf ("iinitRefMem(): commandQId message queue created successfully\n");
+      errorLog ("initRefMem(): error in creation of guide ring buffer", 1, ON);
    }
 
    /* create command receiving queue for the simulation */
@@ -14,6 +14,10 @@
  * 
  * FUNCTION NAME(S)
  * ----------------
+ * initM2Diagnostics    - Probe for the synchro card and create the
+ *            engineering page cache
+ * m2EngSnapshot        - Copy of the M2 engineering page, refreshed from
+ *            reflective memory in one block when stale
  * readM2Diagnostics    - Write diagnostic data from fg osp structure to gensub
  *            outputs for display
  * gensubFanDoubles - receive array of doubles on port A, write elements to
@@ -33,6 +37,10 @@
  * -------
  * 
  * 28-Jan-1999: Original (srp)
+ * 17-Oct-2026: Engineering page read as one block into a versioned cache,
+ *              card probe moved to initM2Diagnostics
+ * 17-Oct-2026: Include vxLib.h for vxMemProbe, initM2Diagnostics called
+ *              on first use of the cache
  *
  */
 /* INDENT ON */
@@ -47,7 +55,9 @@
 #include "utilities.h"          /* For tilt2act */
 
 #include <cad.h>
+#include <stddef.h>             /* For offsetof */
 #include <logLib.h>             /* For logMsg */
+#include <vxLib.h>              /* For vxMemProbe, VX_READ */
 #include <stdio.h>
 #include <math.h>
 #include <string.h>
@@ -75,6 +85,10 @@
 
 #define IN_POSITION_LIMIT 100.0 /* actuator error within this range (microns), OK to turn on servos */
 
+/* only the engineering fields are copied from RM, not the page padding */
+
+#define M2ENG_SNAPSHOT_SIZE offsetof(m2EngData, pad)
+
 typedef struct
 {
     double  item1;
@@ -154,6 +168,154 @@ static char *primitiveName[] =
     NULL
 };
 
+/* Engineering page cache. The page is copied from reflective memory in one
+ * block and the copy is shared by every reader until it is older than
+ * m2EngMaxAge seconds, so that a display scan costs one burst of RM reads
+ * instead of one VME access per field. */
+
+double m2EngMaxAge = 0.1;
+
+static struct
+{
+    epicsMutexId    access;
+    long            version;        /* number of refreshes from RM         */
+    double          taken;          /* monotonicNow of the last refresh    */
+    m2EngData       eng;
+} engCache;
+
+static int synchroPresent = FALSE;
+
+
+/* ===================================================================== */
+/*
+ *+
+ * FUNCTION NAME:
+ * initM2Diagnostics
+ *
+ * INVOCATION:
+ * status = initM2Diagnostics(pgsub)
+ *
+ * PARAMETERS: (">" input, "!" modified, "<" output)
+ * > genSubRecord (struct genSubRecord *)   pointer to record
+ *
+ * FUNCTION VALUE:
+ * long  OK, or ERROR if the cache mutex could not be created
+ *
+ * PURPOSE:
+ * Check once for the synchro card and create the engineering page cache.
+ * Called by m2EngSnapshot on first use; pgsub is not used.
+ *
+ * HISTORY (optional):
+ * 17-Oct-2026  Original version
+ * 17-Oct-2026  No longer the INAM of readRmDiags, called by m2EngSnapshot
+ *-
+ */
+
+long    initM2Diagnostics (struct genSubRecord * pgsub)
+{
+    char junk;
+
+    if (engCache.access == NULL)
+    {
+        if ((engCache.access = epicsMutexCreate ()) == NULL)
+        {
+            errorLog ("initM2Diagnostics - cannot create cache mutex", 1, ON);
+            return (ERROR);
+        }
+        engCache.version = 0;
+        engCache.taken = 0.0;
+    }
+
+    /* check 5588 synchro card memory location */
+
+    if (scsBase != NULL &&
+        vxMemProbe ((void *)scsBase, VX_READ, 1, &junk) == OK)
+    {
+        synchroPresent = TRUE;
+    }
+    else
+    {
+        synchroPresent = FALSE;
+        logMsg ("initM2Diagnostics - synchro card not detected at address %p\n",
+                (int)scsBase, 0, 0, 0, 0, 0);
+    }
+
+    return (OK);
+}
+
+/* ===================================================================== */
+/*
+ *+
+ * FUNCTION NAME:
+ * m2EngSnapshot
+ *
+ * INVOCATION:
+ * version = m2EngSnapshot(&eng)
+ *
+ * PARAMETERS: (">" input, "!" modified, "<" output)
+ * < eng (m2EngData *)   copy of the engineering fields of the M2 page
+ *
+ * FUNCTION VALUE:
+ * long  version of the copy, which increases with every refresh from RM,
+ *       or ERROR if there is no page to read
+ *
+ * PURPOSE:
+ * Return the cached engineering page, first refreshing it with a single
+ * block copy from reflective memory (or the simulation page) if it is
+ * older than m2EngMaxAge. Callers may compare versions to skip work when
+ * the data have not changed.
+ *
+ * HISTORY (optional):
+ * 17-Oct-2026  Original version
+ *-
+ */
+
+long    m2EngSnapshot (m2EngData * eng)
+{
+    memMap *ptr;
+    double now;
+    long version;
+
+    if (engCache.access == NULL && initM2Diagnostics (NULL) != OK)
+        return (ERROR);
+
+    if (simLevel == 0)
+    {
+        if (!synchroPresent)
+            return (ERROR);
+        ptr = scsBase;
+    }
+    else
+        ptr = m2Ptr;
+
+    if (ptr == NULL)
+        return (ERROR);
+
+    now = monotonicNow ();
+
+    epicsMutexLock (engCache.access);
+
+    if (engCache.version == 0 || now - engCache.taken >= m2EngMaxAge)
+    {
+        if (simLevel != 0)
+            epicsMutexLock (m2MemFree);
+
+        memcpy (&engCache.eng, (void *)&ptr->m2Eng, M2ENG_SNAPSHOT_SIZE);
+
+        if (simLevel != 0)
+            epicsMutexUnlock (m2MemFree);
+
+        engCache.taken = now;
+        engCache.version++;
+    }
+
+    memcpy (eng, &engCache.eng, M2ENG_SNAPSHOT_SIZE);
+    version = engCache.version;
+
+    epicsMutexUnlock (engCache.access);
+
+    return (version);
+}
 
 /* ===================================================================== */
 /*
@@ -189,20 +351,26 @@ static char *primitiveName[] =
  *
  * HISTORY (optional):
  * 28-Jan-1999  Original version  (srp)
+ * 17-Oct-2026  Fields taken from m2EngSnapshot and readStatus rather than
+ *              read one at a time from RM; card probed once at init
  *-
  */
 
 long    readM2Diagnostics (struct genSubRecord * pgsub)
 { 
-    char junk;
     int index = 0;
     double act1[21], act2[21], act3[21], sys[21];
     location position;
     long servoInPosition; 
     memMap *ptr;
+    m2EngData eng;
+    statusBlock status;
     char msg[80];
     long errorSystem, errorCode;
     static long lastErrorSystem, lastErrorCode;  
+    static double lastXTilt, lastYTilt, lastZFocus;
+    static location lastPosition;
+    static int positionValid = FALSE;
 
     if(simLevel == 0)
       ptr = scsBase;
@@ -217,48 +385,48 @@ long    readM2Diagnostics (struct genSubRecord * pgsub)
         sys[index] = 0.0;
       }
 
-    /* check 5588 synchro card memory location, exit if not found */
+    /* one block copy of the m2 diagnostic page, exit if the synchro card
+       was not found at init */
 
-    if (vxMemProbe ((void *)ptr, VX_READ, 1, &junk) != OK)    
-    {
-      logMsg("readM2Diagnostics - synchro card not detected at address %p\n", (int)ptr, 0, 0, 0, 0, 0);
+    if (m2EngSnapshot (&eng) == ERROR)
         return(ERROR);
-    }
+
+    readStatus (&status);
 
     /* read data from m2 diagnostic page into local arrays */
 
-    act1[0] = ptr->page1.actuator1;
-    act1[1] = ptr->m2Eng.follow1;
-    act1[2] = ptr->m2Eng.current1;
-    act1[3] = ptr->m2Eng.kaman1;
-    act1[4] = ptr->m2Eng.integ1;
+    act1[0] = status.actuator1;
+    act1[1] = eng.follow1;
+    act1[2] = eng.current1;
+    act1[3] = eng.kaman1;
+    act1[4] = eng.integ1;
 
-    act2[0] = ptr->page1.actuator2;
-    act2[1] = ptr->m2Eng.follow2;
-    act2[2] = ptr->m2Eng.current2;
-    act2[3] = ptr->m2Eng.kaman2;
-    act2[4] = ptr->m2Eng.integ2;
+    act2[0] = status.actuator2;
+    act2[1] = eng.follow2;
+    act2[2] = eng.current2;
+    act2[3] = eng.kaman2;
+    act2[4] = eng.integ2;
 
-    act3[0] = ptr->page1.actuator3;
-    act3[1] = ptr->m2Eng.follow3;
-    act3[2] = ptr->m2Eng.current3;
-    act3[3] = ptr->m2Eng.kaman3;
-    act3[4] = ptr->m2Eng.integ3;
+    act3[0] = status.actuator3;
+    act3[1] = eng.follow3;
+    act3[2] = eng.current3;
+    act3[3] = eng.kaman3;
+    act3[4] = eng.integ3;
 
     /* Tracking down the corrupted RM values. The following 
        are copies of the MCDSP real values, the scale factors 
        and the computed values of xTilt, yTilt and zFocus */
 
-    act1[5] = ptr->m2Eng.TMS2realXTilt;
-    act1[6] = ptr->m2Eng.TMS2realYTilt;
-    act1[7] = ptr->m2Eng.TMS2realZFocus;
+    act1[5] = eng.TMS2realXTilt;
+    act1[6] = eng.TMS2realYTilt;
+    act1[7] = eng.TMS2realZFocus;
 
-    act1[8] = ptr->m2Eng.xTilt;
-    act1[9] = ptr->m2Eng.yTilt;
-    act1[10] = ptr->m2Eng.zFocus;
+    act1[8] = eng.xTilt;
+    act1[9] = eng.yTilt;
+    act1[10] = eng.zFocus;
 
-    act1[11] = ptr->m2Eng.rad2arcsec;
-    act1[12] = ptr->m2Eng.mm2um;
+    act1[11] = eng.rad2arcsec;
+    act1[12] = eng.mm2um;
 
 
     /* write packaged arrays to val fields */
@@ -272,17 +440,31 @@ long    readM2Diagnostics (struct genSubRecord * pgsub)
     /* turn on fine control */
 
     /* fetch set point values from reflective memory*/
-    /* calculate actuator positions corresponding to tilt and focus */
+    /* calculate actuator positions corresponding to tilt and focus,
+       only when the set point has changed */
 
     position.xTilt = ptr->page0.AxTilt;
     position.yTilt = ptr->page0.AyTilt;
     position.zFocus = ptr->page0.zFocusGuide;
 
-    tilt2act (&position);
+    if (!positionValid || position.xTilt != lastXTilt ||
+        position.yTilt != lastYTilt || position.zFocus != lastZFocus)
+    {
+        lastXTilt = position.xTilt;
+        lastYTilt = position.yTilt;
+        lastZFocus = position.zFocus;
+        tilt2act (&position);
+        lastPosition = position;
+        positionValid = TRUE;
+    }
+    else
+    {
+        position = lastPosition;
+    }
 
-    if((fabs(position.actuator1-ptr->page1.actuator1) < (IN_POSITION_LIMIT+7)) &&
-       (fabs(position.actuator2-ptr->page1.actuator2) < (IN_POSITION_LIMIT+7)) &&
-       (fabs(position.actuator3-ptr->page1.actuator3) < (IN_POSITION_LIMIT+7))   )
+    if((fabs(position.actuator1-status.actuator1) < (IN_POSITION_LIMIT+7)) &&
+       (fabs(position.actuator2-status.actuator2) < (IN_POSITION_LIMIT+7)) &&
+       (fabs(position.actuator3-status.actuator3) < (IN_POSITION_LIMIT+7))   )
     {
         servoInPosition = 1;
     }
@@ -297,17 +479,17 @@ long    readM2Diagnostics (struct genSubRecord * pgsub)
 
         /* Tracking down the corrupted RM values. The following 
            are copies of the MCDSP raw values and the frame number */
-        *(long *) pgsub->valf = ptr->m2Eng.rawXTilt;
-        *(long *) pgsub->valg = ptr->m2Eng.rawYTilt;
-        *(long *) pgsub->valh = ptr->m2Eng.rawZFocus;
-        *(long *) pgsub->vali = ptr->m2Eng.NR;
+        *(long *) pgsub->valf = eng.rawXTilt;
+        *(long *) pgsub->valg = eng.rawYTilt;
+        *(long *) pgsub->valh = eng.rawZFocus;
+        *(long *) pgsub->vali = eng.NR;
 
         /* write progress of initialization to output port j */
-        *(long *) pgsub->valj = ptr->m2Eng.initState;
+        *(long *) pgsub->valj = eng.initState;
 
         /* read last recorded M2 error from RM */
-        errorSystem = (long)(ptr->m2Eng.errorSystem);
-        errorCode   = (long)(ptr->m2Eng.errorCode);
+        errorSystem = (long)(eng.errorSystem);
+        errorCode   = (long)(eng.errorCode);
 
         /* based on these values, determine the error msg */
 	/* note: errorSystem and errorCode must be > 0    */
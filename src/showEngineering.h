@@ -26,6 +26,7 @@
  * HISTORY
  * -------
  * 17-Nov-1999: Created new header files. KG
+ * 17-Oct-2026: Added initM2Diagnostics and m2EngSnapshot
  *
  */
 /* INDENT ON */
@@ -43,8 +44,14 @@
 #include <genSubRecord.h>
 #endif
 
+#include "control.h"            /* For m2EngData */
+
 /* Public functions */
 
+long initM2Diagnostics(struct genSubRecord* pgsub);
+
+long m2EngSnapshot(m2EngData *eng);
+
 long readM2Diagnostics(struct genSubRecord* pgsub);
 
 long gensubFanDoubles(struct genSubRecord* pgsub);
@@ -53,4 +60,8 @@ long issueM2Primitive(struct cadRecord* pcad);
 
 long fillDiagnostics(double seed);
 
+/* Global variables */
+
+extern double m2EngMaxAge;
+
 #endif
@@ -0,0 +1,879 @@
+/* ===================================================================== */
+/* INDENT OFF */
+/*+
+ *
+ * FILENAME
+ * --------
+ * telemetry.c
+ *
+ * PURPOSE
+ * -------
+ * Continuous recorder of the guide loop. processGuides hands one
+ * telemetrySample per pass to telemetryPush, which copies it into a single
+ * producer / single consumer ring without taking a lock. A low priority
+ * writer thread empties the ring into chunks of binary records appended to
+ * files under a chosen directory. A file is closed once it reaches
+ * telemetryFileBytes and a new one started, and only the newest
+ * telemetryFiles files are kept.
+ *
+ * The files describe themselves: the header lists the name, type and
+ * offset of every field of a record, so telemetryToCsv can convert files
+ * written by either the MK or the standard build.
+ *
+ * If the writer falls behind and the ring fills, samples are dropped and
+ * counted rather than making processGuides wait; the count is written in
+ * the next chunk. A chunk that cannot be written is counted as lost and
+ * the writer carries on with the next one.
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ * telemetryInit   - create the ring
+ * telemetryPush   - add a sample to the ring, called by processGuides
+ * telemetryStart  - start the writer thread in a directory
+ * telemetryStop   - stop the writer thread and close the file
+ * telemetryShow   - print the state of the recorder
+ * telemetryToCsv  - convert a telemetry file to comma separated values
+ * telemetryFieldFind  - field of telemetrySample with a given name
+ * telemetryFieldValue - value of a field as a double
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ * Files are written in the byte order of the IOC and checksummed in IOC
+ * longs, so they are converted with telemetryToCsv on the IOC, or on a
+ * host of the same word size and byte order.
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ *
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Added telemetryFieldFind and telemetryFieldValue for the
+ *              column view of the guide ring buffer
+ * 17-Oct-2026: telemetryStart refuses to start a second writer while one
+ *              is still finishing, chunks that cannot be written are
+ *              counted as lost and logged at most every
+ *              TELEMETRY_LOG_INTERVAL
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>         /* For offsetof */
+
+#include <epicsAtomic.h>    /* For epicsAtomicGetIntT */
+#include <timeLib.h>        /* For timeNow */
+
+#include "telemetry.h"
+#include "utilities.h"      /* For OK, ERROR, errorLog, checkSumFast,
+                               monotonicNow */
+
+#define TELEMETRY_RING_SIZE   4096      /* 20s at 200Hz, power of two     */
+#define TELEMETRY_RING_MASK   (TELEMETRY_RING_SIZE - 1)
+#define TELEMETRY_CHUNK_SIZE  200       /* records per chunk, about 1s    */
+#define TELEMETRY_WAKE_EVERY  64        /* samples between writer wakeups */
+#define TELEMETRY_PATH_SIZE   128
+#define TELEMETRY_LOG_INTERVAL 10.0     /* seconds between write errors   */
+
+#define TELEMETRY_FIELD(name, type) \
+   { #name, type, offsetof (telemetrySample, name) }
+
+static const telemetryField fieldTable[] =
+{
+   TELEMETRY_FIELD (sequence, TELEMETRY_UINT32),
+   TELEMETRY_FIELD (time, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (p2Time, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (p2Interval, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (xRaw, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (yRaw, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (zRaw, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (xBeforePID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (yBeforePID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (zBeforePID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (xAfterPID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (yAfterPID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (zAfterPID, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (xDemand, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (yDemand, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (zDemand, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (beam, TELEMETRY_INT32),
+   TELEMETRY_FIELD (applyGuide, TELEMETRY_INT32),
+   TELEMETRY_FIELD (guideOnA, TELEMETRY_INT32),
+   TELEMETRY_FIELD (inPosition, TELEMETRY_INT32),
+   TELEMETRY_FIELD (axDemand, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (ayDemand, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (bxDemand, TELEMETRY_FLOAT),
+   TELEMETRY_FIELD (byDemand, TELEMETRY_FLOAT),
+#ifdef MK
+   TELEMETRY_FIELD (vtkXCommand, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYCommand, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXPhaseOld, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXPhase, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYPhaseOld, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYPhase, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXFrequency, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYFrequency, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXFreqError, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYFreqError, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXDeltaPhase, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYDeltaPhase, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXIntegral0, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkXIntegral1, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYIntegral0, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (vtkYIntegral1, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (xPhasor, TELEMETRY_DOUBLE),
+   TELEMETRY_FIELD (yPhasor, TELEMETRY_DOUBLE),
+#endif
+};
+
+#define TELEMETRY_FIELDS (sizeof (fieldTable) / sizeof (fieldTable[0]))
+
+int telemetryOn = FALSE;                 /* TRUE while the writer runs     */
+long telemetryFileBytes = 32000000;      /* about 1h at 200Hz              */
+int telemetryFiles = 16;                 /* files kept in the directory    */
+
+/* Ring shared by processGuides (head) and the writer (tail). The counters
+ * run freely and are reduced modulo the ring size when used. */
+
+static telemetrySample *ring = NULL;
+static int ringHead = 0;
+static int ringTail = 0;
+static int ringDropped = 0;
+static epicsUInt32 sampleSequence = 0;
+
+static epicsEventId telemetryWake = NULL;
+static epicsEventId telemetryDone = NULL;
+static volatile int stopRequest = FALSE;
+static int writerRunning = FALSE;       /* until telemetryDone is taken   */
+
+/* Writer state, only touched by the writer thread */
+
+static char directoryName[TELEMETRY_PATH_SIZE];
+static char fileName[TELEMETRY_PATH_SIZE];
+static FILE *file = NULL;
+static long fileBytes = 0;
+static int fileIndex = 0;
+static int fileStart = 0;
+static unsigned long recordsWritten = 0;
+static unsigned long chunksWritten = 0;
+static unsigned long droppedWritten = 0;
+static unsigned long chunksLost = 0;
+static unsigned long recordsLost = 0;
+static telemetrySample chunk[TELEMETRY_CHUNK_SIZE];
+static double lastErrorLog = 0.0;
+static unsigned long errorsSuppressed = 0;
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryInit
+ *
+ * Purpose:
+ * Create the sample ring and the events of the writer thread. Called once
+ * by initRefMem; the writer is started later by telemetryStart.
+ *
+ * Invocation:
+ * status = telemetryInit()
+ *
+ * Return value:
+ *              < status  int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int telemetryInit (void)
+{
+   if (ring != NULL)
+      return (OK);
+
+   ring = (telemetrySample *) calloc (TELEMETRY_RING_SIZE,
+         sizeof (telemetrySample));
+   telemetryWake = epicsEventCreate (epicsEventEmpty);
+   telemetryDone = epicsEventCreate (epicsEventEmpty);
+
+   if (ring == NULL || telemetryWake == NULL || telemetryDone == NULL)
+   {
+      errorLog ("telemetryInit - cannot create the sample ring", 1, ON);
+      return (ERROR);
+   }
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryPush
+ *
+ * Purpose:
+ * Copy a sample into the ring and publish it to the writer. Never blocks:
+ * if the ring is full the sample is counted as dropped.
+ *
+ * Invocation:
+ * status = telemetryPush(&sample)
+ *
+ * Parameters in:
+ *              > sample  telemetrySample*   sample of this pass, its
+ *                                           sequence is filled in here
+ *
+ * Return value:
+ *              < status  int    OK, or ERROR if the sample was dropped or
+ *                               the recorder is not running
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int telemetryPush (telemetrySample *sample)
+{
+   unsigned head, tail;
+
+   if (!telemetryOn || ring == NULL)
+      return (ERROR);
+
+   sample->sequence = sampleSequence++;
+
+   head = (unsigned) ringHead;
+   tail = (unsigned) epicsAtomicGetIntT (&ringTail);
+
+   if (head - tail >= TELEMETRY_RING_SIZE)
+   {
+      epicsAtomicIncrIntT (&ringDropped);
+      return (ERROR);
+   }
+
+   ring[head & TELEMETRY_RING_MASK] = *sample;
+
+   /* the record must be complete before the writer can see it */
+   epicsAtomicWriteMemoryBarrier ();
+   epicsAtomicSetIntT (&ringHead, (int) (head + 1));
+
+   if (((head + 1) % TELEMETRY_WAKE_EVERY) == 0)
+      epicsEventSignal (telemetryWake);
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryError
+ *
+ * Purpose:
+ * Writer side. Log a file error, at most once every
+ * TELEMETRY_LOG_INTERVAL seconds, with the number of errors not logged
+ * since the last one, so a full or missing disk does not flood the log.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void telemetryError (char *message)
+{
+   char text[160];
+   double now = monotonicNow ();
+
+   if (lastErrorLog > 0.0 && now - lastErrorLog < TELEMETRY_LOG_INTERVAL)
+   {
+      errorsSuppressed++;
+      return;
+   }
+
+   if (errorsSuppressed > 0)
+   {
+      sprintf (text, "%s (%lu more since last logged)", message,
+            errorsSuppressed);
+      errorLog (text, 1, ON);
+   }
+   else
+   {
+      errorLog (message, 1, ON);
+   }
+
+   lastErrorLog = now;
+   errorsSuppressed = 0;
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryOpen, telemetryWrite
+ *
+ * Purpose:
+ * Writer side. telemetryOpen starts the next file of the directory,
+ * deleting the oldest one kept, and writes the header and field table.
+ * telemetryWrite appends one chunk, starting a new file first when the
+ * current one is full.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static int telemetryOpen (void)
+{
+   telemetryFileHeader header;
+   double now;
+   char oldName[TELEMETRY_PATH_SIZE];
+
+   if (file != NULL)
+   {
+      fclose (file);
+      file = NULL;
+   }
+
+   if (timeNow (&now) != OK)
+      now = 0.0;
+
+   if (fileIndex >= telemetryFiles)
+   {
+      sprintf (oldName, "%s/telemetry-%d-%04d.tlm", directoryName,
+            fileStart, fileIndex - telemetryFiles);
+      remove (oldName);
+   }
+
+   sprintf (fileName, "%s/telemetry-%d-%04d.tlm", directoryName,
+         fileStart, fileIndex);
+   fileIndex++;
+
+   if ((file = fopen (fileName, "wb")) == NULL)
+   {
+      telemetryError ("telemetryOpen - cannot open telemetry file");
+      return (ERROR);
+   }
+
+   memset (&header, 0, sizeof (header));
+   memcpy (header.magic, TELEMETRY_MAGIC, sizeof (header.magic));
+   header.version = TELEMETRY_VERSION;
+   header.recordSize = sizeof (telemetrySample);
+   header.fieldCount = TELEMETRY_FIELDS;
+   header.startTime = now;
+
+   if (fwrite (&header, sizeof (header), 1, file) != 1 ||
+         fwrite (fieldTable, sizeof (fieldTable), 1, file) != 1)
+   {
+      telemetryError ("telemetryOpen - cannot write telemetry file header");
+      fclose (file);
+      file = NULL;
+      return (ERROR);
+   }
+
+   fileBytes = sizeof (header) + sizeof (fieldTable);
+
+   return (OK);
+}
+
+static int telemetryWrite (int count, int dropped)
+{
+   telemetryChunk head;
+   size_t bytes = count * sizeof (telemetrySample);
+
+   if (file == NULL || fileBytes + (long) bytes > telemetryFileBytes)
+   {
+      if (telemetryOpen () != OK)
+         return (ERROR);
+   }
+
+   head.magic = TELEMETRY_CHUNK_MAGIC;
+   head.count = count;
+   head.dropped = dropped;
+   head.checkSum = checkSumFast ((void *) chunk, bytes / sizeof (long));
+
+   if (fwrite (&head, sizeof (head), 1, file) != 1 ||
+         fwrite (chunk, bytes, 1, file) != 1)
+   {
+      telemetryError ("telemetryWrite - error writing telemetry file");
+      fclose (file);
+      file = NULL;
+      return (ERROR);
+   }
+
+   fflush (file);
+
+   fileBytes += sizeof (head) + bytes;
+   recordsWritten += count;
+   droppedWritten += dropped;
+   chunksWritten++;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryDrain
+ *
+ * Purpose:
+ * Move everything in the ring to the file, one chunk at a time. A chunk
+ * that cannot be written is counted as lost, with the samples dropped
+ * before it, and the ring moves on so that processGuides is not held up.
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Count the chunks that could not be written
+ *
+ */
+/* ===================================================================== */
+
+static void telemetryDrain (void)
+{
+   unsigned head, tail, count, i;
+   int dropped;
+
+   for (;;)
+   {
+      tail = (unsigned) ringTail;
+      head = (unsigned) epicsAtomicGetIntT (&ringHead);
+      epicsAtomicReadMemoryBarrier ();
+
+      count = head - tail;
+      if (count == 0)
+         return;
+      if (count > TELEMETRY_CHUNK_SIZE)
+         count = TELEMETRY_CHUNK_SIZE;
+
+      for (i = 0; i < count; i++)
+         chunk[i] = ring[(tail + i) & TELEMETRY_RING_MASK];
+
+      /* the slots may be reused once the tail has moved */
+      epicsAtomicSetIntT (&ringTail, (int) (tail + count));
+
+      dropped = epicsAtomicGetIntT (&ringDropped);
+      if (dropped != 0)
+         epicsAtomicAddIntT (&ringDropped, -dropped);
+
+      if (telemetryWrite ((int) count, dropped) != OK)
+      {
+         chunksLost++;
+         recordsLost += count + (unsigned) dropped;
+      }
+   }
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryWriter
+ *
+ * Purpose:
+ * Writer thread, woken by telemetryPush every TELEMETRY_WAKE_EVERY
+ * samples or twice a second, whichever comes first
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+static void telemetryWriter (void *arg)
+{
+   while (!stopRequest)
+   {
+      epicsEventWaitWithTimeout (telemetryWake, 0.5);
+      telemetryDrain ();
+   }
+
+   telemetryDrain ();
+
+   if (file != NULL)
+   {
+      fclose (file);
+      file = NULL;
+   }
+
+   epicsEventSignal (telemetryDone);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryStart
+ *
+ * Purpose:
+ * Start recording into a directory. Files are named
+ * telemetry-<start time>-<index>.tlm. Refused while the writer of the
+ * last run has not finished, as the ring has a single consumer.
+ *
+ * Invocation:
+ * status = telemetryStart(directory)
+ *
+ * Parameters in:
+ *              > directory  char*  directory for the files, "." if NULL
+ *
+ * Return value:
+ *              < status     int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int telemetryStart (char *directory)
+{
+   double now;
+
+   if (telemetryOn)
+   {
+      printf ("telemetry already recording in %s\n", directoryName);
+      return (ERROR);
+   }
+
+   /* a writer telemetryStop gave up waiting for may still be running */
+   if (writerRunning)
+   {
+      if (epicsEventTryWait (telemetryDone) != epicsEventWaitOK)
+      {
+         printf ("telemetry writer of the last run has not finished\n");
+         return (ERROR);
+      }
+      writerRunning = FALSE;
+   }
+
+   if (telemetryInit () != OK)
+      return (ERROR);
+
+   if (directory == NULL || directory[0] == '\0')
+      directory = ".";
+
+   strncpy (directoryName, directory, sizeof (directoryName) - 1);
+   directoryName[sizeof (directoryName) - 1] = '\0';
+
+   if (timeNow (&now) != OK)
+      now = 0.0;
+
+   fileStart = (int) now;
+   fileIndex = 0;
+   fileBytes = 0;
+   recordsWritten = 0;
+   chunksWritten = 0;
+   droppedWritten = 0;
+   chunksLost = 0;
+   recordsLost = 0;
+   lastErrorLog = 0.0;
+   errorsSuppressed = 0;
+
+   /* empty the ring of anything left from a previous run */
+   epicsAtomicSetIntT (&ringTail, epicsAtomicGetIntT (&ringHead));
+   epicsAtomicSetIntT (&ringDropped, 0);
+
+   stopRequest = FALSE;
+
+   if (!epicsThreadCreate ("tTelemetry", epicsThreadPriorityLow,
+            epicsThreadGetStackSize (epicsThreadStackMedium),
+            (EPICSTHREADFUNC) telemetryWriter, (void *) NULL))
+   {
+      errorLog ("telemetryStart - cannot spawn the writer", 1, ON);
+      return (ERROR);
+   }
+
+   writerRunning = TRUE;
+   telemetryOn = TRUE;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryStop
+ *
+ * Purpose:
+ * Stop taking samples, write what is left in the ring and close the file
+ *
+ * Invocation:
+ * status = telemetryStop()
+ *
+ * Return value:
+ *              < status  int    OK, or ERROR if the writer did not finish
+ *                               in 5s, in which case telemetryStart is
+ *                               refused until it has
+ *
+ * History:
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Writer left running after a timeout is tracked
+ *
+ */
+/* ===================================================================== */
+
+int telemetryStop (void)
+{
+   if (!telemetryOn)
+      return (OK);
+
+   telemetryOn = FALSE;
+   stopRequest = TRUE;
+   epicsEventSignal (telemetryWake);
+
+   if (epicsEventWaitWithTimeout (telemetryDone, 5.0) != epicsEventWaitOK)
+   {
+      errorLog ("telemetryStop - writer did not finish", 1, ON);
+      return (ERROR);
+   }
+
+   writerRunning = FALSE;
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryShow
+ *
+ * Purpose:
+ * Print the state of the recorder
+ *
+ * Invocation:
+ * status = telemetryShow()
+ *
+ * Return value:
+ *              < status  int    OK
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int telemetryShow (void)
+{
+   unsigned depth;
+
+   depth = (unsigned) epicsAtomicGetIntT (&ringHead) -
+      (unsigned) epicsAtomicGetIntT (&ringTail);
+
+   printf ("telemetry %s, %d fields, %d bytes per record\n",
+         telemetryOn ? "recording" :
+         (writerRunning ? "stopping" : "stopped"), (int) TELEMETRY_FIELDS,
+         (int) sizeof (telemetrySample));
+   printf ("file       %s (%ld bytes)\n",
+         (file != NULL) ? fileName : "none", fileBytes);
+   printf ("ring       %u of %d\n", depth, TELEMETRY_RING_SIZE);
+   printf ("records    %lu in %lu chunks\n", recordsWritten, chunksWritten);
+   printf ("dropped    %lu\n",
+         droppedWritten + (unsigned long) epicsAtomicGetIntT (&ringDropped));
+   printf ("lost       %lu records in %lu chunks not written\n",
+         recordsLost, chunksLost);
+
+   return (OK);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryToCsv
+ *
+ * Purpose:
+ * Convert a telemetry file to comma separated values, one line per record
+ * with a first line of field names. Fields are taken from the table in
+ * the file, not from this build. A chunk with a bad checksum is skipped
+ * and a chunk cut short ends the conversion.
+ *
+ * Invocation:
+ * status = telemetryToCsv(inName, outName)
+ *
+ * Parameters in:
+ *              > inName   char*  telemetry file
+ *              > outName  char*  CSV file to write
+ *
+ * Return value:
+ *              < status   int    OK or ERROR
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+int telemetryToCsv (char *inName, char *outName)
+{
+   telemetryFileHeader header;
+   telemetryChunk head;
+   telemetryField *fields = NULL;
+   char *records = NULL;
+   FILE *in, *out;
+   unsigned long lines = 0, skipped = 0, dropped = 0;
+   unsigned i, j;
+   char *value;
+   int status = ERROR;
+
+   if ((in = fopen (inName, "rb")) == NULL)
+   {
+      printf ("telemetryToCsv - cannot open %s\n", inName);
+      return (ERROR);
+   }
+
+   if ((out = fopen (outName, "w")) == NULL)
+   {
+      printf ("telemetryToCsv - cannot create %s\n", outName);
+      fclose (in);
+      return (ERROR);
+   }
+
+   if (fread (&header, sizeof (header), 1, in) != 1 ||
+         memcmp (header.magic, TELEMETRY_MAGIC, sizeof (header.magic)) != 0 ||
+         header.version != TELEMETRY_VERSION ||
+         header.recordSize == 0 || header.fieldCount == 0)
+   {
+      printf ("telemetryToCsv - %s is not a telemetry file\n", inName);
+      goto done;
+   }
+
+   fields = (telemetryField *) malloc (header.fieldCount *
+         sizeof (telemetryField));
+   records = (char *) malloc (header.recordSize * TELEMETRY_CHUNK_SIZE);
+
+   if (fields == NULL || records == NULL ||
+         fread (fields, sizeof (telemetryField), header.fieldCount, in) !=
+         header.fieldCount)
+   {
+      printf ("telemetryToCsv - cannot read the field table\n");
+      goto done;
+   }
+
+   for (j = 0; j < header.fieldCount; j++)
+   {
+      fields[j].name[TELEMETRY_NAME_SIZE - 1] = '\0';
+      fprintf (out, "%s%s", (j == 0) ? "" : ",", fields[j].name);
+   }
+   fprintf (out, "\n");
+
+   while (fread (&head, sizeof (head), 1, in) == 1)
+   {
+      if (head.magic != TELEMETRY_CHUNK_MAGIC ||
+            head.count > TELEMETRY_CHUNK_SIZE)
+      {
+         printf ("telemetryToCsv - bad chunk after %lu records\n", lines);
+         break;
+      }
+
+      if (fread (records, header.recordSize, head.count, in) != head.count)
+         break;
+
+      dropped += head.dropped;
+
+      if ((epicsUInt32) checkSumFast ((void *) records,
+               head.count * header.recordSize / sizeof (long)) !=
+            head.checkSum)
+      {
+         skipped += head.count;
+         continue;
+      }
+
+      for (i = 0; i < head.count; i++)
+      {
+         for (j = 0; j < header.fieldCount; j++)
+         {
+            value = records + i * header.recordSize + fields[j].offset;
+
+            if (j != 0)
+               fputc (',', out);
+
+            switch (fields[j].type)
+            {
+               case TELEMETRY_DOUBLE:
+                  fprintf (out, "%.9g", *(double *) value);
+                  break;
+               case TELEMETRY_FLOAT:
+                  fprintf (out, "%.7g", *(float *) value);
+                  break;
+               case TELEMETRY_INT32:
+                  fprintf (out, "%d", (int) *(epicsInt32 *) value);
+                  break;
+               case TELEMETRY_UINT32:
+                  fprintf (out, "%u", (unsigned) *(epicsUInt32 *) value);
+                  break;
+               default:
+                  break;
+            }
+         }
+         fputc ('\n', out);
+         lines++;
+      }
+   }
+
+   printf ("%lu records written to %s, %lu bad, %lu dropped when recorded\n",
+         lines, outName, skipped, dropped);
+   status = OK;
+
+done:
+   free (fields);
+   free (records);
+   fclose (in);
+   fclose (out);
+
+   return (status);
+}
+
+/* ===================================================================== */
+/*
+ * Function name:
+ * telemetryFieldFind, telemetryFieldValue
+ *
+ * Purpose:
+ * Look up a field of telemetrySample by name, and read a field of a
+ * record as a double whatever its type. Used for column views of
+ * telemetrySample records, such as cbColumn.
+ *
+ * Invocation:
+ * field = telemetryFieldFind(name)
+ * value = telemetryFieldValue(field, (char *) record + field->offset)
+ *
+ * Return value:
+ *              < field   telemetryField*   NULL if there is no such field
+ *              < value   double
+ *
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+/* ===================================================================== */
+
+const telemetryField *telemetryFieldFind (const char *name)
+{
+   unsigned j;
+
+   if (name == NULL)
+      return (NULL);
+
+   for (j = 0; j < TELEMETRY_FIELDS; j++)
+   {
+      if (strcmp (fieldTable[j].name, name) == 0)
+         return (&fieldTable[j]);
+   }
+
+   return (NULL);
+}
+
+double telemetryFieldValue (const telemetryField *field, const void *value)
+{
+   switch (field->type)
+   {
+      case TELEMETRY_DOUBLE:
+         return (*(const double *) value);
+      case TELEMETRY_FLOAT:
+         return ((double) *(const float *) value);
+      case TELEMETRY_INT32:
+         return ((double) *(const epicsInt32 *) value);
+      case TELEMETRY_UINT32:
+         return ((double) *(const epicsUInt32 *) value);
+      default:
+         return (0.0);
+   }
+}
@@ -0,0 +1,156 @@
+/*+
+ *
+ * FILENAME
+ * --------
+ * telemetry.h
+ *
+ * PURPOSE
+ * -------
+ * Header file defines the public interface for telemetry.c and the layout
+ * of the telemetry files
+ *
+ * FUNCTION NAME(S)
+ * ----------------
+ *
+ * DEPENDENCIES
+ * ------------
+ *
+ * LIMITATIONS
+ * -----------
+ *
+ * AUTHOR
+ * ------
+ *
+ * HISTORY
+ * -------
+ * 17-Oct-2026: Original
+ * 17-Oct-2026: Added telemetryFieldFind and telemetryFieldValue
+ *
+ */
+/* ===================================================================== */
+#ifndef _INCLUDED_TELEMETRY_H
+#define _INCLUDED_TELEMETRY_H
+
+#include <epicsTypes.h>
+
+/* One pass of processGuides. Doubles first, then floats, then integers,
+ * so that the record has no internal padding. */
+
+typedef struct
+{
+        double       time;              /* timeNow at the end of the pass */
+        double       p2Time;            /* pwfs2.time                     */
+        double       xBeforePID;        /* net guide before PID           */
+        double       yBeforePID;
+        double       zBeforePID;
+        double       xAfterPID;         /* net guide after PID            */
+        double       yAfterPID;
+        double       zAfterPID;
+        double       xDemand;           /* guide demand sent to M2        */
+        double       yDemand;
+        double       zDemand;
+#ifdef MK
+        double       vtkXCommand;
+        double       vtkYCommand;
+        double       vtkXPhaseOld;
+        double       vtkXPhase;
+        double       vtkYPhaseOld;
+        double       vtkYPhase;
+        double       vtkXFrequency;
+        double       vtkYFrequency;
+        double       vtkXFreqError;
+        double       vtkYFreqError;
+        double       vtkXDeltaPhase;
+        double       vtkYDeltaPhase;
+        double       vtkXIntegral0;
+        double       vtkXIntegral1;
+        double       vtkYIntegral0;
+        double       vtkYIntegral1;
+        double       xPhasor;
+        double       yPhasor;
+#endif
+        float        p2Interval;        /* pwfs2.interval                 */
+        float        xRaw;              /* pwfs2.z1 .. z3                 */
+        float        yRaw;
+        float        zRaw;
+        float        axDemand;          /* page 0 AxTilt .. ByTilt        */
+        float        ayDemand;
+        float        bxDemand;
+        float        byDemand;
+        epicsInt32   beam;              /* currentBeam                    */
+        epicsInt32   applyGuide;
+        epicsInt32   guideOnA;
+        epicsInt32   inPosition;
+        epicsUInt32  sequence;          /* set by telemetryPush           */
+        epicsUInt32  spare;
+} telemetrySample;
+
+/* File layout. A file starts with a telemetryFileHeader followed by
+ * fieldCount telemetryField descriptors, then any number of chunks. Each
+ * chunk is a telemetryChunk followed by count records of recordSize bytes.
+ * Files are only appended to, so a chunk cut short by a reboot is simply
+ * the end of the file. All values are in the byte order of the IOC. */
+
+#define TELEMETRY_MAGIC        "SCSTLM01"
+#define TELEMETRY_VERSION      1
+#define TELEMETRY_CHUNK_MAGIC  0x4b4e4843       /* "CHNK" */
+#define TELEMETRY_NAME_SIZE    24
+
+enum
+{
+        TELEMETRY_DOUBLE = 1,
+        TELEMETRY_FLOAT,
+        TELEMETRY_INT32,
+        TELEMETRY_UINT32
+};
+
+typedef struct
+{
+        char         magic[8];          /* TELEMETRY_MAGIC, no terminator */
+        epicsUInt32  version;
+        epicsUInt32  recordSize;        /* bytes per record               */
+        epicsUInt32  fieldCount;
+        epicsUInt32  spare;
+        double       startTime;         /* timeNow when the file was made */
+} telemetryFileHeader;
+
+typedef struct
+{
+        char         name[TELEMETRY_NAME_SIZE];
+        epicsUInt32  type;              /* TELEMETRY_DOUBLE ..            */
+        epicsUInt32  offset;            /* byte offset in the record      */
+} telemetryField;
+
+typedef struct
+{
+        epicsUInt32  magic;             /* TELEMETRY_CHUNK_MAGIC          */
+        epicsUInt32  count;             /* records in the chunk           */
+        epicsUInt32  dropped;           /* samples lost to a full ring    */
+        epicsUInt32  checkSum;          /* checkSumFast of the records    */
+} telemetryChunk;
+
+/* Public functions */
+
+int telemetryInit (void);
+
+int telemetryPush (telemetrySample *sample);
+
+int telemetryStart (char *directory);
+
+int telemetryStop (void);
+
+int telemetryShow (void);
+
+int telemetryToCsv (char *inName, char *outName);
+
+const telemetryField *telemetryFieldFind (const char *name);
+
+double telemetryFieldValue (const telemetryField *field, const void *value);
+
+/* Global variables */
+
+extern int telemetryOn;
+extern long telemetryFileBytes;
+extern int telemetryFiles;
+
+#endif
@@ -27,6 +27,7 @@
  * driveP1      - Simulate P1 guiding
  * driveP2      - Simulate P2 guiding
  * checkSafeBlock
+ * checkSumBench - time checkSum against checkSumFast and checkSumSet
  * checkFiltered
  * fillWfs
  *
@@ -51,6 +52,7 @@
  * 07-May-1999: Added RCS id
  * 07-Dec-1999: Added testm22tcs, testtcs2m2 routines
  * 15-Dec-1999: Added printPage[0-2,7-13] routines
+ * 17-Oct-2026: Added checkSumBench
  *
  */
 /* INDENT ON */
@@ -385,6 +387,96 @@ void checkSafeBlock(int count)
   printf(" for %d longs checksum = %ld = %lx\n", count, result, result);
 }
 
+/* ===================================================================== */
+/*
+ * checkSumBench - time checkSum against checkSumFast over the command and
+ * status blocks, and against the incremental setters for the fields
+ * processGuides writes each frame. Results are checked to agree.
+ */
+/* ===================================================================== */
+void checkSumBench(int loops)
+{
+  static commandBlock block;
+  volatile long sink = 0;
+  long *words = (long *)&block.NS;
+  long sum, reference;
+  double start, tSlow, tFast, tStatus, tStatusFast, tFull, tSet;
+  int i, n;
+
+  if (loops <= 0)
+    loops = 100000;
+
+  for (n = 0; n < COMMAND_BLOCK_SIZE; n++)
+    words[n] = (long)rand() * 65599L + n;
+
+  reference = checkSum((void *)words, COMMAND_BLOCK_SIZE);
+  if (checkSumFast(words, COMMAND_BLOCK_SIZE) != reference ||
+      checkSumFast(words, STATUS_BLOCK_SIZE) != 
+      checkSum((void *)words, STATUS_BLOCK_SIZE))
+  {
+    printf("checkSumFast does not agree with checkSum\n");
+    return;
+  }
+
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+    sink += checkSum((void *)words, COMMAND_BLOCK_SIZE);
+  tSlow = monotonicNow() - start;
+
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+    sink += checkSumFast(words, COMMAND_BLOCK_SIZE);
+  tFast = monotonicNow() - start;
+
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+    sink += checkSum((void *)words, STATUS_BLOCK_SIZE);
+  tStatus = monotonicNow() - start;
+
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+    sink += checkSumFast(words, STATUS_BLOCK_SIZE);
+  tStatusFast = monotonicNow() - start;
+
+  /* one guide frame: write the guide fields, NS and heartbeat, then sum */
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+  {
+    block.xTiltGuide = (float)i;
+    block.yTiltGuide = (float)-i;
+    block.zFocusGuide = (float)(i / 2);
+    block.NS = i;
+    block.heartbeat = -i;
+    sink += checkSum((void *)&block.NS, COMMAND_BLOCK_SIZE);
+  }
+  tFull = monotonicNow() - start;
+
+  sum = checkSum((void *)&block.NS, COMMAND_BLOCK_SIZE);
+  start = monotonicNow();
+  for (i = 0; i < loops; i++)
+  {
+    checkSumSetFloat(&sum, &block.xTiltGuide, (float)i);
+    checkSumSetFloat(&sum, &block.yTiltGuide, (float)-i);
+    checkSumSetFloat(&sum, &block.zFocusGuide, (float)(i / 2));
+    checkSumSetLong(&sum, &block.NS, i);
+    checkSumSetLong(&sum, &block.heartbeat, -i);
+  }
+  tSet = monotonicNow() - start;
+  sink += sum;
+
+  printf("%d loops, ns per call\n", loops);
+  printf("command block (%d longs): checkSum %8.1f  checkSumFast %8.1f\n",
+         COMMAND_BLOCK_SIZE, 1.0e9 * tSlow / loops, 1.0e9 * tFast / loops);
+  printf("status block  (%d longs): checkSum %8.1f  checkSumFast %8.1f\n",
+         STATUS_BLOCK_SIZE, 1.0e9 * tStatus / loops, 
+         1.0e9 * tStatusFast / loops);
+  printf("guide frame: write and checkSum %8.1f  checkSumSet %8.1f\n",
+         1.0e9 * tFull / loops, 1.0e9 * tSet / loops);
+  printf("incremental sum %s\n", 
+         sum == checkSum((void *)&block.NS, COMMAND_BLOCK_SIZE) ? 
+         "agrees" : "DOES NOT AGREE");
+}
+
 void    tiltState (const memMap *buffPtr)
 {
     printf ("__________________________________________________________\n");
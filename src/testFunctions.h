@@ -26,6 +26,7 @@
  * HISTORY
  * -------
  * 17-Nov-1999: Created new header files. KG
+ * 17-Oct-2026: Added checkSumBench
  *
  */
 /* INDENT ON */
@@ -54,6 +55,8 @@
 
 void checkSafeBlock(int count);
 
+void checkSumBench(int loops);
+
 void tiltState(const memMap* buffPtr);
 
 void big(void);
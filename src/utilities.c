@@ -16,6 +16,8 @@
  * act2tilt - conversion actuator space to tilt space
  * tilt2act - conversion tilt space to actuator space
  * checkSum - checksum over specified block
+ * checkSumFast - checkSum with four partial sums
+ * checkSumSet  - write a field and adjust the checksum of its block
  * weight2string- convert guide weighting to string
  * errorLog - write error information to file and screen
  * tcs2m2   - convert tip,tilt,focus,xPos,yPos from TCS coords to M2
@@ -28,6 +30,11 @@
  * scsStateStringInit
  * snlStateInit
  * snlStateMonitor
+ * modifyFrame  - update a conversion frame
+ * readFrame    - copy a conversion frame without locking
+ * frameOfReferenceChanged - note that frame has been written
+ * monotonicNow - seconds from the monotonic clock
+ * showFrame    - print a conversion frame
  * 
  * DEPENDENCIES
  * ------------
@@ -48,6 +55,10 @@
  * 25-Feb-1998: remove all references to moveCurve
  * 23-Jun-1998: Add functions to read and report health, remove setHealth
  * 10-May-1999: Added RCS id
+ * 17-Oct-2026: Conversion frames read without locking, add readFrame
+ * 17-Oct-2026: Add frameOfReferenceChanged
+ * 17-Oct-2026: Add monotonicNow
+ * 17-Oct-2026: Add checkSumFast and the incremental checkSumSet setters
  */
 /* INDENT ON */
 /* ===================================================================== */
@@ -67,8 +78,9 @@
 #include <stdlib.h>         /* For atoi */
 #include <string.h>
 #include <math.h>           /* For sin, cos */
-#include <time.h>           /* For date2secs */
+#include <time.h>           /* For date2secs, clock_gettime */
 #include <timeLib.h>        /* For timeNow */
+#include <epicsAtomic.h>     /* For readFrame, modifyFrame */
 
 #define SCSTOP "top = m2:"
 #define INSTTOP "I = m2:inst:"
@@ -104,6 +116,7 @@ frameOfReference frame =
     0.0, 0.0, 0.0, 0.0,
     0.0, 0.0, 0.0, 0.0, 0.0
 };
+int frameRevision = 0;      /* bumped by frameOfReferenceChanged */
 long cadProcessorSnlState;  /* Initialize these states? */
 long followDemandSnlState;
 long monitorSadSnlState;
@@ -630,6 +643,159 @@ long    checkSum (void *ptr, int numLongs)
     return (sum);
 }
 
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * checkSumFast
+ * 
+ * Purpose:
+ * Same sum as checkSum, accumulated in four independent partial sums so
+ * that the adds do not wait on each other and the compiler may use
+ * vector adds. The sums are unsigned so that they wrap exactly as the
+ * long sum of checkSum does.
+ *
+ * Invocation:
+ * value = checkSumFast(*start, numLongs)
+ *
+ * Parameters in:
+ *      > start     *void   start address
+ *      > numLongs  int number of long words to sum
+ * 
+ * Parameters out:
+ * None
+ * 
+ * Return value:
+ *      < value     long    sum
+ *
+ * Globals: 
+ *  External functions:
+ *  None
+ * 
+ *  External variables:
+ *  None
+ * 
+ * Requirements:
+ * 
+ * Author:
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+long    checkSumFast (const void *ptr, int numLongs)
+{
+    const unsigned long *p = (const unsigned long *) ptr;
+    unsigned long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int     n;
+
+    for (n = 0; n + 4 <= numLongs; n += 4)
+    {
+        s0 += p[n];
+        s1 += p[n + 1];
+        s2 += p[n + 2];
+        s3 += p[n + 3];
+    }
+
+    for (; n < numLongs; n++)
+    {
+        s0 += p[n];
+    }
+
+    return ((long) ((s0 + s1) + (s2 + s3)));
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * checkSumSet
+ * checkSumSetLong
+ * checkSumSetFloat
+ * 
+ * Purpose:
+ * Write a field of a checksummed block and adjust the block's checksum
+ * by the change in the long words holding the field, so that the whole
+ * block need not be summed again. Only valid if every write to the
+ * block goes through these functions; the caller must hold whatever lock
+ * protects the block.
+ *
+ * Invocation:
+ * checkSumSet(&sum, &block.field, &value, sizeof (value))
+ * checkSumSetLong(&sum, &block.longField, value)
+ * checkSumSetFloat(&sum, &block.floatField, value)
+ *
+ * Parameters in:
+ *      > field     *void   field to write, inside the summed block
+ *      > value     *void   new contents of the field
+ *      > size      int     bytes in the field
+ * 
+ * Parameters in/out:
+ *      <> sum      *long   checksum of the block
+ * 
+ * Return value:
+ * None
+ *
+ * Globals: 
+ *  External functions:
+ *  None
+ * 
+ *  External variables:
+ *  None
+ * 
+ * Requirements:
+ * 
+ * Author:
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ * 
+ */
+
+/* INDENT ON */
+/* ===================================================================== */
+
+void    checkSumSet (long *sum, void *field, const void *value, int size)
+{
+    unsigned long *first, *last, *p;
+    unsigned long before = 0, after = 0;
+
+    if (size <= 0)
+        return;
+
+    /* the long words which hold the field */
+    first = (unsigned long *) ((unsigned long) field &
+                               ~(unsigned long) (sizeof (long) - 1));
+    last = (unsigned long *) (((unsigned long) field + size - 1) &
+                              ~(unsigned long) (sizeof (long) - 1));
+
+    for (p = first; p <= last; p++)
+        before += *p;
+
+    memcpy (field, value, size);
+
+    for (p = first; p <= last; p++)
+        after += *p;
+
+    *sum = (long) ((unsigned long) *sum + after - before);
+}
+
+void    checkSumSetLong (long *sum, long *field, long value)
+{
+    *sum = (long) ((unsigned long) *sum + (unsigned long) value -
+                   (unsigned long) *field);
+    *field = value;
+}
+
+void    checkSumSetFloat (long *sum, float *field, float value)
+{
+    checkSumSet (sum, (void *) field, (const void *) &value, sizeof (float));
+}
+
 /* ===================================================================== */
 /* INDENT OFF */
 /*
@@ -1185,6 +1351,38 @@ double confine (double value, double upper, double lower)
     return (value);
 }
 
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * monotonicNow
+ * 
+ * Purpose:
+ * Time from the monotonic clock, for measuring intervals and deadlines
+ * which must not jump when the wall clock is set
+ *
+ * Invocation:
+ * seconds = monotonicNow ()
+ *
+ * Return value:
+ *      < seconds   double  seconds since an arbitrary fixed point
+ * 
+ * History:
+ * 17-Oct-2026: Original, moved from control.c
+ *
+ */
+/* INDENT ON */
+/* ===================================================================== */
+
+double monotonicNow (void)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + 1.0e-9 * (double) now.tv_nsec;
+}
+
 /* ===================================================================== */
 /* INDENT OFF */
 /*
@@ -1433,6 +1631,12 @@ int setPid (int axis, double P, double I, double D, double windUpLimit,
  * History:
  * 20-Nov-1998: Original(srp)
  * 28-Nov-1998: Adapted for SCS usage(srp)
+ * 17-Oct-2026: Write the spare frame and publish it, readers no longer
+ *              take the mutex
+ * 17-Oct-2026: Wait for the writer mutex rather than try it, the try lock
+ *              test was inverted and the frame was only updated when the
+ *              lock was not obtained
+ * 17-Oct-2026: sin and cos taken of the angle in radians, not degrees
  *
  */
 
@@ -1451,6 +1655,9 @@ int  modifyFrame
     const double offsetY
     )
 {
+    frameData *spare;
+    int next;
+
     /* check that frame structure has been initialised */
 
     if (f == NULL)
@@ -1459,27 +1666,147 @@ int  modifyFrame
             return(ERROR);
     }
         
-    /* access frame */
+    /* serialise writers, readers use readFrame */
 
-    if(epicsMutexTryLock(f->access))
+    if(epicsMutexLock(f->access) != epicsMutexLockOK)
     {
-        /* update the structure */
-
-        f->theta    = theta*DEGS2RADS;
-        f->sinTheta = sin(theta);
-        f->cosTheta = cos(theta);
-        f->offsetX  = offsetX;
-        f->offsetY  = offsetY;
-        f->scaleX   = scaleX;
-        f->scaleY   = scaleY;
-        f->scaleZ   = scaleZ;
-
-        epicsMutexUnlock(f->access);
+        errlogMessage("modifyFrame - unable to get mutex for conversion frame\n");
+        return(ERROR);
     }
 
+    /* update the frame not in use */
+
+    next = 1 - epicsAtomicGetIntT(&f->current);
+    spare = &f->frame[next];
+
+    spare->theta    = theta*DEGS2RADS;
+    spare->sinTheta = sin(spare->theta);
+    spare->cosTheta = cos(spare->theta);
+    spare->offsetX  = offsetX;
+    spare->offsetY  = offsetY;
+    spare->scaleX   = scaleX;
+    spare->scaleY   = scaleY;
+    spare->scaleZ   = scaleZ;
+
+    /* publish it */
+
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetIntT(&f->current, next);
+    epicsAtomicIncrIntT(&f->sequence);
+
+    epicsMutexUnlock(f->access);
+
         return (OK);
 }
 
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * readFrame
+ * 
+ * Purpose:
+ * Take a consistent copy of the published conversion frame without
+ * waiting for modifyFrame. The copy is only repeated if modifyFrame
+ * completed an update while it was being taken, which it does rarely
+ * and never while holding up the reader.
+ *
+ * Invocation:
+ * readFrame (f, &grab)
+ *
+ * Parameters in:
+ *      > frameChange *f    pointer to conversion frame
+ *
+ * Parameters out:
+ *      < frameData *grab   copy of the published frame
+ * 
+ * Return value:
+ * None
+ *
+ * Globals: 
+ *  External functions:
+ *  None
+ * 
+ *  External variables:
+ * 
+ * Requirements:
+ * 
+ * 
+ * Author:
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+
+/* ===================================================================== */
+
+void readFrame (const frameChange *f, frameData *grab)
+{
+    int sequence;
+
+    do
+    {
+        sequence = epicsAtomicGetIntT(&f->sequence);
+        epicsAtomicReadMemoryBarrier();
+
+        *grab = f->frame[epicsAtomicGetIntT(&f->current)];
+
+        epicsAtomicReadMemoryBarrier();
+    } while (epicsAtomicGetIntT(&f->sequence) != sequence);
+}
+
+/* ===================================================================== */
+/* INDENT OFF */
+/*
+ * Function name:
+ * frameOfReferenceChanged
+ * 
+ * Purpose:
+ * Called after the frame of reference has been written, so that the
+ * guide loop recompiles the conversions which depend on it
+ *
+ * Invocation:
+ * frameOfReferenceChanged ()
+ *
+ * Parameters in:
+ * None
+ *
+ * Parameters out:
+ * None
+ * 
+ * Return value:
+ * None
+ *
+ * Globals: 
+ *  External functions:
+ *  None
+ * 
+ *  External variables:
+ *      < frameRevision    int     incremented
+ * 
+ * Requirements:
+ * 
+ * 
+ * Author:
+ * 
+ * History:
+ * 17-Oct-2026: Original
+ *
+ */
+
+/* INDENT ON */
+
+/* ===================================================================== */
+
+void frameOfReferenceChanged (void)
+{
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicIncrIntT(&frameRevision);
+}
+
 /* ===================================================================== */
 /* INDENT OFF */
 /*
@@ -1515,6 +1842,7 @@ int  modifyFrame
  * 
  * History:
  * 25-Nov-1998: Original(srp)
+ * 17-Oct-2026: Copy the frame with readFrame
  *
  */
 
@@ -1524,7 +1852,8 @@ int  modifyFrame
 
 int   showFrame (int source)
 {
-    frameChange grab, *f;
+    frameData grab;
+    frameChange *f;
 
     if(source < PWFS1 || source > GYRO)
     {
@@ -1534,21 +1863,16 @@ int   showFrame (int source)
 
     f = ag2m2[source];
 
-    /* access frame */
-
-    if(epicsMutexTryLock(f->access) == OK)
-    {
-        /* copy the frame contents */
-
-        grab = *f;
-        epicsMutexUnlock(f->access);
-    }
-    else
+    if (f == NULL)
     {
-        errlogMessage("showFrame - unable to get mutex for conversion frame\n");
+        errlogMessage("showFrame - conversion frame not initialised\n");
         return(ERROR);
     }
 
+    /* copy the frame contents */
+
+    readFrame(f, &grab);
+
     printf("conversion data for source %d\n", source);
     printf("angle (rads)            = %f\n", grab.theta);
     printf("angle (degrees)         = %f\n", (grab.theta/DEGS2RADS));
@@ -30,6 +30,10 @@
  *              Moved flagOutReg to chopControl.h since not part of 
  *              utilities.c
  * 19-Oct-2017: Begin conversion to EPICS OSI (mdw)
+ * 17-Oct-2026: frameChange double buffered for lock free reads
+ * 17-Oct-2026: Added frameOfReferenceChanged and frameRevision
+ * 17-Oct-2026: Added monotonicNow
+ * 17-Oct-2026: Added checkSumFast and checkSumSet setters
  *
  */
 /* ===================================================================== */
@@ -306,6 +310,20 @@ typedef struct
         double  scaleX;
         double  scaleY;
         double  scaleZ;
+
+}frameData;
+
+/* Conversion frame shared between modifyFrame and the guide loop. The
+ * writer fills the frame not in use and then publishes it by switching
+ * current, so readers never wait; sequence counts the updates so that a
+ * reader overtaken by two updates knows to read again (see readFrame).
+ * access only serialises writers. */
+
+typedef struct
+{
+        frameData frame[2];
+        int     current;        /* index of the published frame         */
+        int     sequence;       /* incremented by every update          */
         // SEM_ID  access;
         epicsMutexId  access;
 
@@ -329,6 +347,14 @@ int gyro2m2(location *position);
 
 long checkSum(void *ptr, int numLongs);
 
+long checkSumFast(const void *ptr, int numLongs);
+
+void checkSumSet(long *sum, void *field, const void *value, int size);
+
+void checkSumSetLong(long *sum, long *field, long value);
+
+void checkSumSetFloat(long *sum, float *field, float value);
+
 int date2secs(char * dateString);  /* used only in archive.c */
 
 char* weight2string(double weightA, double weightB, double weightC);
@@ -345,6 +371,8 @@ int loadInitFiles(void *);
 
 double confine(double value, double upper, double lower);
 
+double monotonicNow(void);
+
 int setPid(int axis, double P, double I, double D, 
            double windUpLimit, double rateLimit);
 
@@ -359,6 +387,10 @@ int  modifyFrame
         const double offsetY
         );
 
+void readFrame(const frameChange *f, frameData *grab);
+
+void frameOfReferenceChanged(void);
+
 long stateInit (struct subRecord * psub);
 
 long scsStateStringInit (struct genSubRecord * pgsub);
@@ -370,6 +402,7 @@ long driveEvent (struct subRecord * psub);
 extern int debugLevel;
 extern long inPosition;
 extern frameChange *ag2m2[MAX_SOURCES];
+extern int frameRevision;
 
 /* not used anywhere. 20171019 MDW */
 //extern SEM_ID compileStatus;